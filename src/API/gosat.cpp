@@ -0,0 +1,242 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "gosat.h"
+#include "Solver/FPSolver.h"
+#include "llvm/Support/ManagedStatic.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+struct gosat_solver {
+    explicit gosat_solver(const gosat::SolverOptions& options) :
+            Solver{options},
+            FormulaCount{0}
+    {}
+
+    gosat::FPSolver Solver;
+    /// context owning parsed and translated formulas
+    z3::context SMTCtx;
+    unsigned long FormulaCount;
+};
+
+namespace {
+
+bool toSolverOptions(const gosat_options& options,
+                     gosat::SolverOptions* solver_options)
+{
+    using namespace gosat;
+    static const goSATAlgorithm algorithms[] = {
+            kCRS2, kISRES, kMLSL, kDirect, kPortfolio, kIslands, kPartition,
+            kBasinHopping, kCMAES, kULPSearch};
+    const auto alg_idx = static_cast<unsigned>(options.algorithm);
+    if (alg_idx >= sizeof(algorithms) / sizeof(algorithms[0]) ||
+        options.opt_level > 3 || !(options.timeout >= 0)) {
+        return false;
+    }
+    solver_options->Algorithm = algorithms[alg_idx];
+    solver_options->ThreadCount = options.thread_count;
+    solver_options->OptLevel = options.opt_level;
+    solver_options->Timeout = options.timeout;
+    solver_options->ValidateModel = options.validate_model != 0;
+    solver_options->UseTieredExecution = options.use_tiered_execution != 0;
+    solver_options->SplitComponents = options.split_components != 0;
+    solver_options->InferBounds = options.infer_bounds != 0;
+    solver_options->EliminateVars = options.eliminate_vars != 0;
+    solver_options->UseResultCache = options.use_result_cache != 0;
+    if (options.cache_dir != nullptr) {
+        solver_options->CacheDir = options.cache_dir;
+    }
+    if (options.presolve_stages != nullptr &&
+        options.presolve_stages[0] != '\0') {
+        return FPExprPresolver::parseStages(options.presolve_stages,
+                                            &solver_options->PresolveStages);
+    }
+    return true;
+}
+
+gosat_error toResult(const gosat::SolverResult& solver_result,
+                     gosat_result* result)
+{
+    double* model = nullptr;
+    if (!solver_result.Model.empty()) {
+        model = static_cast<double*>(
+                std::malloc(solver_result.Model.size() * sizeof(double)));
+        if (model == nullptr) {
+            return GOSAT_ERROR_OUT_OF_MEMORY;
+        }
+        std::memcpy(model, solver_result.Model.data(),
+                    solver_result.Model.size() * sizeof(double));
+    }
+    if (solver_result.HasUnsupportedExpr) {
+        result->status = GOSAT_UNSUPPORTED;
+    } else {
+        result->status = solver_result.IsSat ? GOSAT_SAT : GOSAT_UNKNOWN;
+    }
+    result->minima = solver_result.Minima;
+    result->elapsed_time = solver_result.ElapsedTime;
+    result->nlopt_status = solver_result.Status;
+    result->is_timed_out = solver_result.IsTimedOut;
+    result->is_model_valid = solver_result.IsModelValidated &&
+                             solver_result.IsModelValid;
+    result->model = model;
+    result->var_count = solver_result.Model.size();
+    return GOSAT_OK;
+}
+
+/// solves expr and converts exceptions to error codes
+gosat_error solveExpr(gosat_solver* solver, const z3::expr& expr,
+                      gosat_result* result)
+{
+    try {
+        const std::string func_name =
+                "formula" + std::to_string(solver->FormulaCount++);
+        return toResult(solver->Solver.solve(expr, func_name), result);
+    } catch (const z3::exception&) {
+        return GOSAT_ERROR_Z3;
+    } catch (const std::bad_alloc&) {
+        return GOSAT_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        return GOSAT_ERROR_INTERNAL;
+    }
+}
+}
+
+extern "C" {
+
+void gosat_options_init(gosat_options* options)
+{
+    if (options == nullptr) {
+        return;
+    }
+    const gosat::SolverOptions defaults;
+    options->algorithm = GOSAT_ALG_CRS2;
+    options->thread_count = defaults.ThreadCount;
+    options->opt_level = defaults.OptLevel;
+    options->timeout = defaults.Timeout;
+    options->validate_model = defaults.ValidateModel;
+    options->use_tiered_execution = defaults.UseTieredExecution;
+    options->split_components = defaults.SplitComponents;
+    options->infer_bounds = defaults.InferBounds;
+    options->eliminate_vars = defaults.EliminateVars;
+    options->presolve_stages = nullptr;
+    options->cache_dir = nullptr;
+    options->use_result_cache = defaults.UseResultCache;
+}
+
+gosat_error gosat_solver_create(const gosat_options* options,
+                                gosat_solver** solver)
+{
+    if (options == nullptr || solver == nullptr) {
+        return GOSAT_ERROR_INVALID_ARGUMENT;
+    }
+    *solver = nullptr;
+    gosat::SolverOptions solver_options;
+    try {
+        if (!toSolverOptions(*options, &solver_options)) {
+            return GOSAT_ERROR_INVALID_ARGUMENT;
+        }
+        gosat::FPSolver::initializeNativeTarget();
+        *solver = new gosat_solver(solver_options);
+    } catch (const z3::exception&) {
+        return GOSAT_ERROR_Z3;
+    } catch (const std::bad_alloc&) {
+        return GOSAT_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        return GOSAT_ERROR_INTERNAL;
+    }
+    return GOSAT_OK;
+}
+
+void gosat_solver_destroy(gosat_solver* solver)
+{
+    delete solver;
+}
+
+gosat_error gosat_solve_string(gosat_solver* solver, const char* smt_str,
+                               gosat_result* result)
+{
+    if (solver == nullptr || smt_str == nullptr || result == nullptr) {
+        return GOSAT_ERROR_INVALID_ARGUMENT;
+    }
+    std::memset(result, 0, sizeof(gosat_result));
+    try {
+        const z3::expr expr = solver->SMTCtx.parse_string(smt_str);
+        return solveExpr(solver, expr, result);
+    } catch (const z3::exception&) {
+        return GOSAT_ERROR_Z3;
+    } catch (const std::bad_alloc&) {
+        return GOSAT_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+gosat_error gosat_solve_ast(gosat_solver* solver, Z3_context ctx,
+                            Z3_ast formula, gosat_result* result)
+{
+    if (solver == nullptr || ctx == nullptr || formula == nullptr ||
+        result == nullptr) {
+        return GOSAT_ERROR_INVALID_ARGUMENT;
+    }
+    std::memset(result, 0, sizeof(gosat_result));
+    if (ctx == static_cast<Z3_context>(solver->SMTCtx)) {
+        return GOSAT_ERROR_INVALID_ARGUMENT;
+    }
+    if (Z3_get_sort_kind(ctx, Z3_get_sort(ctx, formula)) != Z3_BOOL_SORT) {
+        return GOSAT_ERROR_INVALID_ARGUMENT;
+    }
+    try {
+        // the objective is generated from an expression of a context the
+        // solver owns, the caller keeps using its context meanwhile
+        Z3_ast translated = Z3_translate(ctx, formula, solver->SMTCtx);
+        if (translated == nullptr) {
+            return GOSAT_ERROR_Z3;
+        }
+        const z3::expr expr(solver->SMTCtx, translated);
+        return solveExpr(solver, expr, result);
+    } catch (const z3::exception&) {
+        return GOSAT_ERROR_Z3;
+    } catch (const std::bad_alloc&) {
+        return GOSAT_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+void gosat_result_free(gosat_result* result)
+{
+    if (result == nullptr) {
+        return;
+    }
+    std::free(result->model);
+    result->model = nullptr;
+    result->var_count = 0;
+}
+
+const char* gosat_error_string(gosat_error error)
+{
+    switch (error) {
+        case GOSAT_OK:
+            return "ok";
+        case GOSAT_ERROR_INVALID_ARGUMENT:
+            return "invalid argument";
+        case GOSAT_ERROR_Z3:
+            return "z3 error";
+        case GOSAT_ERROR_OUT_OF_MEMORY:
+            return "out of memory";
+        case GOSAT_ERROR_INTERNAL:
+            return "internal error";
+    }
+    return "unknown error";
+}
+
+void gosat_shutdown(void)
+{
+    gosat::FPSolver::waitForBackgroundCompilations();
+    llvm::llvm_shutdown();
+    Z3_finalize_memory();
+}
+}
@@ -0,0 +1,142 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+/**
+ * /brief C interface of libgosat, which solves formulas in-process.
+ *
+ * Functions report failures by error codes and never terminate the process.
+ * A solver handle keeps its options and a z3 context for parsing, hence, a
+ * handle must not be used by several threads at once. Use a handle per
+ * thread instead.
+ */
+
+#ifndef GOSAT_API_H
+#define GOSAT_API_H
+
+#include "z3.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GOSAT_OK = 0,
+    GOSAT_ERROR_INVALID_ARGUMENT,
+    /// the SMT-LIB string is malformed or z3 failed otherwise
+    GOSAT_ERROR_Z3,
+    GOSAT_ERROR_OUT_OF_MEMORY,
+    GOSAT_ERROR_INTERNAL
+} gosat_error;
+
+typedef enum {
+    GOSAT_SAT = 0,
+    GOSAT_UNKNOWN,
+    /// the formula uses expressions the objective can not encode
+    GOSAT_UNSUPPORTED
+} gosat_status;
+
+typedef enum {
+    GOSAT_ALG_CRS2 = 0,
+    GOSAT_ALG_ISRES,
+    GOSAT_ALG_MLSL,
+    GOSAT_ALG_DIRECT,
+    GOSAT_ALG_PORTFOLIO,
+    GOSAT_ALG_ISLANDS,
+    GOSAT_ALG_PARTITION,
+    GOSAT_ALG_BASIN_HOPPING,
+    GOSAT_ALG_CMAES,
+    GOSAT_ALG_ULP_SEARCH
+} gosat_algorithm;
+
+typedef struct {
+    gosat_algorithm algorithm;
+    /// worker threads of parallel algorithms, zero uses core count
+    unsigned thread_count;
+    /// LLVM optimization level of the objective, at most 3
+    unsigned opt_level;
+    /// wall-clock budget in seconds of a formula, zero means no limit
+    double timeout;
+    /// nonzero options enable the features of the command-line flags
+    /// -c, -tiered, -split, -infer-bounds, and -elim-vars respectively
+    int validate_model;
+    int use_tiered_execution;
+    int split_components;
+    int infer_bounds;
+    int eliminate_vars;
+    /// comma-separated presolve stages, may be null
+    const char* presolve_stages;
+    /// directory of the object cache, null disables caching
+    const char* cache_dir;
+    /// nonzero reuses results of formulas equal up to renaming, which are
+    /// stored in cache_dir or the default cache directory
+    int use_result_cache;
+} gosat_options;
+
+typedef struct {
+    gosat_status status;
+    /// objective value of model, zero iff sat
+    double minima;
+    /// seconds spent in solving excluding parsing
+    double elapsed_time;
+    /// NLopt result code of the optimization
+    int nlopt_status;
+    /// nonzero if optimization stopped at the deadline
+    int is_timed_out;
+    /// nonzero if validation was requested and model satisfies the formula
+    int is_model_valid;
+    /// values of FP variables in order of first occurrence, owned by the
+    /// result and released by gosat_result_free
+    double* model;
+    size_t var_count;
+} gosat_result;
+
+typedef struct gosat_solver gosat_solver;
+
+/// sets the defaults of the command-line tool
+void gosat_options_init(gosat_options* options);
+
+gosat_error gosat_solver_create(const gosat_options* options,
+                                gosat_solver** solver);
+
+void gosat_solver_destroy(gosat_solver* solver);
+
+/**
+ * /brief solves the conjunction of assertions of an SMT-LIB string.
+ * result must be released by gosat_result_free if GOSAT_OK is returned.
+ */
+gosat_error gosat_solve_string(gosat_solver* solver, const char* smt_str,
+                               gosat_result* result);
+
+/**
+ * /brief solves a Boolean term of a caller-owned z3 context, which is
+ * translated to the context of solver first.
+ * result must be released by gosat_result_free if GOSAT_OK is returned.
+ */
+gosat_error gosat_solve_ast(gosat_solver* solver, Z3_context ctx,
+                            Z3_ast formula, gosat_result* result);
+
+void gosat_result_free(gosat_result* result);
+
+const char* gosat_error_string(gosat_error error);
+
+/**
+ * /brief releases the global state of LLVM and z3 after waiting for
+ * background compilations. The library does not release it on exit since
+ * the embedding process may use LLVM or z3 itself. Must be called at most
+ * once after all solvers are destroyed, no other function may be called
+ * afterwards.
+ */
+void gosat_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GOSAT_API_H
@@ -18,11 +18,16 @@ namespace gosat {
 class CodeGenStr {
 public:
     static const std::string kFunName;
+    static const std::string kBatchFunName;
+    static const std::string kIncFunName;
     static const std::string kFunInput;
     static const std::string kFunDis;
     static const std::string kFunEqDis;
     static const std::string kFunNEqDis;
     static const std::string kFunIsNan;
+    /// changes whenever generated code changes for the same formula, hence,
+    /// cached objects and results are keyed by it
+    static const std::string kCodeGenVersion;
 };
 
 enum class SymbolKind : unsigned {
@@ -9,6 +9,7 @@
 
 #include "FPExprAnalyzer.h"
 #include "Utils/FPAUtils.h"
+#include <unordered_set>
 
 namespace gosat {
 
@@ -106,4 +107,35 @@ void FPExprAnalyzer::prettyPrintSummary(
               << std::string((m_has_unsupported_expr) ? "yes" : "no")
               << ")\n";
 }
+
+unsigned FPExprAnalyzer::countNodes(const z3::expr& expr) noexcept
+{
+    std::unordered_set<unsigned> visited;
+    std::vector<z3::expr> stack;
+    stack.push_back(expr);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        if (!visited.insert(Z3_get_ast_id(cur_expr.ctx(), cur_expr)).second ||
+            !cur_expr.is_app()) {
+            continue;
+        }
+        for (unsigned i = 0; i < cur_expr.num_args(); ++i) {
+            stack.push_back(cur_expr.arg(i));
+        }
+    }
+    return static_cast<unsigned>(visited.size());
+}
+
+void FPExprAnalyzer::prettyPrintPresolveSummary
+        (const std::vector<PresolveStageResult>& stage_results) noexcept
+{
+    for (const auto& stage_result : stage_results) {
+        std::cout << "Presolve stage "
+                  << FPExprPresolver::getStageName(stage_result.Stage)
+                  << " (" << stage_result.NodeCountBefore << " -> "
+                  << stage_result.NodeCountAfter << " nodes, "
+                  << stage_result.Time << "s)\n";
+    }
+}
 }
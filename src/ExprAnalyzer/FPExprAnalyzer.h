@@ -9,8 +9,10 @@
 
 #pragma once
 
+#include "ExprAnalyzer/FPExprPresolver.h"
 #include "z3++.h"
 #include <unordered_map>
+#include <vector>
 
 namespace gosat {
 
@@ -35,6 +37,13 @@ public:
 
     void prettyPrintSummary(const std::string& formula_name) const noexcept;
 
+    /// number of distinct nodes of the DAG of expr
+    static unsigned countNodes(const z3::expr& expr) noexcept;
+
+    /// prints time and node count reduction of each presolve stage
+    static void prettyPrintPresolveSummary
+            (const std::vector<PresolveStageResult>& stage_results) noexcept;
+
 public:
     uint m_float_var_count;
     uint m_double_var_count;
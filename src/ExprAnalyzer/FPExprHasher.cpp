@@ -0,0 +1,111 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPExprHasher.h"
+#include <vector>
+
+namespace gosat {
+
+FPExprHasher::FPExprHasher() :
+        m_is_renaming_invariant{false},
+        m_const_count{0}
+{}
+
+FPExprHasher::FPExprHasher(bool is_renaming_invariant) :
+        m_is_renaming_invariant{is_renaming_invariant},
+        m_const_count{0}
+{}
+
+uint64_t FPExprHasher::hashString(const std::string& str) noexcept
+{
+    // 64-bit FNV-1a
+    uint64_t result = 0xcbf29ce484222325;
+    for (const auto ch : str) {
+        result ^= static_cast<unsigned char>(ch);
+        result *= 0x100000001b3;
+    }
+    return result;
+}
+
+uint64_t FPExprHasher::combine(uint64_t seed, uint64_t value) noexcept
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
+std::string FPExprHasher::toHexString(uint64_t value)
+{
+    const char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; --i, value >>= 4) {
+        result[i] = digits[value & 0xF];
+    }
+    return result;
+}
+
+uint64_t FPExprHasher::hashSort(const z3::sort& sort) noexcept
+{
+    uint64_t result = combine(0, sort.sort_kind());
+    if (sort.sort_kind() == Z3_FLOATING_POINT_SORT) {
+        result = combine(result, Z3_fpa_get_ebits(sort.ctx(), sort));
+        result = combine(result, Z3_fpa_get_sbits(sort.ctx(), sort));
+    } else if (sort.sort_kind() == Z3_BV_SORT) {
+        result = combine(result, sort.bv_size());
+    }
+    return result;
+}
+
+uint64_t FPExprHasher::hashNode(const z3::expr& expr) noexcept
+{
+    if (!expr.is_app()) {
+        return hashString(Z3_ast_to_string(expr.ctx(), expr));
+    }
+    uint64_t result = combine(expr.decl().decl_kind(), hashSort(expr.get_sort()));
+    if (expr.is_numeral()) {
+        return combine(result,
+                       hashString(Z3_ast_to_string(expr.ctx(), expr)));
+    }
+    if (expr.decl().decl_kind() == Z3_OP_UNINTERPRETED) {
+        if (m_is_renaming_invariant && expr.num_args() == 0) {
+            // nodes are hashed once, in order of first occurrence
+            return combine(result, m_const_count++);
+        }
+        result = combine(result, hashString(expr.decl().name().str()));
+    }
+    for (unsigned i = 0; i < expr.num_args(); ++i) {
+        result = combine(result, m_node_hash_map[Z3_get_ast_id
+                (expr.ctx(), expr.arg(i))]);
+    }
+    return result;
+}
+
+uint64_t FPExprHasher::hash(const z3::expr& expr) noexcept
+{
+    // explicit post-order traversal, formulas can be too deep for recursion
+    std::vector<std::pair<z3::expr, bool>> stack;
+    stack.emplace_back(std::make_pair(expr, false));
+    while (!stack.empty()) {
+        auto cur_pair = stack.back();
+        stack.pop_back();
+        const z3::expr& cur_expr = cur_pair.first;
+        unsigned id = Z3_get_ast_id(cur_expr.ctx(), cur_expr);
+        if (m_node_hash_map.find(id) != m_node_hash_map.cend()) {
+            continue;
+        }
+        if (cur_pair.second || !cur_expr.is_app() || cur_expr.is_numeral()) {
+            m_node_hash_map[id] = hashNode(cur_expr);
+            continue;
+        }
+        stack.emplace_back(std::make_pair(cur_expr, true));
+        for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+            stack.emplace_back(std::make_pair(cur_expr.arg(i - 1), false));
+        }
+    }
+    return m_node_hash_map[Z3_get_ast_id(expr.ctx(), expr)];
+}
+}
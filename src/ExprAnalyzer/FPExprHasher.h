@@ -0,0 +1,63 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "z3++.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace gosat {
+
+/**
+ * /brief Computes a 64-bit structural hash of an expression DAG.
+ *
+ * Unlike z3::expr::hash(), the result is stable across processes and
+ * z3 contexts, so it can be used as a key of persistent caches.
+ *
+ * A renaming-invariant hasher hashes a constant by its sort and the index
+ * of its first occurrence in a left-to-right traversal instead of its name.
+ * This is the variable order of FPIRGenerator, hence, formulas equal up to
+ * renaming of constants have equal hashes and models in the same order.
+ */
+class FPExprHasher {
+public:
+    FPExprHasher();
+
+    explicit FPExprHasher(bool is_renaming_invariant);
+
+    virtual ~FPExprHasher() = default;
+
+    FPExprHasher(const FPExprHasher&) = default;
+
+    FPExprHasher& operator=(const FPExprHasher&) = default;
+
+    FPExprHasher& operator=(FPExprHasher&&) = default;
+
+    uint64_t hash(const z3::expr& expr) noexcept;
+
+    static uint64_t hashString(const std::string& str) noexcept;
+
+    static uint64_t combine(uint64_t seed, uint64_t value) noexcept;
+
+    static std::string toHexString(uint64_t value);
+
+private:
+    uint64_t hashNode(const z3::expr& expr) noexcept;
+
+    uint64_t hashSort(const z3::sort& sort) noexcept;
+
+private:
+    bool m_is_renaming_invariant;
+    /// constants hashed so far by a renaming-invariant hasher
+    unsigned m_const_count;
+    std::unordered_map<unsigned, uint64_t> m_node_hash_map;
+};
+}
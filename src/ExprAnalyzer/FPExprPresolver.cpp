@@ -0,0 +1,372 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPExprPresolver.h"
+#include "FPExprAnalyzer.h"
+#include "Utils/FPAUtils.h"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <unordered_set>
+
+namespace gosat {
+
+PresolveStageResult::PresolveStageResult() :
+        Stage{PresolveStage::kSimplify},
+        Time{0},
+        NodeCountBefore{0},
+        NodeCountAfter{0}
+{}
+
+FPExprPresolver::FPExprPresolver(const std::vector<PresolveStage>& stages) :
+        m_stages{stages}
+{}
+
+static inline unsigned getId(const z3::expr& expr)
+{
+    return Z3_get_ast_id(expr.ctx(), expr);
+}
+
+static inline bool isBoolConst(const z3::expr& expr, bool value)
+{
+    return expr.is_app() && expr.decl().decl_kind() ==
+                            ((value) ? Z3_OP_TRUE : Z3_OP_FALSE);
+}
+
+/// bit-wise equality as of smt-lib, i.e., nan equals nan and zeros differ
+template <typename T>
+static inline bool isIdentical(T a, T b) noexcept
+{
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b);
+    }
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+/// /returns false if the operation is not folded
+template <typename T>
+static bool foldFPOp(Z3_decl_kind kind, T a, T b, T* result) noexcept
+{
+    switch (kind) {
+        case Z3_OP_FPA_ADD: *result = a + b;
+            return true;
+        case Z3_OP_FPA_SUB: *result = a - b;
+            return true;
+        case Z3_OP_FPA_MUL: *result = a * b;
+            return true;
+        case Z3_OP_FPA_DIV: *result = a / b;
+            return true;
+        case Z3_OP_FPA_SQRT: *result = std::sqrt(a);
+            return true;
+        case Z3_OP_FPA_NEG: *result = -a;
+            return true;
+        case Z3_OP_FPA_ABS: *result = std::fabs(a);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// /returns -1 if the predicate is not folded
+template <typename T>
+static int foldFPPredicate(Z3_decl_kind kind, T a, T b) noexcept
+{
+    switch (kind) {
+        case Z3_OP_FPA_LT: return a < b;
+        case Z3_OP_FPA_LE: return a <= b;
+        case Z3_OP_FPA_GT: return a > b;
+        case Z3_OP_FPA_GE: return a >= b;
+        case Z3_OP_FPA_EQ: return a == b;
+        case Z3_OP_EQ: return isIdentical(a, b);
+        case Z3_OP_FPA_IS_NAN: return std::isnan(a);
+        case Z3_OP_FPA_IS_INF: return std::isinf(a);
+        case Z3_OP_FPA_IS_ZERO: return a == 0;
+        case Z3_OP_FPA_IS_NEGATIVE: return !std::isnan(a) && std::signbit(a);
+        case Z3_OP_FPA_IS_POSITIVE: return !std::isnan(a) && !std::signbit(a);
+        default:
+            return -1;
+    }
+}
+
+z3::expr FPExprPresolver::genFPConst(const z3::sort& sort, double value)
+{
+    if (std::isnan(value)) {
+        return z3::to_expr(sort.ctx(), Z3_mk_fpa_nan(sort.ctx(), sort));
+    }
+    if (fpa_util::isFloat32(Z3_fpa_get_ebits(sort.ctx(), sort),
+                            Z3_fpa_get_sbits(sort.ctx(), sort))) {
+        return z3::to_expr(sort.ctx(), Z3_mk_fpa_numeral_float(
+                sort.ctx(), static_cast<float>(value), sort));
+    }
+    return z3::to_expr(sort.ctx(), Z3_mk_fpa_numeral_double(
+            sort.ctx(), value, sort));
+}
+
+z3::expr FPExprPresolver::foldApp(const z3::expr& expr)
+{
+    const auto kind = expr.decl().decl_kind();
+    if (kind == Z3_OP_NOT) {
+        const z3::expr arg = expr.arg(0);
+        if (isBoolConst(arg, true) || isBoolConst(arg, false)) {
+            return expr.ctx().bool_val(isBoolConst(arg, false));
+        }
+        if (arg.is_app() && arg.decl().decl_kind() == Z3_OP_NOT) {
+            return arg.arg(0);
+        }
+        return expr;
+    }
+    if (kind == Z3_OP_AND || kind == Z3_OP_OR) {
+        // true is the unit of and, false is the unit of or
+        const bool unit = (kind == Z3_OP_AND);
+        z3::expr_vector args(expr.ctx());
+        std::unordered_set<unsigned> arg_ids;
+        for (unsigned i = 0; i < expr.num_args(); ++i) {
+            const z3::expr arg = expr.arg(i);
+            if (isBoolConst(arg, !unit)) {
+                return arg;
+            }
+            if (!isBoolConst(arg, unit) && arg_ids.insert(getId(arg)).second) {
+                args.push_back(arg);
+            }
+        }
+        if (args.size() == 0) {
+            return expr.ctx().bool_val(unit);
+        }
+        if (args.size() == 1) {
+            return args[0];
+        }
+        if (args.size() == expr.num_args()) {
+            return expr;
+        }
+        return (unit) ? z3::mk_and(args) : z3::mk_or(args);
+    }
+    // FP operations and predicates on numerals, rounding mode comes first
+    unsigned first_arg = 0;
+    if (expr.num_args() > 0 && fpa_util::isRoundingModeApp(expr.arg(0))) {
+        if (expr.arg(0).decl().decl_kind() !=
+            Z3_OP_FPA_RM_NEAREST_TIES_TO_EVEN) {
+            return expr;
+        }
+        first_arg = 1;
+    }
+    const unsigned arg_count = expr.num_args() - first_arg;
+    if (arg_count == 0 || arg_count > 2) {
+        return expr;
+    }
+    const z3::sort sort = expr.arg(first_arg).get_sort();
+    if (sort.sort_kind() != Z3_FLOATING_POINT_SORT) {
+        return expr;
+    }
+    const unsigned sigd = Z3_fpa_get_sbits(expr.ctx(), sort);
+    const unsigned expo = Z3_fpa_get_ebits(expr.ctx(), sort);
+    const bool is_float32 = fpa_util::isFloat32(expo, sigd);
+    if (!is_float32 && !fpa_util::isFloat64(expo, sigd)) {
+        return expr;
+    }
+    double values[2] = {0, 0};
+    for (unsigned i = 0; i < arg_count; ++i) {
+        const z3::expr arg = expr.arg(first_arg + i);
+        if (!fpa_util::isFPNumeral(arg)) {
+            return expr;
+        }
+        values[i] = (is_float32) ? fpa_util::toFloat32(arg) :
+                    fpa_util::toFloat64(arg);
+    }
+    if (expr.get_sort().is_bool()) {
+        const int result = (is_float32) ?
+                           foldFPPredicate(kind,
+                                           static_cast<float>(values[0]),
+                                           static_cast<float>(values[1])) :
+                           foldFPPredicate(kind, values[0], values[1]);
+        return (result < 0) ? expr : expr.ctx().bool_val(result == 1);
+    }
+    if (!Z3_is_eq_sort(expr.ctx(), expr.get_sort(), sort)) {
+        // conversions are left to z3
+        return expr;
+    }
+    if (is_float32) {
+        float result;
+        if (foldFPOp(kind, static_cast<float>(values[0]),
+                     static_cast<float>(values[1]), &result)) {
+            return genFPConst(sort, result);
+        }
+        return expr;
+    }
+    double result;
+    if (foldFPOp(kind, values[0], values[1], &result)) {
+        return genFPConst(sort, result);
+    }
+    return expr;
+}
+
+z3::expr FPExprPresolver::foldFPConsts(const z3::expr& expr)
+{
+    // explicit post-order traversal, arguments are folded before their users
+    m_folded_exprs.clear();
+    std::vector<std::pair<z3::expr, bool>> stack;
+    stack.emplace_back(std::make_pair(expr, false));
+    while (!stack.empty()) {
+        auto cur_pair = stack.back();
+        stack.pop_back();
+        const z3::expr& cur_expr = cur_pair.first;
+        const unsigned id = getId(cur_expr);
+        if (m_folded_exprs.find(id) != m_folded_exprs.cend()) {
+            continue;
+        }
+        if (!cur_expr.is_app() || cur_expr.num_args() == 0) {
+            m_folded_exprs.emplace(id, cur_expr);
+            continue;
+        }
+        if (!cur_pair.second) {
+            stack.emplace_back(std::make_pair(cur_expr, true));
+            for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+                stack.emplace_back(std::make_pair(cur_expr.arg(i - 1), false));
+            }
+            continue;
+        }
+        z3::expr_vector args(cur_expr.ctx());
+        bool is_changed = false;
+        for (unsigned i = 0; i < cur_expr.num_args(); ++i) {
+            const z3::expr arg = cur_expr.arg(i);
+            const z3::expr& folded_arg = m_folded_exprs.at(getId(arg));
+            is_changed = is_changed || (getId(folded_arg) != getId(arg));
+            args.push_back(folded_arg);
+        }
+        z3::expr app = (is_changed) ? cur_expr.decl()(args) : cur_expr;
+        m_folded_exprs.emplace(id, foldApp(app));
+    }
+    const z3::expr result = m_folded_exprs.at(getId(expr));
+    m_folded_exprs.clear();
+    return result;
+}
+
+z3::expr FPExprPresolver::applyTactic(const z3::expr& expr, const char* name)
+{
+    z3::goal goal(expr.ctx());
+    goal.add(expr);
+    z3::tactic tactic(expr.ctx(), name);
+    const z3::apply_result result = tactic(goal);
+    if (result.size() == 0) {
+        // no subgoal tells whether the tactic proved anything
+        return expr;
+    }
+    z3::expr_vector subgoals(expr.ctx());
+    for (unsigned i = 0; i < result.size(); ++i) {
+        if (!result[i].is_decided_unsat()) {
+            subgoals.push_back(result[i].as_expr());
+        }
+    }
+    if (subgoals.size() == 0) {
+        // every subgoal was proved unsatisfiable
+        return expr.ctx().bool_val(false);
+    }
+    if (subgoals.size() == 1) {
+        return subgoals[0];
+    }
+    return z3::mk_or(subgoals);
+}
+
+z3::expr FPExprPresolver::presolve(const z3::expr& expr)
+{
+    m_stage_results.clear();
+    m_vars.clear();
+    m_presolved_vars.clear();
+    fpa_util::collectFPVars(expr, &m_vars);
+    z3::expr result = expr;
+    for (const auto stage : m_stages) {
+        PresolveStageResult stage_result;
+        stage_result.Stage = stage;
+        stage_result.NodeCountBefore = FPExprAnalyzer::countNodes(result);
+        const auto time_start = std::chrono::steady_clock::now();
+        if (stage == PresolveStage::kFPFold) {
+            result = foldFPConsts(result);
+        } else {
+            result = applyTactic(result, getStageName(stage));
+        }
+        stage_result.Time = std::chrono::duration<double>
+                (std::chrono::steady_clock::now() - time_start).count();
+        stage_result.NodeCountAfter = FPExprAnalyzer::countNodes(result);
+        m_stage_results.push_back(stage_result);
+    }
+    fpa_util::collectFPVars(result, &m_presolved_vars);
+    return result;
+}
+
+const std::vector<PresolveStageResult>&
+FPExprPresolver::getStageResults() const noexcept
+{
+    return m_stage_results;
+}
+
+unsigned FPExprPresolver::getPresolvedVarCount() const noexcept
+{
+    return static_cast<unsigned>(m_presolved_vars.size());
+}
+
+std::vector<double> FPExprPresolver::reconstructModel
+        (const std::vector<double>& presolved_model) const
+{
+    assert(presolved_model.size() == m_presolved_vars.size() &&
+           "Model size mismatch!");
+    std::unordered_map<unsigned, double> values;
+    for (unsigned i = 0; i < m_presolved_vars.size(); ++i) {
+        values[getId(m_presolved_vars[i])] = presolved_model[i];
+    }
+    std::vector<double> result;
+    result.reserve(m_vars.size());
+    for (const auto& var : m_vars) {
+        const auto value_it = values.find(getId(var));
+        result.push_back((value_it == values.cend()) ? 0 : value_it->second);
+    }
+    return result;
+}
+
+const char* FPExprPresolver::getStageName(PresolveStage stage) noexcept
+{
+    switch (stage) {
+        case PresolveStage::kSimplify: return "simplify";
+        case PresolveStage::kPropagateValues: return "propagate-values";
+        case PresolveStage::kCtxSimplify: return "ctx-simplify";
+        case PresolveStage::kFPFold: return "fp-fold";
+    }
+    return "unknown";
+}
+
+bool FPExprPresolver::parseStages(const std::string& stages_str,
+                                  std::vector<PresolveStage>* stages)
+{
+    const PresolveStage all_stages[] = {PresolveStage::kSimplify,
+                                        PresolveStage::kPropagateValues,
+                                        PresolveStage::kCtxSimplify,
+                                        PresolveStage::kFPFold};
+    std::istringstream stream(stages_str);
+    std::string name;
+    while (std::getline(stream, name, ',')) {
+        if (name == "all") {
+            stages->insert(stages->end(), std::begin(all_stages),
+                           std::end(all_stages));
+            continue;
+        }
+        bool is_found = false;
+        for (const auto stage : all_stages) {
+            if (name == getStageName(stage)) {
+                stages->push_back(stage);
+                is_found = true;
+                break;
+            }
+        }
+        if (!is_found) {
+            return false;
+        }
+    }
+    return true;
+}
+}
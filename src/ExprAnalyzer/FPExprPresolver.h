@@ -0,0 +1,110 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "z3++.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gosat {
+
+enum class PresolveStage {
+    kSimplify,
+    kPropagateValues,
+    kCtxSimplify,
+    kFPFold
+};
+
+class PresolveStageResult {
+public:
+    PresolveStageResult();
+
+    virtual ~PresolveStageResult() = default;
+
+    PresolveStage Stage;
+    /// seconds spent in the stage
+    double Time;
+    /// DAG nodes of the formula before and after the stage
+    unsigned NodeCountBefore;
+    unsigned NodeCountAfter;
+};
+
+/**
+ * /brief Shrinks a formula by a pipeline of equivalence-preserving stages
+ * before IR generation.
+ *
+ * Stages simplify, propagate-values, and ctx-simplify apply the z3 tactics
+ * of the same name. Stage fp-fold evaluates FP operations on FP32 and FP64
+ * numerals using native arithmetic, which rounds to nearest even, hence,
+ * operations of other rounding modes are kept. It also folds comparisons of
+ * numerals and Boolean connectives of constants, and drops duplicated
+ * arguments of conjunctions and disjunctions.
+ */
+class FPExprPresolver {
+public:
+    FPExprPresolver() = delete;
+
+    explicit FPExprPresolver(const std::vector<PresolveStage>& stages);
+
+    virtual ~FPExprPresolver() = default;
+
+    FPExprPresolver(const FPExprPresolver&) = default;
+
+    FPExprPresolver& operator=(const FPExprPresolver&) = default;
+
+    FPExprPresolver& operator=(FPExprPresolver&&) = default;
+
+    /// /returns a formula equivalent to expr after running all stages
+    z3::expr presolve(const z3::expr& expr);
+
+    /// results of stages in order of the last call to presolve
+    const std::vector<PresolveStageResult>& getStageResults() const noexcept;
+
+    /// number of variables of the formula last presolved
+    unsigned getPresolvedVarCount() const noexcept;
+
+    /**
+     * /brief maps a model of the presolved formula, given in its variable
+     * order, to the variable order of the original formula. Variables which
+     * were simplified away are unconstrained and set to zero.
+     */
+    std::vector<double>
+    reconstructModel(const std::vector<double>& presolved_model) const;
+
+    static const char* getStageName(PresolveStage stage) noexcept;
+
+    /// parses comma-separated stage names, "all" selects every stage
+    static bool parseStages(const std::string& stages_str,
+                            std::vector<PresolveStage>* stages);
+
+private:
+    /**
+     * /brief disjunction of the subgoals left by tactic name, false only if
+     * all subgoals are decided unsat, and expr if none is left
+     */
+    static z3::expr applyTactic(const z3::expr& expr, const char* name);
+
+    z3::expr foldFPConsts(const z3::expr& expr);
+
+    /// folds an application whose arguments are folded already
+    static z3::expr foldApp(const z3::expr& expr);
+
+    static z3::expr genFPConst(const z3::sort& sort, double value);
+
+private:
+    std::vector<PresolveStage> m_stages;
+    std::vector<PresolveStageResult> m_stage_results;
+    std::vector<z3::expr> m_vars;
+    std::vector<z3::expr> m_presolved_vars;
+    /// folded expressions by z3 AST id
+    std::unordered_map<unsigned, z3::expr> m_folded_exprs;
+};
+}
@@ -0,0 +1,146 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPExprSplitter.h"
+#include "Utils/FPAUtils.h"
+
+namespace gosat {
+
+constexpr unsigned FPExprSplitter::kNoVar;
+
+std::vector<z3::expr> FPExprSplitter::getConjuncts(const z3::expr& expr)
+{
+    std::vector<z3::expr> result;
+    std::vector<z3::expr> stack;
+    stack.push_back(expr);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        if (cur_expr.is_app() &&
+            cur_expr.decl().decl_kind() == Z3_OP_AND) {
+            for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+                stack.push_back(cur_expr.arg(i - 1));
+            }
+        } else {
+            result.push_back(cur_expr);
+        }
+    }
+    return result;
+}
+
+unsigned FPExprSplitter::findRoot(unsigned var) noexcept
+{
+    while (m_parents[var] != var) {
+        // path halving
+        m_parents[var] = m_parents[m_parents[var]];
+        var = m_parents[var];
+    }
+    return var;
+}
+
+unsigned FPExprSplitter::collectVars(const z3::expr& expr)
+{
+    // explicit post-order traversal visiting arguments left to right,
+    // hence, leaves are reached in the order of FPIRGenerator
+    std::vector<std::pair<z3::expr, bool>> stack;
+    stack.emplace_back(std::make_pair(expr, false));
+    while (!stack.empty()) {
+        auto cur_pair = stack.back();
+        stack.pop_back();
+        const z3::expr& cur_expr = cur_pair.first;
+        const unsigned id = Z3_get_ast_id(cur_expr.ctx(), cur_expr);
+        if (m_expr_vars.find(id) != m_expr_vars.cend()) {
+            continue;
+        }
+        if (!cur_expr.is_app() || cur_expr.is_numeral()) {
+            m_expr_vars[id] = kNoVar;
+            continue;
+        }
+        if (fpa_util::isFPVar(cur_expr)) {
+            const auto var = static_cast<unsigned>(m_parents.size());
+            m_parents.push_back(var);
+            m_expr_vars[id] = var;
+            continue;
+        }
+        if (!cur_pair.second) {
+            stack.emplace_back(std::make_pair(cur_expr, true));
+            for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+                stack.emplace_back(std::make_pair(cur_expr.arg(i - 1), false));
+            }
+            continue;
+        }
+        unsigned result = kNoVar;
+        for (unsigned i = 0; i < cur_expr.num_args(); ++i) {
+            const unsigned var = m_expr_vars[Z3_get_ast_id
+                    (cur_expr.ctx(), cur_expr.arg(i))];
+            if (var == kNoVar) {
+                continue;
+            }
+            if (result == kNoVar) {
+                result = var;
+            } else {
+                m_parents[findRoot(var)] = findRoot(result);
+            }
+        }
+        m_expr_vars[id] = result;
+    }
+    return m_expr_vars[Z3_get_ast_id(expr.ctx(), expr)];
+}
+
+std::vector<FPExprComponent> FPExprSplitter::split(const z3::expr& expr)
+{
+    m_expr_vars.clear();
+    m_parents.clear();
+    const auto conjuncts = getConjuncts(expr);
+    std::vector<unsigned> conjunct_vars;
+    conjunct_vars.reserve(conjuncts.size());
+    for (const auto& conjunct : conjuncts) {
+        conjunct_vars.push_back(collectVars(conjunct));
+    }
+    // components are numbered by their first conjunct
+    std::unordered_map<unsigned, unsigned> component_ids;
+    for (const auto var : conjunct_vars) {
+        if (var != kNoVar) {
+            component_ids.emplace(findRoot(var),
+                                  static_cast<unsigned>(component_ids.size()));
+        }
+    }
+    std::vector<FPExprComponent> result;
+    if (component_ids.size() < 2) {
+        result.push_back(FPExprComponent{expr, {}});
+        for (unsigned var = 0; var < getVarCount(); ++var) {
+            result.back().VarIds.push_back(var);
+        }
+        return result;
+    }
+    std::vector<z3::expr_vector> component_conjuncts;
+    for (unsigned i = 0; i < component_ids.size(); ++i) {
+        component_conjuncts.emplace_back(expr.ctx());
+    }
+    for (unsigned i = 0; i < conjuncts.size(); ++i) {
+        const unsigned component_id = (conjunct_vars[i] == kNoVar) ? 0 :
+                component_ids[findRoot(conjunct_vars[i])];
+        component_conjuncts[component_id].push_back(conjuncts[i]);
+    }
+    for (const auto& conjunct_vec : component_conjuncts) {
+        result.push_back(FPExprComponent{
+                (conjunct_vec.size() == 1) ? conjunct_vec[0] :
+                z3::mk_and(conjunct_vec), {}});
+    }
+    for (unsigned var = 0; var < getVarCount(); ++var) {
+        result[component_ids[findRoot(var)]].VarIds.push_back(var);
+    }
+    return result;
+}
+
+unsigned FPExprSplitter::getVarCount() const noexcept
+{
+    return static_cast<unsigned>(m_parents.size());
+}
+}
@@ -0,0 +1,77 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "z3++.h"
+#include <unordered_map>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Conjuncts of a formula sharing variables only among themselves
+ */
+struct FPExprComponent {
+    z3::expr Expr;
+    /// variables in the order of the whole formula, which is also the order
+    /// FPIRGenerator assigns to the variables of Expr
+    std::vector<unsigned> VarIds;
+};
+
+/**
+ * /brief Splits a top-level conjunction into variable-disjoint components,
+ * i.e., connected components of the graph linking conjuncts to their
+ * variables.
+ *
+ * Variables are numbered in the order FPIRGenerator would number them for
+ * the whole formula, i.e., by first occurrence in a left-to-right
+ * depth-first traversal. Conjuncts without variables are added to the first
+ * component.
+ */
+class FPExprSplitter {
+public:
+    FPExprSplitter() = default;
+
+    virtual ~FPExprSplitter() = default;
+
+    FPExprSplitter(const FPExprSplitter&) = default;
+
+    FPExprSplitter& operator=(const FPExprSplitter&) = default;
+
+    FPExprSplitter& operator=(FPExprSplitter&&) = default;
+
+    /// components in order of their first conjunct, a formula which
+    /// does not split yields a single component
+    std::vector<FPExprComponent> split(const z3::expr& expr);
+
+    /// number of variables of the formula last split
+    unsigned getVarCount() const noexcept;
+
+private:
+    /// flattens nested conjunctions in order
+    static std::vector<z3::expr> getConjuncts(const z3::expr& expr);
+
+    /**
+     * /brief numbers new variables of expr and unites all its variables
+     * /returns one of its variables, or kNoVar if it has none
+     */
+    unsigned collectVars(const z3::expr& expr);
+
+    unsigned findRoot(unsigned var) noexcept;
+
+    static constexpr unsigned kNoVar = ~0u;
+
+private:
+    /// a variable of each visited expression by z3 AST id
+    std::unordered_map<unsigned, unsigned> m_expr_vars;
+    /// union-find forest over variables
+    std::vector<unsigned> m_parents;
+};
+}
@@ -0,0 +1,513 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPIntervalAnalyzer.h"
+#include "Utils/FPAUtils.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace gosat {
+
+constexpr unsigned FPIntervalAnalyzer::kMaxRounds;
+
+/// rounds down by two ULPs, which covers rounding of any rounding mode
+static inline double roundDown(double value) noexcept
+{
+    if (std::isnan(value)) {
+        return -INFINITY;
+    }
+    return std::nextafter(std::nextafter(value, -INFINITY), -INFINITY);
+}
+
+static inline double roundUp(double value) noexcept
+{
+    if (std::isnan(value)) {
+        return INFINITY;
+    }
+    return std::nextafter(std::nextafter(value, INFINITY), INFINITY);
+}
+
+/// widens an interval to cover rounding to float
+static inline void roundToFloat(double* lower, double* upper) noexcept
+{
+    *lower = std::nextafter(static_cast<float>(*lower), -INFINITY);
+    *upper = std::nextafter(static_cast<float>(*upper), INFINITY);
+}
+
+static inline bool isInfinite(double lower, double upper) noexcept
+{
+    return std::isinf(lower) || std::isinf(upper);
+}
+
+static inline bool isEmpty(double lower, double upper) noexcept
+{
+    return !(lower <= upper);
+}
+
+static inline bool containsZero(double lower, double upper) noexcept
+{
+    return lower <= 0 && upper >= 0;
+}
+
+/// hull of the four products or quotients of interval bounds
+template <typename Op>
+static inline void
+combineBounds(double a_lower, double a_upper, double b_lower, double b_upper,
+              Op op, double* lower, double* upper) noexcept
+{
+    const double values[] = {op(a_lower, b_lower), op(a_lower, b_upper),
+                             op(a_upper, b_lower), op(a_upper, b_upper)};
+    *lower = INFINITY;
+    *upper = -INFINITY;
+    for (const auto value : values) {
+        if (std::isnan(value)) {
+            // 0 * inf or inf / inf
+            *lower = -INFINITY;
+            *upper = INFINITY;
+            return;
+        }
+        *lower = std::min(*lower, value);
+        *upper = std::max(*upper, value);
+    }
+    *lower = roundDown(*lower);
+    *upper = roundUp(*upper);
+}
+
+static inline double mul(double a, double b) noexcept
+{
+    return a * b;
+}
+
+static inline double div(double a, double b) noexcept
+{
+    return a / b;
+}
+
+FPIntervalAnalyzer::FPIntervalAnalyzer() :
+        m_is_changed{false}
+{}
+
+void FPIntervalAnalyzer::numberVars(const z3::expr& expr)
+{
+    // leaves are reached left to right as in FPIRGenerator
+    std::unordered_map<unsigned, bool> visited;
+    std::vector<z3::expr> stack;
+    stack.push_back(expr);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        const unsigned id = Z3_get_ast_id(cur_expr.ctx(), cur_expr);
+        if (!cur_expr.is_app() || visited[id]) {
+            continue;
+        }
+        visited[id] = true;
+        if (fpa_util::isFPVar(cur_expr)) {
+            const auto var = static_cast<unsigned>(m_var_ids.size());
+            m_var_ids[id] = var;
+            const double limit = fpa_util::isFloat32VarDecl(cur_expr) ?
+                                 FLT_MAX : DBL_MAX;
+            m_lower_bounds.push_back(-limit);
+            m_upper_bounds.push_back(limit);
+            continue;
+        }
+        for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+            stack.push_back(cur_expr.arg(i - 1));
+        }
+    }
+}
+
+void FPIntervalAnalyzer::collectAtoms
+        (const z3::expr& expr, std::vector<Atom>* atoms) const
+{
+    // conjuncts are found by pushing negation through not, and, and or
+    std::vector<std::pair<z3::expr, bool>> stack;
+    stack.emplace_back(std::make_pair(expr, false));
+    while (!stack.empty()) {
+        const auto cur_pair = stack.back();
+        stack.pop_back();
+        const z3::expr& cur_expr = cur_pair.first;
+        const bool is_negated = cur_pair.second;
+        if (!cur_expr.is_app()) {
+            continue;
+        }
+        auto kind = cur_expr.decl().decl_kind();
+        if (kind == Z3_OP_NOT) {
+            stack.emplace_back(std::make_pair(cur_expr.arg(0), !is_negated));
+            continue;
+        }
+        if ((kind == Z3_OP_AND && !is_negated) ||
+            (kind == Z3_OP_OR && is_negated)) {
+            for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+                stack.emplace_back(std::make_pair(cur_expr.arg(i - 1),
+                                                  is_negated));
+            }
+            continue;
+        }
+        if (cur_expr.num_args() != 2 ||
+            cur_expr.arg(0).get_sort().sort_kind() !=
+            Z3_FLOATING_POINT_SORT) {
+            continue;
+        }
+        const bool holds_on_nan = is_negated || kind == Z3_OP_EQ;
+        if (kind == Z3_OP_EQ) {
+            kind = Z3_OP_FPA_EQ;
+        }
+        if (is_negated) {
+            // comparisons are flipped for operands which are not nan
+            switch (kind) {
+                case Z3_OP_FPA_LT: kind = Z3_OP_FPA_GE;
+                    break;
+                case Z3_OP_FPA_LE: kind = Z3_OP_FPA_GT;
+                    break;
+                case Z3_OP_FPA_GT: kind = Z3_OP_FPA_LE;
+                    break;
+                case Z3_OP_FPA_GE: kind = Z3_OP_FPA_LT;
+                    break;
+                default:
+                    continue;
+            }
+        }
+        switch (kind) {
+            case Z3_OP_FPA_LT:
+            case Z3_OP_FPA_LE:
+            case Z3_OP_FPA_EQ:
+                atoms->push_back(Atom{cur_expr.arg(0), cur_expr.arg(1), kind,
+                                      holds_on_nan});
+                break;
+            case Z3_OP_FPA_GT:
+                atoms->push_back(Atom{cur_expr.arg(1), cur_expr.arg(0),
+                                      Z3_OP_FPA_LT, holds_on_nan});
+                break;
+            case Z3_OP_FPA_GE:
+                atoms->push_back(Atom{cur_expr.arg(1), cur_expr.arg(0),
+                                      Z3_OP_FPA_LE, holds_on_nan});
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+FPIntervalAnalyzer::Interval FPIntervalAnalyzer::evalTerm
+        (const z3::expr& term,
+         const std::unordered_map<unsigned, size_t>& term_pos,
+         const std::vector<Interval>& intervals) const
+{
+    const Interval unbounded{-INFINITY, INFINITY, true};
+    if (!term.is_app()) {
+        return unbounded;
+    }
+    auto arg_interval = [&](unsigned i) {
+        return intervals[term_pos.at(Z3_get_ast_id(term.ctx(), term.arg(i)))];
+    };
+    const auto kind = term.decl().decl_kind();
+    if (fpa_util::isFPVar(term)) {
+        const unsigned var = m_var_ids.at(Z3_get_ast_id(term.ctx(), term));
+        return Interval{m_lower_bounds[var], m_upper_bounds[var], false};
+    }
+    if (term.get_sort().sort_kind() != Z3_FLOATING_POINT_SORT) {
+        return unbounded;
+    }
+    const unsigned sigd = Z3_fpa_get_sbits(term.ctx(), term.get_sort());
+    const unsigned expo = Z3_fpa_get_ebits(term.ctx(), term.get_sort());
+    if (term.is_numeral() || kind == Z3_OP_FPA_PLUS_INF ||
+        kind == Z3_OP_FPA_MINUS_INF || kind == Z3_OP_FPA_PLUS_ZERO ||
+        kind == Z3_OP_FPA_MINUS_ZERO) {
+        double value;
+        if (fpa_util::isFloat32(expo, sigd)) {
+            value = fpa_util::toFloat32(term);
+        } else if (fpa_util::isFloat64(expo, sigd)) {
+            value = fpa_util::toFloat64(term);
+        } else {
+            return unbounded;
+        }
+        return std::isnan(value) ? unbounded : Interval{value, value, false};
+    }
+    Interval result = unbounded;
+    switch (kind) {
+        case Z3_OP_FPA_NEG: {
+            const auto a = arg_interval(0);
+            return Interval{-a.Upper, -a.Lower, a.MayBeNaN};
+        }
+        case Z3_OP_FPA_ABS: {
+            const auto a = arg_interval(0);
+            if (a.Lower >= 0) {
+                return a;
+            }
+            if (a.Upper <= 0) {
+                return Interval{-a.Upper, -a.Lower, a.MayBeNaN};
+            }
+            return Interval{0, std::max(-a.Lower, a.Upper), a.MayBeNaN};
+        }
+        case Z3_OP_FPA_ADD: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            // inf - inf
+            result = Interval{roundDown(a.Lower + b.Lower),
+                              roundUp(a.Upper + b.Upper),
+                              a.MayBeNaN || b.MayBeNaN ||
+                              (isInfinite(a.Lower, a.Upper) &&
+                               isInfinite(b.Lower, b.Upper))};
+            break;
+        }
+        case Z3_OP_FPA_SUB: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            result = Interval{roundDown(a.Lower - b.Upper),
+                              roundUp(a.Upper - b.Lower),
+                              a.MayBeNaN || b.MayBeNaN ||
+                              (isInfinite(a.Lower, a.Upper) &&
+                               isInfinite(b.Lower, b.Upper))};
+            break;
+        }
+        case Z3_OP_FPA_MUL: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            combineBounds(a.Lower, a.Upper, b.Lower, b.Upper, mul,
+                          &result.Lower, &result.Upper);
+            // 0 * inf
+            result.MayBeNaN = a.MayBeNaN || b.MayBeNaN ||
+                              (containsZero(a.Lower, a.Upper) &&
+                               isInfinite(b.Lower, b.Upper)) ||
+                              (containsZero(b.Lower, b.Upper) &&
+                               isInfinite(a.Lower, a.Upper));
+            break;
+        }
+        case Z3_OP_FPA_DIV: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            if (!containsZero(b.Lower, b.Upper)) {
+                combineBounds(a.Lower, a.Upper, b.Lower, b.Upper, div,
+                              &result.Lower, &result.Upper);
+            }
+            // 0 / 0 and inf / inf
+            result.MayBeNaN = a.MayBeNaN || b.MayBeNaN ||
+                              (containsZero(a.Lower, a.Upper) &&
+                               containsZero(b.Lower, b.Upper)) ||
+                              (isInfinite(a.Lower, a.Upper) &&
+                               isInfinite(b.Lower, b.Upper));
+            break;
+        }
+        case Z3_OP_FPA_TO_FP: {
+            const auto last_arg = term.arg(term.num_args() - 1);
+            if (last_arg.get_sort().sort_kind() != Z3_FLOATING_POINT_SORT) {
+                return unbounded;
+            }
+            result = arg_interval(term.num_args() - 1);
+            break;
+        }
+        default:
+            return unbounded;
+    }
+    if (fpa_util::isFloat32(expo, sigd)) {
+        roundToFloat(&result.Lower, &result.Upper);
+    }
+    return result;
+}
+
+void FPIntervalAnalyzer::narrowArgs
+        (const z3::expr& term, const Interval& range,
+         const std::unordered_map<unsigned, size_t>& term_pos,
+         std::vector<Interval>* intervals) const
+{
+    auto narrow = [&](unsigned i, double lower, double upper) {
+        auto& arg = (*intervals)[term_pos.at(
+                Z3_get_ast_id(term.ctx(), term.arg(i)))];
+        arg.Lower = std::max(arg.Lower, lower);
+        arg.Upper = std::min(arg.Upper, upper);
+    };
+    auto arg_interval = [&](unsigned i) {
+        return (*intervals)[term_pos.at(
+                Z3_get_ast_id(term.ctx(), term.arg(i)))];
+    };
+    if (term.num_args() == 0 ||
+        term.get_sort().sort_kind() != Z3_FLOATING_POINT_SORT) {
+        return;
+    }
+    // range of the exact result before rounding
+    Interval exact{roundDown(range.Lower), roundUp(range.Upper), false};
+    if (fpa_util::isFloat32(Z3_fpa_get_ebits(term.ctx(), term.get_sort()),
+                            Z3_fpa_get_sbits(term.ctx(), term.get_sort()))) {
+        roundToFloat(&exact.Lower, &exact.Upper);
+    }
+    double lower;
+    double upper;
+    switch (term.decl().decl_kind()) {
+        case Z3_OP_FPA_NEG:
+            narrow(0, -range.Upper, -range.Lower);
+            break;
+        case Z3_OP_FPA_ABS:
+            narrow(0, -range.Upper, range.Upper);
+            break;
+        case Z3_OP_FPA_ADD: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            narrow(1, roundDown(exact.Lower - b.Upper),
+                   roundUp(exact.Upper - b.Lower));
+            narrow(2, roundDown(exact.Lower - a.Upper),
+                   roundUp(exact.Upper - a.Lower));
+            break;
+        }
+        case Z3_OP_FPA_SUB: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            narrow(1, roundDown(exact.Lower + b.Lower),
+                   roundUp(exact.Upper + b.Upper));
+            narrow(2, roundDown(a.Lower - exact.Upper),
+                   roundUp(a.Upper - exact.Lower));
+            break;
+        }
+        case Z3_OP_FPA_MUL: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            if (!containsZero(b.Lower, b.Upper)) {
+                combineBounds(exact.Lower, exact.Upper, b.Lower, b.Upper, div,
+                              &lower, &upper);
+                narrow(1, lower, upper);
+            }
+            if (!containsZero(a.Lower, a.Upper)) {
+                combineBounds(exact.Lower, exact.Upper, a.Lower, a.Upper, div,
+                              &lower, &upper);
+                narrow(2, lower, upper);
+            }
+            break;
+        }
+        case Z3_OP_FPA_DIV: {
+            const auto a = arg_interval(1);
+            const auto b = arg_interval(2);
+            combineBounds(exact.Lower, exact.Upper, b.Lower, b.Upper, mul,
+                          &lower, &upper);
+            narrow(1, lower, upper);
+            if (!containsZero(exact.Lower, exact.Upper)) {
+                combineBounds(a.Lower, a.Upper, exact.Lower, exact.Upper, div,
+                              &lower, &upper);
+                narrow(2, lower, upper);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool FPIntervalAnalyzer::reviseAtom(const Atom& atom)
+{
+    // terms of the atom in post-order, i.e., arguments precede their users
+    std::vector<z3::expr> terms;
+    std::unordered_map<unsigned, size_t> term_pos;
+    std::vector<std::pair<z3::expr, bool>> stack;
+    stack.emplace_back(std::make_pair(atom.Rhs, false));
+    stack.emplace_back(std::make_pair(atom.Lhs, false));
+    while (!stack.empty()) {
+        const auto cur_pair = stack.back();
+        stack.pop_back();
+        const z3::expr& cur_expr = cur_pair.first;
+        const unsigned id = Z3_get_ast_id(cur_expr.ctx(), cur_expr);
+        if (term_pos.find(id) != term_pos.cend()) {
+            continue;
+        }
+        if (cur_pair.second || !cur_expr.is_app() ||
+            cur_expr.num_args() == 0) {
+            term_pos[id] = terms.size();
+            terms.push_back(cur_expr);
+            continue;
+        }
+        stack.emplace_back(std::make_pair(cur_expr, true));
+        for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+            stack.emplace_back(std::make_pair(cur_expr.arg(i - 1), false));
+        }
+    }
+    std::vector<Interval> intervals;
+    intervals.reserve(terms.size());
+    for (const auto& term : terms) {
+        intervals.push_back(evalTerm(term, term_pos, intervals));
+    }
+    auto& lhs = intervals[term_pos[Z3_get_ast_id(atom.Lhs.ctx(), atom.Lhs)]];
+    auto& rhs = intervals[term_pos[Z3_get_ast_id(atom.Rhs.ctx(), atom.Rhs)]];
+    if (atom.HoldsOnNaN && (lhs.MayBeNaN || rhs.MayBeNaN)) {
+        // nothing is known about the operands
+        return true;
+    }
+    switch (atom.Kind) {
+        case Z3_OP_FPA_LT:
+            lhs.Upper = std::min(lhs.Upper, std::nextafter(rhs.Upper,
+                                                           -INFINITY));
+            rhs.Lower = std::max(rhs.Lower, std::nextafter(lhs.Lower,
+                                                           INFINITY));
+            break;
+        case Z3_OP_FPA_LE:
+            lhs.Upper = std::min(lhs.Upper, rhs.Upper);
+            rhs.Lower = std::max(rhs.Lower, lhs.Lower);
+            break;
+        default:
+            lhs.Lower = rhs.Lower = std::max(lhs.Lower, rhs.Lower);
+            lhs.Upper = rhs.Upper = std::min(lhs.Upper, rhs.Upper);
+            break;
+    }
+    // users are narrowed before their arguments
+    for (size_t i = terms.size(); i > 0; --i) {
+        const auto& term = terms[i - 1];
+        const auto& range = intervals[i - 1];
+        if (isEmpty(range.Lower, range.Upper)) {
+            return false;
+        }
+        if (fpa_util::isFPVar(term)) {
+            const unsigned var = m_var_ids.at(
+                    Z3_get_ast_id(term.ctx(), term));
+            if (range.Lower > m_lower_bounds[var]) {
+                m_lower_bounds[var] = range.Lower;
+                m_is_changed = true;
+            }
+            if (range.Upper < m_upper_bounds[var]) {
+                m_upper_bounds[var] = range.Upper;
+                m_is_changed = true;
+            }
+            continue;
+        }
+        narrowArgs(term, range, term_pos, &intervals);
+    }
+    return true;
+}
+
+bool FPIntervalAnalyzer::analyze(const z3::expr& expr)
+{
+    m_var_ids.clear();
+    m_lower_bounds.clear();
+    m_upper_bounds.clear();
+    numberVars(expr);
+    std::vector<Atom> atoms;
+    collectAtoms(expr, &atoms);
+    m_is_changed = true;
+    for (unsigned round = 0; round < kMaxRounds && m_is_changed; ++round) {
+        m_is_changed = false;
+        for (const auto& atom : atoms) {
+            if (!reviseAtom(atom)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+unsigned FPIntervalAnalyzer::getVarCount() const noexcept
+{
+    return static_cast<unsigned>(m_lower_bounds.size());
+}
+
+const std::vector<double>& FPIntervalAnalyzer::getLowerBounds() const noexcept
+{
+    return m_lower_bounds;
+}
+
+const std::vector<double>& FPIntervalAnalyzer::getUpperBounds() const noexcept
+{
+    return m_upper_bounds;
+}
+}
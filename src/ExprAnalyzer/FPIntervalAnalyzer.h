@@ -0,0 +1,100 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "z3++.h"
+#include <unordered_map>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Infers a box of finite values per variable that contains all
+ * models of a formula.
+ *
+ * Comparisons among top-level conjuncts, possibly negated, are propagated
+ * over intervals of their operands, i.e., the intervals of arithmetic terms
+ * are evaluated bottom-up and then narrowed top-down onto the variables,
+ * until variable bounds are stable. Bounds are rounded outwards by enough
+ * ULPs to cover the rounding of any rounding mode. Variables are numbered
+ * in the order FPIRGenerator assigns them.
+ */
+class FPIntervalAnalyzer {
+public:
+    FPIntervalAnalyzer();
+
+    virtual ~FPIntervalAnalyzer() = default;
+
+    FPIntervalAnalyzer(const FPIntervalAnalyzer&) = default;
+
+    FPIntervalAnalyzer& operator=(const FPIntervalAnalyzer&) = default;
+
+    FPIntervalAnalyzer& operator=(FPIntervalAnalyzer&&) = default;
+
+    /**
+     * /brief infers bounds of the variables of expr
+     * /returns false if no finite values satisfy expr, i.e., the formula is
+     * unsat within bounds
+     */
+    bool analyze(const z3::expr& expr);
+
+    unsigned getVarCount() const noexcept;
+
+    /// lower bounds in variable order
+    const std::vector<double>& getLowerBounds() const noexcept;
+
+    /// upper bounds in variable order
+    const std::vector<double>& getUpperBounds() const noexcept;
+
+private:
+    struct Interval {
+        double Lower;
+        double Upper;
+        /// the term may evaluate to nan, which lies outside of any bounds
+        bool MayBeNaN;
+    };
+
+    /// comparison which must hold, negated comparisons are flipped
+    struct Atom {
+        z3::expr Lhs;
+        z3::expr Rhs;
+        Z3_decl_kind Kind;
+        /// negated comparisons and equality hold on nan operands as well
+        bool HoldsOnNaN;
+    };
+
+    void numberVars(const z3::expr& expr);
+
+    void collectAtoms(const z3::expr& expr, std::vector<Atom>* atoms) const;
+
+    Interval evalTerm
+            (const z3::expr& term,
+             const std::unordered_map<unsigned, size_t>& term_pos,
+             const std::vector<Interval>& intervals) const;
+
+    /// narrows the arguments of term given that term lies in range
+    void narrowArgs
+            (const z3::expr& term, const Interval& range,
+             const std::unordered_map<unsigned, size_t>& term_pos,
+             std::vector<Interval>* intervals) const;
+
+    /// /returns false if the atom can not hold
+    bool reviseAtom(const Atom& atom);
+
+    static constexpr unsigned kMaxRounds = 16;
+
+private:
+    /// variable number by z3 AST id
+    std::unordered_map<unsigned, unsigned> m_var_ids;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+    bool m_is_changed;
+};
+}
@@ -0,0 +1,263 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPVarEliminator.h"
+#include "Utils/FPAUtils.h"
+#include <cassert>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace gosat {
+
+static inline unsigned getId(const z3::expr& expr)
+{
+    return Z3_get_ast_id(expr.ctx(), expr);
+}
+
+static inline bool isSupportedVar(const z3::expr& expr)
+{
+    return fpa_util::isFPVar(expr) &&
+           (fpa_util::isFloat32VarDecl(expr) ||
+            fpa_util::isFloat64VarDecl(expr));
+}
+
+bool FPVarEliminator::isDefinition
+        (const z3::expr& expr, z3::expr* var, z3::expr* term)
+{
+    if (!expr.is_app() || expr.num_args() != 2) {
+        return false;
+    }
+    const auto kind = expr.decl().decl_kind();
+    if ((kind != Z3_OP_EQ && kind != Z3_OP_FPA_EQ) ||
+        expr.arg(0).get_sort().sort_kind() != Z3_FLOATING_POINT_SORT) {
+        return false;
+    }
+    if (isSupportedVar(expr.arg(0))) {
+        *var = expr.arg(0);
+        *term = expr.arg(1);
+    } else if (isSupportedVar(expr.arg(1))) {
+        *var = expr.arg(1);
+        *term = expr.arg(0);
+    } else {
+        return false;
+    }
+    // values of the term are reconstructed from FP variables only
+    std::unordered_set<unsigned> visited;
+    std::vector<z3::expr> stack;
+    stack.push_back(*term);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        if (!cur_expr.is_app()) {
+            return false;
+        }
+        if (!visited.insert(getId(cur_expr)).second) {
+            continue;
+        }
+        if (cur_expr.decl().decl_kind() == Z3_OP_UNINTERPRETED &&
+            !isSupportedVar(cur_expr)) {
+            return false;
+        }
+        for (unsigned i = 0; i < cur_expr.num_args(); ++i) {
+            stack.push_back(cur_expr.arg(i));
+        }
+    }
+    return true;
+}
+
+bool FPVarEliminator::dependsOn(const z3::expr& expr, const z3::expr& var)
+{
+    const unsigned var_id = getId(var);
+    std::unordered_set<unsigned> visited;
+    std::vector<z3::expr> stack;
+    stack.push_back(expr);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        const unsigned id = getId(cur_expr);
+        if (id == var_id) {
+            return true;
+        }
+        if (!cur_expr.is_app() || !visited.insert(id).second) {
+            continue;
+        }
+        for (unsigned i = 0; i < cur_expr.num_args(); ++i) {
+            stack.push_back(cur_expr.arg(i));
+        }
+    }
+    return false;
+}
+
+z3::expr FPVarEliminator::eliminate(const z3::expr& expr)
+{
+    m_vars.clear();
+    m_reduced_vars.clear();
+    m_definitions.clear();
+    fpa_util::collectFPVars(expr, &m_vars);
+    // flattens nested conjunctions in order
+    std::vector<z3::expr> conjuncts;
+    std::vector<z3::expr> stack;
+    stack.push_back(expr);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        if (cur_expr.is_app() && cur_expr.decl().decl_kind() == Z3_OP_AND) {
+            for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+                stack.push_back(cur_expr.arg(i - 1));
+            }
+        } else {
+            conjuncts.push_back(cur_expr);
+        }
+    }
+    z3::expr_vector kept_conjuncts(expr.ctx());
+    std::unordered_set<unsigned> eliminated_ids;
+    for (const auto& conjunct : conjuncts) {
+        z3::expr var = conjunct;
+        z3::expr term = conjunct;
+        if (!isDefinition(conjunct, &var, &term) ||
+            eliminated_ids.find(getId(var)) != eliminated_ids.cend()) {
+            kept_conjuncts.push_back(conjunct);
+            continue;
+        }
+        // definitions depend on remaining variables only, which holds for
+        // the term once eliminated variables are substituted
+        z3::expr_vector src(expr.ctx());
+        z3::expr_vector dst(expr.ctx());
+        for (const auto& definition : m_definitions) {
+            src.push_back(definition.first);
+            dst.push_back(definition.second);
+        }
+        if (!m_definitions.empty()) {
+            term = term.substitute(src, dst);
+        }
+        const bool is_fp_eq = conjunct.decl().decl_kind() == Z3_OP_FPA_EQ;
+        if (dependsOn(term, var) ||
+            (is_fp_eq && term.is_app() &&
+             term.decl().decl_kind() == Z3_OP_FPA_NAN)) {
+            // (fp.eq x NaN) is unsatisfiable and kept as such
+            kept_conjuncts.push_back(conjunct);
+            continue;
+        }
+        z3::expr_vector var_src(expr.ctx());
+        z3::expr_vector var_dst(expr.ctx());
+        var_src.push_back(var);
+        var_dst.push_back(term);
+        for (auto& definition : m_definitions) {
+            definition.second = definition.second.substitute(var_src, var_dst);
+        }
+        m_definitions.emplace_back(std::make_pair(var, term));
+        eliminated_ids.insert(getId(var));
+        // (fp.eq x t) also requires t not to be NaN, which holds for the
+        // remaining numerals
+        if (is_fp_eq && !term.is_numeral()) {
+            kept_conjuncts.push_back(z3::to_expr(
+                    expr.ctx(), Z3_mk_fpa_eq(expr.ctx(), term, term)));
+        }
+    }
+    if (m_definitions.empty()) {
+        m_reduced_vars = m_vars;
+        return expr;
+    }
+    z3::expr_vector src(expr.ctx());
+    z3::expr_vector dst(expr.ctx());
+    for (const auto& definition : m_definitions) {
+        src.push_back(definition.first);
+        dst.push_back(definition.second);
+    }
+    z3::expr result = expr.ctx().bool_val(true);
+    if (kept_conjuncts.size() == 1) {
+        result = kept_conjuncts[0].substitute(src, dst);
+    } else if (kept_conjuncts.size() > 1) {
+        result = z3::mk_and(kept_conjuncts).substitute(src, dst);
+    }
+    fpa_util::collectFPVars(result, &m_reduced_vars);
+    return result;
+}
+
+unsigned FPVarEliminator::getVarCount() const noexcept
+{
+    return static_cast<unsigned>(m_vars.size());
+}
+
+unsigned FPVarEliminator::getEliminatedCount() const noexcept
+{
+    return static_cast<unsigned>(m_definitions.size());
+}
+
+unsigned FPVarEliminator::getReducedVarCount() const noexcept
+{
+    return static_cast<unsigned>(m_reduced_vars.size());
+}
+
+z3::expr FPVarEliminator::genFPConst(const z3::expr& var, double value)
+{
+    if (fpa_util::isFloat32VarDecl(var)) {
+        return z3::to_expr(var.ctx(), Z3_mk_fpa_numeral_float(
+                var.ctx(), static_cast<float>(value), var.get_sort()));
+    }
+    return z3::to_expr(var.ctx(), Z3_mk_fpa_numeral_double(
+            var.ctx(), value, var.get_sort()));
+}
+
+double FPVarEliminator::evalGroundTerm(const z3::expr& term)
+{
+    const z3::expr value = term.simplify();
+    if (!fpa_util::isFPNumeral(value)) {
+        return 0;
+    }
+    const unsigned sigd = Z3_fpa_get_sbits(value.ctx(), value.get_sort());
+    const unsigned expo = Z3_fpa_get_ebits(value.ctx(), value.get_sort());
+    if (fpa_util::isFloat32(expo, sigd)) {
+        return fpa_util::toFloat32(value);
+    }
+    return fpa_util::toFloat64(value);
+}
+
+std::vector<double> FPVarEliminator::reconstructModel
+        (const std::vector<double>& reduced_model) const
+{
+    assert(reduced_model.size() == m_reduced_vars.size() &&
+           "Model size mismatch!");
+    if (m_definitions.empty()) {
+        return reduced_model;
+    }
+    std::unordered_map<unsigned, double> values;
+    for (unsigned i = 0; i < m_reduced_vars.size(); ++i) {
+        values[getId(m_reduced_vars[i])] = reduced_model[i];
+    }
+    const z3::expr& some_var = m_definitions.front().first;
+    std::unordered_set<unsigned> eliminated_ids;
+    for (const auto& definition : m_definitions) {
+        eliminated_ids.insert(getId(definition.first));
+    }
+    z3::expr_vector src(some_var.ctx());
+    z3::expr_vector dst(some_var.ctx());
+    for (const auto& var : m_vars) {
+        const unsigned id = getId(var);
+        if (eliminated_ids.find(id) != eliminated_ids.cend()) {
+            continue;
+        }
+        // variables occurring only in definitions are free
+        const auto value = values.emplace(id, 0.0).first->second;
+        src.push_back(var);
+        dst.push_back(genFPConst(var, value));
+    }
+    for (const auto& definition : m_definitions) {
+        z3::expr term = definition.second;
+        values[getId(definition.first)] = evalGroundTerm(
+                term.substitute(src, dst));
+    }
+    std::vector<double> result;
+    result.reserve(m_vars.size());
+    for (const auto& var : m_vars) {
+        result.push_back(values[getId(var)]);
+    }
+    return result;
+}
+}
@@ -0,0 +1,85 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "z3++.h"
+#include <utility>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Eliminates variables defined by top-level conjuncts, i.e.,
+ * (= x t) or (fp.eq x t) where t does not depend on x, by substituting t
+ * for x in the remaining conjuncts.
+ *
+ * Conjunct (= x t) holds for x bit-equal to t, hence, it is dropped.
+ * Conjunct (fp.eq x t) holds only if t is not nan, hence, it is replaced
+ * by (fp.eq t t) unless t is a numeral. Conjunct (fp.eq x NaN) is never
+ * used for elimination since it does not hold for any x. Values of eliminated variables are
+ * reconstructed from their definitions given a model of the reduced
+ * formula. Variables are numbered in the order FPIRGenerator assigns them.
+ */
+class FPVarEliminator {
+public:
+    FPVarEliminator() = default;
+
+    virtual ~FPVarEliminator() = default;
+
+    FPVarEliminator(const FPVarEliminator&) = default;
+
+    FPVarEliminator& operator=(const FPVarEliminator&) = default;
+
+    FPVarEliminator& operator=(FPVarEliminator&&) = default;
+
+    /// /returns expr with defined variables substituted, which is expr
+    /// itself if no variable is eliminated
+    z3::expr eliminate(const z3::expr& expr);
+
+    /// number of variables of the formula last eliminated from
+    unsigned getVarCount() const noexcept;
+
+    unsigned getEliminatedCount() const noexcept;
+
+    /// number of variables of the reduced formula
+    unsigned getReducedVarCount() const noexcept;
+
+    /**
+     * /brief extends a model of the reduced formula, given in its variable
+     * order, to a model of the original formula in its variable order.
+     * Variables which occur only in definitions are set to zero.
+     */
+    std::vector<double>
+    reconstructModel(const std::vector<double>& reduced_model) const;
+
+private:
+    /**
+     * /brief finds var and term of a definition (= var term) or
+     * (fp.eq var term) where term depends on FP variables only
+     */
+    static bool
+    isDefinition(const z3::expr& expr, z3::expr* var, z3::expr* term);
+
+    static bool dependsOn(const z3::expr& expr, const z3::expr& var);
+
+    /// FP numeral of sort of var
+    static z3::expr genFPConst(const z3::expr& var, double value);
+
+    /// value of a ground FP term, zero if z3 can not evaluate it
+    static double evalGroundTerm(const z3::expr& term);
+
+private:
+    std::vector<z3::expr> m_vars;
+    std::vector<z3::expr> m_reduced_vars;
+    /// eliminated variables in order of elimination with definitions
+    /// depending on remaining variables only
+    std::vector<std::pair<z3::expr, z3::expr>> m_definitions;
+};
+}
@@ -9,15 +9,21 @@
 
 #include "FPIRGenerator.h"
 #include "Utils/FPAUtils.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/CallingConv.h>
+#include <llvm/IR/Constants.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/MDBuilder.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/Support/ToolOutputFile.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 
 namespace gosat {
@@ -27,6 +33,8 @@ FPIRGenerator::FPIRGenerator
         m_has_invalid_fp_const(false),
         m_found_unsupported_smt_expr(false),
         m_gofunc(nullptr),
+        m_gobatchfunc(nullptr),
+        m_goincfunc(nullptr),
         m_ctx(context),
         m_mod(module)
 {}
@@ -39,42 +47,43 @@ const IRSymbol* FPIRGenerator::genNumeralIR
         unsigned sigd = Z3_fpa_get_sbits(expr.ctx(), expr.get_sort());
         unsigned expo = Z3_fpa_get_ebits(expr.ctx(), expr.get_sort());
         if (fpa_util::isFloat32(expo, sigd)) {
-            auto result_iter = findSymbol(SymbolKind::kFP32Const, &expr);
-            if (result_iter != m_expr_sym_map.cend()) {
-                return &(*result_iter).second;
+            auto result_sym = findSymbol(SymbolKind::kFP32Const, expr);
+            if (result_sym != nullptr) {
+                return result_sym;
             }
             // TODO: handling FP32 should be configurable
             float numeral = fpa_util::toFloat32(expr);
             Value* value = ConstantFP::get(builder.getDoubleTy(), numeral);
-            auto res_pair = insertSymbol(SymbolKind::kFP32Const, expr, value, 0);
-            return res_pair.first;
+            return insertSymbol(SymbolKind::kFP32Const, expr, value, 0);
         } else {
-            if (!fpa_util::isFloat64(expo, sigd)) {
-                std::cerr << "unsupported\n";
-                std::exit(5);
+            auto result_sym = findSymbol(SymbolKind::kFP64Const, expr);
+            if (result_sym != nullptr) {
+                return result_sym;
             }
-            auto result_iter = findSymbol(SymbolKind::kFP64Const, &expr);
-            if (result_iter != m_expr_sym_map.cend()) {
-                return &(*result_iter).second;
+            if (!fpa_util::isFloat64(expo, sigd)) {
+                // XXX: numerals of other sorts are replaced by zero,
+                // the objective is only a guess then
+                m_found_unsupported_smt_expr = true;
+                return insertSymbol(SymbolKind::kFP64Const, expr,
+                                    ConstantFP::get(builder.getDoubleTy(),
+                                                    0.0), 0);
             }
             double numeral = fpa_util::toFloat64(expr);
             Value* value = ConstantFP::get(builder.getDoubleTy(), numeral);
-            auto res_pair = insertSymbol(SymbolKind::kFP64Const, expr, value, 0);
-            return res_pair.first;
+            return insertSymbol(SymbolKind::kFP64Const, expr, value, 0);
         }
     }
     if (expr.decl().decl_kind() == Z3_OP_BNUM) {
-        auto result_iter = findSymbol(SymbolKind::kFP64Const, &expr);
-        if (result_iter != m_expr_sym_map.cend()) {
-            return &(*result_iter).second;
+        auto result_sym = findSymbol(SymbolKind::kFP64Const, expr);
+        if (result_sym != nullptr) {
+            return result_sym;
         }
         std::string numeral_str = Z3_ast_to_string(expr.ctx(),
                                                    static_cast<z3::ast>(expr));
         numeral_str.replace(0, 1, 1, '0');
         Value* value = ConstantFP::get(builder.getDoubleTy(),
                                        std::stod(numeral_str));
-        auto res_pair = insertSymbol(SymbolKind::kFP64Const, expr, value, 0);
-        return res_pair.first;
+        return insertSymbol(SymbolKind::kFP64Const, expr, value, 0);
     }
     return nullptr;
 }
@@ -84,8 +93,312 @@ llvm::Function* FPIRGenerator::getDistanceFunction() const noexcept
     return m_func_fp64_dis;
 }
 
+llvm::Function* FPIRGenerator::genBatchFunction() noexcept
+{
+    using namespace llvm;
+    assert(m_gofunc != nullptr && "Objective function not generated yet!");
+    if (m_gobatchfunc != nullptr) {
+        return m_gobatchfunc;
+    }
+    auto func_type = FunctionType::get(Type::getVoidTy(*m_ctx),
+                                       {Type::getInt32Ty(*m_ctx),
+                                        Type::getInt32Ty(*m_ctx),
+                                        Type::getDoublePtrTy(*m_ctx),
+                                        Type::getDoublePtrTy(*m_ctx)},
+                                       false);
+    m_gobatchfunc = Function::Create(func_type, GlobalValue::ExternalLinkage,
+                                     CodeGenStr::kBatchFunName, m_mod);
+    Function::arg_iterator cur_arg = m_gobatchfunc->arg_begin();
+    Argument* arg_n = &(*cur_arg);
+    arg_n->setName("n");
+    cur_arg++;
+    Argument* arg_count = &(*cur_arg);
+    arg_count->setName("count");
+    cur_arg++;
+    Argument* arg_xs = &(*cur_arg);
+    arg_xs->setName("xs");
+    arg_xs->addAttr(Attribute::NoAlias);
+    arg_xs->addAttr(Attribute::NoCapture);
+    arg_xs->addAttr(Attribute::ReadOnly);
+    cur_arg++;
+    Argument* arg_out = &(*cur_arg);
+    arg_out->setName("out");
+    arg_out->addAttr(Attribute::NoAlias);
+    arg_out->addAttr(Attribute::NoCapture);
+
+    // objective is inlined into the loop body which is branch-free and
+    // hence a candidate for the loop vectorizer
+    m_gofunc->addFnAttr(Attribute::AlwaysInline);
+    BasicBlock* bb_entry = BasicBlock::Create(*m_ctx, "entry", m_gobatchfunc);
+    BasicBlock* bb_loop = BasicBlock::Create(*m_ctx, "loop", m_gobatchfunc);
+    BasicBlock* bb_exit = BasicBlock::Create(*m_ctx, "exit", m_gobatchfunc);
+    IRBuilder<> builder(bb_entry);
+    auto dim = builder.CreateZExt(arg_n, builder.getInt64Ty());
+    auto count = builder.CreateZExt(arg_count, builder.getInt64Ty());
+    builder.CreateCondBr(builder.CreateICmpEQ(count, builder.getInt64(0)),
+                         bb_exit, bb_loop);
+    builder.SetInsertPoint(bb_loop);
+    auto idx = builder.CreatePHI(builder.getInt64Ty(), 2);
+    auto x_ptr = builder.CreateInBoundsGEP(arg_xs, builder.CreateMul(idx, dim));
+    Value* call_args[] = {arg_n, x_ptr,
+                          ConstantPointerNull::get(Type::getDoublePtrTy(*m_ctx)),
+                          ConstantPointerNull::get(Type::getInt8PtrTy(*m_ctx))};
+    auto result = builder.CreateCall(m_gofunc, call_args);
+    auto stored_val = builder.CreateAlignedStore
+            (result, builder.CreateInBoundsGEP(arg_out, idx), 8);
+    stored_val->setMetadata(llvm::LLVMContext::MD_tbaa, m_tbaa_node);
+    auto next_idx = builder.CreateAdd(idx, builder.getInt64(1));
+    idx->addIncoming(builder.getInt64(0), bb_entry);
+    idx->addIncoming(next_idx, bb_loop);
+    builder.CreateCondBr(builder.CreateICmpEQ(next_idx, count), bb_exit,
+                         bb_loop);
+    builder.SetInsertPoint(bb_exit);
+    builder.CreateRetVoid();
+    return m_gobatchfunc;
+}
+
+llvm::Function* FPIRGenerator::genIncrementalFunction() noexcept
+{
+    using namespace llvm;
+    assert(m_gofunc != nullptr && "Objective function not generated yet!");
+    if (m_goincfunc != nullptr) {
+        return m_goincfunc;
+    }
+    BasicBlock& bb_objective = m_gofunc->getEntryBlock();
+    if (m_clause_values.empty()) {
+        m_clause_values.push_back(cast<ReturnInst>(
+                bb_objective.getTerminator())->getReturnValue());
+    }
+    auto func_type = FunctionType::get(Type::getDoubleTy(*m_ctx),
+                                       {Type::getInt32Ty(*m_ctx),
+                                        Type::getDoublePtrTy(*m_ctx),
+                                        Type::getDoublePtrTy(*m_ctx),
+                                        Type::getInt32PtrTy(*m_ctx),
+                                        Type::getInt32Ty(*m_ctx)},
+                                       false);
+    m_goincfunc = Function::Create(func_type, GlobalValue::ExternalLinkage,
+                                   CodeGenStr::kIncFunName, m_mod);
+    Function::arg_iterator cur_arg = m_goincfunc->arg_begin();
+    Argument* arg_n = &(*cur_arg);
+    arg_n->setName("n");
+    cur_arg++;
+    Argument* arg_x = &(*cur_arg);
+    arg_x->setName("x");
+    arg_x->addAttr(Attribute::NoAlias);
+    arg_x->addAttr(Attribute::NoCapture);
+    arg_x->addAttr(Attribute::ReadOnly);
+    cur_arg++;
+    Argument* arg_state = &(*cur_arg);
+    arg_state->setName("state");
+    arg_state->addAttr(Attribute::NoAlias);
+    arg_state->addAttr(Attribute::NoCapture);
+    cur_arg++;
+    Argument* arg_changed = &(*cur_arg);
+    arg_changed->setName("changed");
+    arg_changed->addAttr(Attribute::NoCapture);
+    arg_changed->addAttr(Attribute::ReadOnly);
+    cur_arg++;
+    Argument* arg_changed_count = &(*cur_arg);
+    arg_changed_count->setName("changed_count");
+
+    // the objective is a single block, its instructions are numbered in
+    // program order
+    std::vector<Instruction*> insts;
+    DenseMap<const Instruction*, unsigned> inst_pos;
+    for (auto& inst : bb_objective) {
+        inst_pos[&inst] = static_cast<unsigned>(insts.size());
+        insts.push_back(&inst);
+    }
+    DenseMap<const Instruction*, unsigned> var_ids;
+    for (const auto var_sym : m_var_sym_vec) {
+        var_ids[cast<Instruction>(var_sym->getValue())] = var_sym->id();
+    }
+    // backward slice of each clause, and clauses depending on each variable
+    const unsigned clause_count = getClauseCount();
+    const unsigned var_count = getVarCount();
+    std::vector<std::vector<unsigned>> slices(clause_count);
+    std::vector<std::vector<uint32_t>> var_clauses(var_count);
+    std::vector<unsigned> visit_mark(insts.size(), 0);
+    std::vector<unsigned> worklist;
+    for (unsigned i = 0; i < clause_count; ++i) {
+        auto root = dyn_cast<Instruction>(m_clause_values[i]);
+        if (root == nullptr) {
+            continue;
+        }
+        worklist.push_back(inst_pos[root]);
+        visit_mark[worklist.back()] = i + 1;
+        while (!worklist.empty()) {
+            const unsigned pos = worklist.back();
+            worklist.pop_back();
+            slices[i].push_back(pos);
+            auto var_it = var_ids.find(insts[pos]);
+            if (var_it != var_ids.end()) {
+                var_clauses[var_it->second].push_back(i);
+            }
+            for (const auto& operand : insts[pos]->operands()) {
+                auto operand_inst = dyn_cast<Instruction>(operand.get());
+                if (operand_inst == nullptr) {
+                    continue;
+                }
+                const unsigned operand_pos = inst_pos[operand_inst];
+                if (visit_mark[operand_pos] != i + 1) {
+                    visit_mark[operand_pos] = i + 1;
+                    worklist.push_back(operand_pos);
+                }
+            }
+        }
+        std::sort(slices[i].begin(), slices[i].end());
+    }
+    // clauses of variable v are listed in clause_ids from clause_offsets[v]
+    // to clause_offsets[v + 1]. Out-of-range variables have no clauses while
+    // the pseudo variable var_count + 1 has all of them.
+    std::vector<uint32_t> clause_offsets;
+    std::vector<uint32_t> clause_ids;
+    clause_offsets.reserve(var_count + 3);
+    for (const auto& clauses : var_clauses) {
+        clause_offsets.push_back(static_cast<uint32_t>(clause_ids.size()));
+        clause_ids.insert(clause_ids.end(), clauses.cbegin(), clauses.cend());
+    }
+    clause_offsets.push_back(static_cast<uint32_t>(clause_ids.size()));
+    clause_offsets.push_back(static_cast<uint32_t>(clause_ids.size()));
+    for (unsigned i = 0; i < clause_count; ++i) {
+        clause_ids.push_back(i);
+    }
+    clause_offsets.push_back(static_cast<uint32_t>(clause_ids.size()));
+    auto create_table = [this](ArrayRef<uint32_t> values, const char* name) {
+        auto init = ConstantDataArray::get(*m_ctx, values);
+        return new GlobalVariable(*m_mod, init->getType(), true,
+                                  GlobalValue::PrivateLinkage, init, name);
+    };
+    const uint32_t all_vars[] = {var_count + 1};
+    auto offsets_table = create_table(clause_offsets, "clause_offsets");
+    auto ids_table = create_table(clause_ids, "clause_ids");
+    auto all_vars_table = create_table(all_vars, "all_vars");
+
+    BasicBlock* bb_entry = BasicBlock::Create(*m_ctx, "entry", m_goincfunc);
+    BasicBlock* bb_var = BasicBlock::Create(*m_ctx, "var", m_goincfunc);
+    BasicBlock* bb_clause = BasicBlock::Create(*m_ctx, "clause", m_goincfunc);
+    BasicBlock* bb_clause_latch = BasicBlock::Create(*m_ctx, "clause_latch",
+                                                     m_goincfunc);
+    BasicBlock* bb_var_latch = BasicBlock::Create(*m_ctx, "var_latch",
+                                                  m_goincfunc);
+    BasicBlock* bb_sum = BasicBlock::Create(*m_ctx, "sum", m_goincfunc);
+    IRBuilder<> builder(bb_entry);
+    auto is_full = builder.CreateICmpEQ(
+            arg_changed, ConstantPointerNull::get(Type::getInt32PtrTy(*m_ctx)));
+    auto changed = builder.CreateSelect(
+            is_full, builder.CreateConstInBoundsGEP2_64(all_vars_table, 0, 0),
+            arg_changed);
+    auto changed_count = builder.CreateZExt(
+            builder.CreateSelect(is_full, builder.getInt32(1),
+                                 arg_changed_count), builder.getInt64Ty());
+    auto offsets = builder.CreateConstInBoundsGEP2_64(offsets_table, 0, 0);
+    auto ids = builder.CreateConstInBoundsGEP2_64(ids_table, 0, 0);
+    builder.CreateCondBr(builder.CreateICmpEQ(changed_count,
+                                              builder.getInt64(0)),
+                         bb_sum, bb_var);
+
+    builder.SetInsertPoint(bb_var);
+    auto var_idx = builder.CreatePHI(builder.getInt64Ty(), 2);
+    auto var = builder.CreateZExt(
+            builder.CreateAlignedLoad(
+                    builder.CreateInBoundsGEP(changed, var_idx), 4),
+            builder.getInt64Ty());
+    var = builder.CreateSelect(
+            builder.CreateICmpUGT(var, builder.getInt64(var_count + 1)),
+            builder.getInt64(var_count), var);
+    auto clause_begin = builder.CreateZExt(
+            builder.CreateAlignedLoad(builder.CreateInBoundsGEP(offsets, var),
+                                      4), builder.getInt64Ty());
+    auto clause_end = builder.CreateZExt(
+            builder.CreateAlignedLoad(
+                    builder.CreateInBoundsGEP(
+                            offsets,
+                            builder.CreateAdd(var, builder.getInt64(1))), 4),
+            builder.getInt64Ty());
+    builder.CreateCondBr(builder.CreateICmpEQ(clause_begin, clause_end),
+                         bb_var_latch, bb_clause);
+
+    builder.SetInsertPoint(bb_clause);
+    auto clause_idx = builder.CreatePHI(builder.getInt64Ty(), 2);
+    auto clause_id = builder.CreateAlignedLoad(
+            builder.CreateInBoundsGEP(ids, clause_idx), 4);
+    auto clause_switch = builder.CreateSwitch(clause_id, bb_clause_latch,
+                                              clause_count);
+
+    // every case recomputes a clause by cloning its slice of the objective
+    DenseMap<const Value*, Value*> value_map;
+    Argument* objective_x = &(*(++m_gofunc->arg_begin()));
+    for (unsigned i = 0; i < clause_count; ++i) {
+        BasicBlock* bb_case = BasicBlock::Create(*m_ctx, "clause_case",
+                                                 m_goincfunc, bb_clause_latch);
+        clause_switch->addCase(builder.getInt32(i), bb_case);
+        builder.SetInsertPoint(bb_case);
+        value_map.clear();
+        value_map[objective_x] = arg_x;
+        for (const auto pos : slices[i]) {
+            auto clone = insts[pos]->clone();
+            for (auto& operand : clone->operands()) {
+                auto value_it = value_map.find(operand.get());
+                if (value_it != value_map.end()) {
+                    operand.set(value_it->second);
+                }
+            }
+            builder.Insert(clone);
+            value_map[insts[pos]] = clone;
+        }
+        auto value_it = value_map.find(m_clause_values[i]);
+        auto stored_val = builder.CreateAlignedStore
+                ((value_it != value_map.end()) ? value_it->second :
+                 m_clause_values[i],
+                 builder.CreateInBoundsGEP(arg_state, builder.getInt64(i)), 8);
+        stored_val->setMetadata(llvm::LLVMContext::MD_tbaa, m_tbaa_node);
+        builder.CreateBr(bb_clause_latch);
+    }
+
+    builder.SetInsertPoint(bb_clause_latch);
+    auto next_clause_idx = builder.CreateAdd(clause_idx, builder.getInt64(1));
+    clause_idx->addIncoming(clause_begin, bb_var);
+    clause_idx->addIncoming(next_clause_idx, bb_clause_latch);
+    builder.CreateCondBr(builder.CreateICmpEQ(next_clause_idx, clause_end),
+                         bb_var_latch, bb_clause);
+
+    builder.SetInsertPoint(bb_var_latch);
+    auto next_var_idx = builder.CreateAdd(var_idx, builder.getInt64(1));
+    var_idx->addIncoming(builder.getInt64(0), bb_entry);
+    var_idx->addIncoming(next_var_idx, bb_var_latch);
+    builder.CreateCondBr(builder.CreateICmpEQ(next_var_idx, changed_count),
+                         bb_sum, bb_var);
+
+    // clauses are summed in the order of genMultiArgAddIR, hence results
+    // are bit-identical to the objective
+    builder.SetInsertPoint(bb_sum);
+    Value* result = nullptr;
+    for (unsigned i = 0; i < clause_count; ++i) {
+        auto loaded_val = builder.CreateAlignedLoad(
+                builder.CreateInBoundsGEP(arg_state, builder.getInt64(i)), 8);
+        loaded_val->setMetadata(llvm::LLVMContext::MD_tbaa, m_tbaa_node);
+        result = (result == nullptr) ? loaded_val :
+                 builder.CreateFAdd(result, loaded_val);
+    }
+    builder.CreateRet(result);
+    return m_goincfunc;
+}
+
 llvm::Function* FPIRGenerator::genFunction
         (const z3::expr& expr)  noexcept
+{
+    return genFunctionWith(expr, false);
+}
+
+llvm::Function* FPIRGenerator::genFunctionRecursive
+        (const z3::expr& expr) noexcept
+{
+    return genFunctionWith(expr, true);
+}
+
+llvm::Function* FPIRGenerator::genFunctionWith
+        (const z3::expr& expr, bool is_recursive) noexcept
 {
     using namespace llvm;
     if (m_gofunc != nullptr) {
@@ -130,74 +443,142 @@ llvm::Function* FPIRGenerator::genFunction
                                   md_scalar});
     m_tbaa_node = MDNode::get(*m_ctx, {md_node_3, md_node_3, md_scalar});
 
-    // Initialize external functions to be linked to JIT
-    m_func_fp64_dis = cast<Function>(
-            m_mod->getOrInsertFunction(StringRef(CodeGenStr::kFunDis),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy((*m_ctx)),
-                                       nullptr));
-    m_func_fp64_eq_dis = cast<Function>(
-            m_mod->getOrInsertFunction(StringRef(CodeGenStr::kFunEqDis),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy((*m_ctx)),
-                                       nullptr));
-    m_func_fp64_neq_dis = cast<Function>(
-            m_mod->getOrInsertFunction(StringRef(CodeGenStr::kFunNEqDis),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy((*m_ctx)),
-                                       nullptr));
-    m_func_isnan = cast<Function>(
-            m_mod->getOrInsertFunction(StringRef(CodeGenStr::kFunIsNan),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy(*m_ctx),
-                                       Type::getDoubleTy((*m_ctx)),
-                                       nullptr));
-
-    m_func_fp64_dis->setLinkage(Function::ExternalLinkage);
-    m_func_fp64_eq_dis->setLinkage(Function::ExternalLinkage);
-    m_func_fp64_neq_dis->setLinkage(Function::ExternalLinkage);
-    m_func_isnan->setLinkage(Function::ExternalLinkage);
     m_const_zero = ConstantFP::get(builder.getDoubleTy(), 0.0);
     m_const_one = ConstantFP::get(builder.getDoubleTy(), 1.0);
-    auto return_val_sym = genFuncRecursive(builder, expr, false);
+
+    // Distance helpers are emitted into the module to be inlined
+    m_func_fp64_dis = createHelperFunction(CodeGenStr::kFunDis);
+    m_func_fp64_eq_dis = createHelperFunction(CodeGenStr::kFunEqDis);
+    m_func_fp64_neq_dis = createHelperFunction(CodeGenStr::kFunNEqDis);
+    m_func_isnan = createHelperFunction(CodeGenStr::kFunIsNan);
+    genHelperFunctionBodies();
+    auto return_val_sym = (is_recursive) ?
+                          genFuncRecursive(builder, expr, false, true) :
+                          genFuncIterative(builder, expr);
     builder.CreateRet(return_val_sym->getValue());
     return m_gofunc;
 }
 
+const IRSymbol* FPIRGenerator::genFuncIterative
+        (llvm::IRBuilder<>& builder, const z3::expr& expr) noexcept
+{
+    std::vector<IRGenFrame> stack;
+    // argument symbols of all frames on the stack, a frame's arguments
+    // are on top once all of them are generated
+    std::vector<const IRSymbol*> arg_stack;
+    const IRSymbol* result = nullptr;
+    if (visitExpr(builder, expr, false, stack, &result)) {
+        return result;
+    }
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        if (frame.NextArg < frame.ArgCount) {
+            const z3::expr arg = frame.Expr.arg(frame.NextArg++);
+            const bool is_arg_negated = frame.IsArgNegated;
+            // frame is invalidated if a new frame is pushed
+            const IRSymbol* arg_sym;
+            if (visitExpr(builder, arg, is_arg_negated, stack, &arg_sym)) {
+                arg_stack.push_back(arg_sym);
+            } else {
+                stack.back().ArgBegin = arg_stack.size();
+            }
+            continue;
+        }
+        llvm::ArrayRef<const IRSymbol*> arg_syms(
+                arg_stack.data() + frame.ArgBegin,
+                arg_stack.size() - frame.ArgBegin);
+        auto expr_sym = finishFrame(builder, frame, arg_syms,
+                                    stack.size() == 1);
+        arg_stack.resize(frame.ArgBegin);
+        stack.pop_back();
+        if (stack.empty()) {
+            result = expr_sym;
+        } else {
+            arg_stack.push_back(expr_sym);
+        }
+    }
+    return result;
+}
+
 const IRSymbol* FPIRGenerator::genFuncRecursive
-        (llvm::IRBuilder<>& builder, const z3::expr expr,
-         bool is_negated) noexcept
+        (llvm::IRBuilder<>& builder, const z3::expr& expr, bool is_negated,
+         bool is_root) noexcept
+{
+    std::vector<IRGenFrame> stack;
+    const IRSymbol* result = nullptr;
+    if (visitExpr(builder, expr, is_negated, stack, &result)) {
+        return result;
+    }
+    const IRGenFrame frame = stack.back();
+    std::vector<const IRSymbol*> arg_syms;
+    arg_syms.reserve(frame.ArgCount);
+    for (unsigned i = 0; i < frame.ArgCount; ++i) {
+        arg_syms.push_back(genFuncRecursive(builder, frame.Expr.arg(i),
+                                            frame.IsArgNegated, false));
+    }
+    return finishFrame(builder, frame, arg_syms, is_root);
+}
+
+const IRSymbol* FPIRGenerator::finishFrame
+        (llvm::IRBuilder<>& builder, const IRGenFrame& frame,
+         llvm::ArrayRef<const IRSymbol*> arg_syms, bool is_root) noexcept
+{
+    auto expr_sym = insertSymbol(frame.Kind, frame.Expr, nullptr);
+    expr_sym->setValue(genExprIR(builder, expr_sym, arg_syms));
+    if (is_root && arg_syms.size() > 1 &&
+        ((frame.Expr.decl().decl_kind() == Z3_OP_AND &&
+          !expr_sym->isNegated()) ||
+         (frame.Expr.decl().decl_kind() == Z3_OP_OR &&
+          expr_sym->isNegated()))) {
+        // root is a sum of clauses, see genMultiArgAddIR
+        for (const auto arg_sym : arg_syms) {
+            m_clause_values.push_back(arg_sym->getValue());
+        }
+    }
+    if (frame.Expr.decl().decl_kind() == Z3_OP_FPA_TO_FP &&
+        fpa_util::isFPVar(frame.Expr.arg(1))) {
+        m_var_sym_fpa_vec.emplace_back(
+                std::make_pair(expr_sym, arg_syms[1]));
+    }
+    return expr_sym;
+}
+
+bool FPIRGenerator::visitExpr
+        (llvm::IRBuilder<>& builder, const z3::expr& expr, bool is_negated,
+         std::vector<IRGenFrame>& stack, const IRSymbol** sym) noexcept
 {
     if (!expr.is_app()) {
-        // is_app <==> Z3_NUMERAL_AST || Z3_APP_AST
-        std::cerr << "unsupported\n";
-        std::exit(4);
+        // is_app <==> Z3_NUMERAL_AST || Z3_APP_AST, e.g., quantifiers are
+        // replaced by a zero distance
+        m_found_unsupported_smt_expr = true;
+        auto result_sym = findSymbol(SymbolKind::kFP64Const, expr);
+        *sym = (result_sym != nullptr) ? result_sym :
+               insertSymbol(SymbolKind::kFP64Const, expr, m_const_zero, 0);
+        return true;
     }
+    const auto decl_kind = expr.decl().decl_kind();
     if (fpa_util::isRoundingModeApp(expr) &&
-        expr.decl().decl_kind() != Z3_OP_FPA_RM_NEAREST_TIES_TO_EVEN) {
+        decl_kind != Z3_OP_FPA_RM_NEAREST_TIES_TO_EVEN) {
         m_found_unsupported_smt_expr = true;
     }
     if (expr.is_numeral()) {
-        return genNumeralIR(builder, expr);
+        *sym = genNumeralIR(builder, expr);
+        return true;
     }
     if (fpa_util::isFPVar(expr)) {
         // TODO: handle FP16 and FP128 variables
-        SymbolKind kind;
+        SymbolKind kind = SymbolKind::kFP64Var;
         if (fpa_util::isFloat32VarDecl(expr)) {
             kind = SymbolKind::kFP32Var;
-        } else if (fpa_util::isFloat64VarDecl(expr)) {
-            kind = SymbolKind::kFP64Var;
-        } else {
+        } else if (!fpa_util::isFloat64VarDecl(expr)) {
             // XXX: instead of failing directly we give it a try.
             // The result might still be useful
             m_found_unsupported_smt_expr = true;
         }
-        auto result_iter = findSymbol(kind, &expr);
-        if (result_iter != m_expr_sym_map.cend()) {
-            return &(*result_iter).second;
+        auto result_sym = findSymbol(kind, expr);
+        if (result_sym != nullptr) {
+            *sym = result_sym;
+            return true;
         }
         using namespace llvm;
         Argument* arg2 = &(*(++m_gofunc->arg_begin()));
@@ -206,47 +587,39 @@ const IRSymbol* FPIRGenerator::genFuncRecursive
                  builder.getInt64(getVarCount()));
         auto loaded_val = builder.CreateAlignedLoad(idx_ptr, 8);
         loaded_val->setMetadata(llvm::LLVMContext::MD_tbaa, m_tbaa_node);
-        auto result_pair =
-                insertSymbol(kind, expr, loaded_val, getVarCount());
-        m_var_sym_vec.emplace_back(result_pair.first);
-        return result_pair.first;
+        auto var_sym = insertSymbol(kind, expr, loaded_val, getVarCount());
+        m_var_sym_vec.emplace_back(var_sym);
+        *sym = var_sym;
+        return true;
     }
     if (!fpa_util::isBoolExpr(expr)) {
         is_negated = false;
-    } else if (expr.decl().decl_kind() == Z3_OP_NOT) {
+    } else if (decl_kind == Z3_OP_NOT) {
         is_negated = !is_negated;
     }
     SymbolKind kind = (is_negated) ? SymbolKind::kNegatedExpr : SymbolKind::kExpr;
     if (is_negated &&
-        expr.decl().decl_kind() != Z3_OP_NOT &&
-        expr.decl().decl_kind() != Z3_OP_AND &&
-        expr.decl().decl_kind() != Z3_OP_OR) {
+        decl_kind != Z3_OP_NOT &&
+        decl_kind != Z3_OP_AND &&
+        decl_kind != Z3_OP_OR) {
         // propagate negation according to de-morgan's
         is_negated = false;
     }
-    auto result_iter = findSymbol(kind, &expr);
-    if (result_iter != m_expr_sym_map.cend()) {
-        return &(*result_iter).second;
-    }
-    // Expr not visited before
-    std::vector<const IRSymbol*> arg_syms;
-    arg_syms.reserve(expr.num_args());
-    for (uint i = 0; i < expr.num_args(); ++i) {
-        arg_syms.push_back(genFuncRecursive(builder, expr.arg(i), is_negated));
-    }
-    auto res_pair = insertSymbol(kind, expr, nullptr);
-    res_pair.first->setValue(genExprIR(builder, res_pair.first, arg_syms));
-    if (expr.decl().decl_kind() == Z3_OP_FPA_TO_FP &&
-        fpa_util::isFPVar(expr.arg(1))) {
-        m_var_sym_fpa_vec.emplace_back(
-                std::make_pair(res_pair.first, arg_syms[1]));
+    auto result_sym = findSymbol(kind, expr);
+    if (result_sym != nullptr) {
+        *sym = result_sym;
+        return true;
     }
-    return res_pair.first;
+    // Expr not visited before. Visiting a DAG depth-first, an expression
+    // is always finished before it is reached again.
+    stack.push_back(IRGenFrame{expr, kind, is_negated, expr.num_args(), 0,
+                               0});
+    return false;
 }
 
 llvm::Value* FPIRGenerator::genExprIR
         (llvm::IRBuilder<>& builder, const IRSymbol* expr_sym,
-         std::vector<const IRSymbol*>& arg_syms) noexcept
+         llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept
 {
     using namespace llvm;
     switch (expr_sym->expr()->decl().decl_kind()) {
@@ -355,67 +728,45 @@ llvm::Value* FPIRGenerator::genExprIR
             return (arg_syms[arg_syms.size() - 1])->getValue();
         case Z3_OP_FPA_IS_NAN:
             if (expr_sym->isNegated()) {
-                auto call_res = builder.CreateCall(m_func_isnan, {arg_syms[0]->getValue(), m_const_one});
-                call_res->setTailCall(false);
-                return call_res;
+                return builder.CreateCall(m_func_isnan,
+                                          {arg_syms[0]->getValue(),
+                                           m_const_one});
             } else {
-                auto call_res = builder.CreateCall(m_func_isnan, {arg_syms[0]->getValue(), m_const_zero});
-                call_res->setTailCall(false);
-                return call_res;
+                return builder.CreateCall(m_func_isnan,
+                                          {arg_syms[0]->getValue(),
+                                           m_const_zero});
             }
         default:
-            std::cerr << "unsupported: " +
-                         expr_sym->expr()->decl().name().str() + "\n";
-            std::exit(3);
+            // the distance of an unsupported expression is zero
+            m_found_unsupported_smt_expr = true;
+            return m_const_zero;
     }
 }
 
 llvm::Value* FPIRGenerator::genBinArgCmpIR
-        (llvm::IRBuilder<>& builder, std::vector<const IRSymbol*>& arg_syms,
+        (llvm::IRBuilder<>& builder, llvm::ArrayRef<const IRSymbol*> arg_syms,
          llvm::Value* comp_result) noexcept
 {
-    using namespace llvm;
-    BasicBlock* bb_first = BasicBlock::Create(*m_ctx, "", m_gofunc);
-    BasicBlock* bb_second = BasicBlock::Create(*m_ctx, "", m_gofunc);
-    BasicBlock* bb_cur = builder.GetInsertBlock();
-    builder.CreateCondBr(comp_result, bb_second, bb_first);
-    builder.SetInsertPoint(bb_first);
+    // distance is computed unconditionally, branch-free code is cheaper
+    // than a mispredicted branch and can be vectorized in batch evaluation
     auto call_res = builder.CreateCall(m_func_fp64_dis, {arg_syms[0]->getValue(),
                                                     arg_syms[1]->getValue()});
-    call_res->setTailCall(false);
-    builder.CreateBr(bb_second);
-    builder.SetInsertPoint(bb_second);
-    auto phi_inst = builder.CreatePHI(builder.getDoubleTy(), 2);
-    phi_inst->addIncoming(call_res, bb_first);
-    phi_inst->addIncoming(m_const_zero, bb_cur);
-    return phi_inst;
+    return builder.CreateSelect(comp_result, m_const_zero, call_res);
 }
 
 llvm::Value* FPIRGenerator::genBinArgCmpIR2
-        (llvm::IRBuilder<>& builder, std::vector<const IRSymbol*>& arg_syms,
+        (llvm::IRBuilder<>& builder, llvm::ArrayRef<const IRSymbol*> arg_syms,
          llvm::Value* comp_result) noexcept
 {
-    using namespace llvm;
-    BasicBlock* bb_first = BasicBlock::Create(*m_ctx, "", m_gofunc);
-    BasicBlock* bb_second = BasicBlock::Create(*m_ctx, "", m_gofunc);
-    BasicBlock* bb_cur = builder.GetInsertBlock();
-    builder.CreateCondBr(comp_result, bb_second, bb_first);
-    builder.SetInsertPoint(bb_first);
     auto call_res = builder.CreateCall(m_func_fp64_dis, {arg_syms[0]->getValue(),
                                                     arg_syms[1]->getValue()});
-    call_res->setTailCall(false);
     auto dis_res = builder.CreateFAdd(call_res, m_const_one);
-    builder.CreateBr(bb_second);
-    builder.SetInsertPoint(bb_second);
-    auto phi_inst = builder.CreatePHI(builder.getDoubleTy(), 2);
-    phi_inst->addIncoming(dis_res, bb_first);
-    phi_inst->addIncoming(m_const_zero, bb_cur);
-    return phi_inst;
+    return builder.CreateSelect(comp_result, m_const_zero, dis_res);
 }
 
 llvm::Value* FPIRGenerator::genMultiArgAddIR
         (llvm::IRBuilder<>& builder,
-         std::vector<const IRSymbol*>& arg_syms) noexcept
+         llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept
 {
     auto result = builder.CreateFAdd(arg_syms[0]->getValue(),
                                      arg_syms[1]->getValue());
@@ -427,7 +778,7 @@ llvm::Value* FPIRGenerator::genMultiArgAddIR
 
 llvm::Value* FPIRGenerator::genMultiArgMulIR
         (llvm::IRBuilder<>& builder,
-         std::vector<const IRSymbol*>& arg_syms) noexcept
+         llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept
 {
     auto result = builder.CreateFMul(arg_syms[0]->getValue(),
                                      arg_syms[1]->getValue());
@@ -439,7 +790,7 @@ llvm::Value* FPIRGenerator::genMultiArgMulIR
 
 llvm::Value *FPIRGenerator::genEqualityIR
         (llvm::IRBuilder<> &builder, const IRSymbol *expr_sym,
-         std::vector<const IRSymbol *> &arg_syms) noexcept
+         llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept
 {
 
     // workaround were we explicitly check the sort of the arguments,
@@ -477,6 +828,12 @@ unsigned FPIRGenerator::getVarCount() const noexcept
     return static_cast<unsigned>(m_var_sym_vec.size());
 }
 
+unsigned FPIRGenerator::getClauseCount() const noexcept
+{
+    // an objective which is not a conjunction is a single clause
+    return std::max(static_cast<unsigned>(m_clause_values.size()), 1u);
+}
+
 const std::vector<IRSymbol*>&
 FPIRGenerator::getVars() const noexcept
 {
@@ -489,44 +846,131 @@ FPIRGenerator::getVarsFPAWrapped() const noexcept
     return m_var_sym_fpa_vec;
 }
 
-std::pair<IRSymbol*, bool> FPIRGenerator::insertSymbol
-        (const SymbolKind kind, const z3::expr expr, llvm::Value* value,
+size_t FPIRGenerator::getSymbolKey
+        (const SymbolKind kind, const z3::expr& expr) noexcept
+{
+    const size_t id = Z3_get_ast_id(expr.ctx(), expr);
+    return 2 * id + ((kind == SymbolKind::kNegatedExpr) ? 1 : 0);
+}
+
+IRSymbol* FPIRGenerator::insertSymbol
+        (const SymbolKind kind, const z3::expr& expr, llvm::Value* value,
          unsigned id) noexcept
 {
-    if (kind != SymbolKind::kNegatedExpr) {
-        auto result = m_expr_sym_map.insert
-                ({expr.hash(), IRSymbol(kind, expr, value, id)});
-        return {&(*result.first).second, result.second};
-    } else {
-        // XXX: would this weaken hashing?
-        auto result = m_expr_sym_map.insert
-                ({expr.hash() + static_cast<unsigned>(kind),
-                  IRSymbol(kind, expr, value, id)});
-        return {&(*result.first).second, result.second};
+    const auto key = getSymbolKey(kind, expr);
+    if (key >= m_sym_by_key.size()) {
+        m_sym_by_key.resize(std::max(2 * m_sym_by_key.size(), key + 1),
+                            nullptr);
     }
+    assert(m_sym_by_key[key] == nullptr && "Symbol already exists!");
+    m_sym_by_key[key] = m_sym_arena.create(kind, expr, value, id);
+    return m_sym_by_key[key];
 }
 
-SymMapType::const_iterator FPIRGenerator::findSymbol
-        (const SymbolKind kind, const z3::expr* expr) const noexcept
+IRSymbol* FPIRGenerator::findSymbol
+        (const SymbolKind kind, const z3::expr& expr) const noexcept
 {
-    if (kind != SymbolKind::kNegatedExpr) {
-        return m_expr_sym_map.find(expr->hash());
-    } else {
-        // XXX: would this weaken hashing?
-        return m_expr_sym_map.find(expr->hash() + static_cast<unsigned>(kind));
-    }
+    const auto key = getSymbolKey(kind, expr);
+    return (key < m_sym_by_key.size()) ? m_sym_by_key[key] : nullptr;
+}
+
+llvm::Function*
+FPIRGenerator::createHelperFunction(const std::string& name) noexcept
+{
+    using namespace llvm;
+    auto double_type = Type::getDoubleTy(*m_ctx);
+    auto func_type = FunctionType::get(double_type, {double_type, double_type},
+                                       false);
+    auto func = Function::Create(func_type, GlobalValue::InternalLinkage,
+                                 name, m_mod);
+    func->addFnAttr(Attribute::AlwaysInline);
+    func->addFnAttr(Attribute::ReadNone);
+    func->addFnAttr(Attribute::NoUnwind);
+    return func;
 }
 
-void FPIRGenerator::addGlobalFunctionMappings(llvm::ExecutionEngine *engine)
+void FPIRGenerator::genHelperFunctionBodies() noexcept
 {
-    double (*func_ptr_dis)(double, double) = fp64_dis;
-    double (*func_ptr_eq_dis)(double, double) = fp64_eq_dis;
-    double (*func_ptr_neq_dis)(double, double) = fp64_neq_dis;
-    double (*func_ptr_isnan)(double, double) = fp64_isnan;
-    engine->addGlobalMapping(this->m_func_fp64_dis, (void *)func_ptr_dis);
-    engine->addGlobalMapping(this->m_func_fp64_eq_dis, (void *)func_ptr_eq_dis);
-    engine->addGlobalMapping(this->m_func_fp64_neq_dis, (void *)func_ptr_neq_dis);
-    engine->addGlobalMapping(this->m_func_isnan, (void *)func_ptr_isnan);
+    // Branch-free IR equivalents of the C functions in Utils/FPAUtils.cpp
+    using namespace llvm;
+    auto double_type = Type::getDoubleTy(*m_ctx);
+    {
+        auto arg_iter = m_func_fp64_dis->arg_begin();
+        Value* a = &(*arg_iter);
+        Value* b = &(*(++arg_iter));
+        IRBuilder<> builder(
+                BasicBlock::Create(*m_ctx, "entry", m_func_fp64_dis));
+        auto abs_mask = builder.getInt64(0x7FFFFFFFFFFFFFFF);
+        auto sign_mask = builder.getInt64(0x8000000000000000);
+        auto a_uint = builder.CreateBitCast(a, builder.getInt64Ty());
+        auto b_uint = builder.CreateBitCast(b, builder.getInt64Ty());
+        auto a_abs = builder.CreateAnd(a_uint, abs_mask);
+        auto b_abs = builder.CreateAnd(b_uint, abs_mask);
+        auto is_same_sign = builder.CreateICmpEQ
+                (builder.CreateAnd(a_uint, sign_mask),
+                 builder.CreateAnd(b_uint, sign_mask));
+        auto abs_diff = builder.CreateSelect
+                (builder.CreateICmpULT(a_abs, b_abs),
+                 builder.CreateSub(b_abs, a_abs),
+                 builder.CreateSub(a_abs, b_abs));
+        // signs are not equal use sum
+        auto dis_uint = builder.CreateSelect
+                (is_same_sign, abs_diff, builder.CreateAdd(a_abs, b_abs));
+        // multiplying by 2^-54 is exact and equals dividing by 2^54
+        auto dis = builder.CreateFMul
+                (builder.CreateUIToFP(dis_uint, double_type),
+                 ConstantFP::get(double_type, std::ldexp(1.0, -54)));
+        // any non-zero should do for nan
+        auto result = builder.CreateSelect
+                (builder.CreateFCmpUNO(a, b),
+                 ConstantFP::get(double_type, 1024.0), dis);
+        builder.CreateRet(builder.CreateSelect
+                                  (builder.CreateFCmpOEQ(a, b), m_const_zero,
+                                   result));
+    }
+    {
+        auto arg_iter = m_func_fp64_eq_dis->arg_begin();
+        Value* a = &(*arg_iter);
+        Value* b = &(*(++arg_iter));
+        IRBuilder<> builder(
+                BasicBlock::Create(*m_ctx, "entry", m_func_fp64_eq_dis));
+        auto is_a_zero = builder.CreateFCmpOEQ(a, m_const_zero);
+        auto is_b_zero = builder.CreateFCmpOEQ(b, m_const_zero);
+        auto dis = builder.CreateCall(m_func_fp64_dis, {a, b});
+        builder.CreateRet(builder.CreateSelect
+                                  (builder.CreateICmpEQ(is_a_zero, is_b_zero),
+                                   m_const_zero, dis));
+    }
+    {
+        auto arg_iter = m_func_fp64_neq_dis->arg_begin();
+        Value* a = &(*arg_iter);
+        Value* b = &(*(++arg_iter));
+        IRBuilder<> builder(
+                BasicBlock::Create(*m_ctx, "entry", m_func_fp64_neq_dis));
+        auto is_a_zero = builder.CreateFCmpOEQ(a, m_const_zero);
+        auto is_b_zero = builder.CreateFCmpOEQ(b, m_const_zero);
+        // it is possible that both sides are false, yet a == b and thus
+        // fp64_dis(a,b) would return 0 which is unsound.
+        auto dis = builder.CreateCall(m_func_fp64_dis, {a, b});
+        auto result = builder.CreateSelect(builder.CreateFCmpUNE(a, b),
+                                           dis, m_const_one);
+        builder.CreateRet(builder.CreateSelect
+                                  (builder.CreateICmpNE(is_a_zero, is_b_zero),
+                                   m_const_zero, result));
+    }
+    {
+        auto arg_iter = m_func_isnan->arg_begin();
+        Value* a = &(*arg_iter);
+        Value* flag = &(*(++arg_iter));
+        IRBuilder<> builder(
+                BasicBlock::Create(*m_ctx, "entry", m_func_isnan));
+        // flag set inverts result
+        auto is_nan = builder.CreateFCmpUNO(a, a);
+        auto is_flag_set = builder.CreateFCmpUNE(flag, m_const_zero);
+        builder.CreateRet(builder.CreateSelect
+                                  (builder.CreateICmpEQ(is_nan, is_flag_set),
+                                   m_const_one, m_const_zero));
+    }
 }
 
 bool FPIRGenerator::isFoundUnsupportedSMTExpr() noexcept
@@ -10,11 +10,12 @@
 #pragma once
 
 #include "CodeGen/CodeGen.h"
+#include "Utils/ObjectArena.h"
 #include "z3++.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/Module.h"
 #include <llvm/IR/IRBuilder.h>
-#include <unordered_map>
-#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <vector>
 
 namespace gosat {
 
@@ -55,8 +56,6 @@ private:
     unsigned m_id;
 };
 
-using SymMapType = std::unordered_map<unsigned, IRSymbol>;
-
 class FPIRGenerator {
 public:
     FPIRGenerator() = delete;
@@ -65,14 +64,37 @@ public:
 
     virtual ~FPIRGenerator() = default;
 
-    FPIRGenerator(const FPIRGenerator&) = default;
-
-    FPIRGenerator& operator=(const FPIRGenerator&) = default;
+    FPIRGenerator(const FPIRGenerator&) = delete;
 
-    FPIRGenerator& operator=(FPIRGenerator&&) = default;
+    FPIRGenerator& operator=(const FPIRGenerator&) = delete;
 
     llvm::Function* genFunction(const z3::expr& expr) noexcept;
 
+    /**
+     * /brief generates the same function as genFunction, but traverses
+     * expr recursively, which overflows the call stack on deep formulas.
+     * It is kept as reference of the iterative traversal, see irgen_bench.
+     */
+    llvm::Function* genFunctionRecursive(const z3::expr& expr) noexcept;
+
+    /**
+     * /brief generates a function evaluating the objective at count points
+     * stored consecutively in xs, results are written to out.
+     * @pre genFunction
+     */
+    llvm::Function* genBatchFunction() noexcept;
+
+    /**
+     * /brief generates a function which caches the value of each top-level
+     * clause in a state buffer and recomputes only clauses depending on the
+     * changed variables, see IncFunc. Results are identical to the objective.
+     * @pre genFunction
+     */
+    llvm::Function* genIncrementalFunction() noexcept;
+
+    /// number of doubles in the state buffer of the incremental function
+    unsigned getClauseCount() const noexcept;
+
     llvm::Function* getDistanceFunction() const noexcept;
 
     unsigned getVarCount() const noexcept;
@@ -82,55 +104,102 @@ public:
     const std::vector<std::pair<IRSymbol*, const IRSymbol*>>&
     getVarsFPAWrapped() const noexcept;
 
-    void addGlobalFunctionMappings(llvm::ExecutionEngine *engine);
-
     bool isFoundUnsupportedSMTExpr() noexcept;
 
 private:
+    /**
+     * /brief Expression whose IR is generated once IR of all its
+     * arguments is available
+     */
+    struct IRGenFrame {
+        z3::expr Expr;
+        SymbolKind Kind;
+        bool IsArgNegated;
+        unsigned ArgCount;
+        unsigned NextArg;
+        /// position of the first argument symbol in the argument stack
+        size_t ArgBegin;
+    };
+
+    llvm::Function*
+    genFunctionWith(const z3::expr& expr, bool is_recursive) noexcept;
+
+    /**
+     * /brief Generates IR of expr in post-order using an explicit stack,
+     * hence deep formulas do not overflow the call stack.
+     */
+    const IRSymbol* genFuncIterative
+            (llvm::IRBuilder<>& builder, const z3::expr& expr) noexcept;
+
     const IRSymbol* genFuncRecursive
-            (llvm::IRBuilder<>& builder, const z3::expr expr,
-             bool is_negated) noexcept;
+            (llvm::IRBuilder<>& builder, const z3::expr& expr,
+             bool is_negated, bool is_root) noexcept;
+
+    /// generates IR of the expression of frame given IR of its arguments
+    const IRSymbol* finishFrame
+            (llvm::IRBuilder<>& builder, const IRGenFrame& frame,
+             llvm::ArrayRef<const IRSymbol*> arg_syms, bool is_root) noexcept;
+
+    /**
+     * /brief resolves leaves and already visited expressions to sym,
+     * otherwise pushes a frame to stack.
+     * /returns false if a frame was pushed
+     */
+    bool visitExpr
+            (llvm::IRBuilder<>& builder, const z3::expr& expr,
+             bool is_negated, std::vector<IRGenFrame>& stack,
+             const IRSymbol** sym) noexcept;
 
     const IRSymbol*
     genNumeralIR(llvm::IRBuilder<>& builder, const z3::expr& expr) noexcept;
 
     llvm::Value* genExprIR
             (llvm::IRBuilder<>& builder, const IRSymbol* expr_sym,
-             std::vector<const IRSymbol*>& arg_syms) noexcept;
+             llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept;
 
     llvm::Value* genBinArgCmpIR
             (llvm::IRBuilder<>& builder,
-             std::vector<const IRSymbol*>& arg_syms,
+             llvm::ArrayRef<const IRSymbol*> arg_syms,
              llvm::Value* comp_result) noexcept;
 
     llvm::Value* genBinArgCmpIR2
             (llvm::IRBuilder<>& builder,
-             std::vector<const IRSymbol*>& arg_syms,
+             llvm::ArrayRef<const IRSymbol*> arg_syms,
              llvm::Value* comp_result) noexcept;
 
     llvm::Value* genMultiArgAddIR
             (llvm::IRBuilder<>& builder,
-             std::vector<const IRSymbol*>& arg_syms) noexcept;
+             llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept;
 
     llvm::Value* genMultiArgMulIR
             (llvm::IRBuilder<>& builder,
-             std::vector<const IRSymbol*>& arg_syms) noexcept;
+             llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept;
 
     llvm::Value *genEqualityIR
             (llvm::IRBuilder<> &builder, const IRSymbol *expr_sym,
-             std::vector<const IRSymbol *> &arg_syms) noexcept;
+             llvm::ArrayRef<const IRSymbol*> arg_syms) noexcept;
+
+    llvm::Function* createHelperFunction(const std::string& name) noexcept;
 
-    std::pair<IRSymbol*, bool> insertSymbol
-            (const SymbolKind kind, const z3::expr expr, llvm::Value* value,
+    void genHelperFunctionBodies() noexcept;
+
+    IRSymbol* insertSymbol
+            (const SymbolKind kind, const z3::expr& expr, llvm::Value* value,
              unsigned id = 0) noexcept;
 
-    SymMapType::const_iterator
-    findSymbol(const SymbolKind kind, const z3::expr* expr) const noexcept;
+    IRSymbol*
+    findSymbol(const SymbolKind kind, const z3::expr& expr) const noexcept;
+
+    /// symbols are keyed on z3 AST id and polarity
+    static size_t getSymbolKey(const SymbolKind kind,
+                               const z3::expr& expr) noexcept;
 
 private:
     bool m_has_invalid_fp_const;
     bool m_found_unsupported_smt_expr;
     llvm::Function* m_gofunc;
+    llvm::Function* m_gobatchfunc;
+    llvm::Function* m_goincfunc;
     llvm::Function* m_func_fp64_dis;
     llvm::Function* m_func_fp64_eq_dis;
     llvm::Function* m_func_fp64_neq_dis;
@@ -142,6 +211,10 @@ private:
     llvm::MDNode* m_tbaa_node;
     std::vector<IRSymbol*> m_var_sym_vec;
     std::vector<std::pair<IRSymbol*, const IRSymbol*>> m_var_sym_fpa_vec;
-    SymMapType m_expr_sym_map;
+    /// summands of the objective if it is a conjunction
+    std::vector<llvm::Value*> m_clause_values;
+    ObjectArena<IRSymbol> m_sym_arena;
+    /// z3 AST ids are dense, a vector indexed by key replaces hashing
+    std::vector<IRSymbol*> m_sym_by_key;
 };
 }
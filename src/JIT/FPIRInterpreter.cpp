@@ -0,0 +1,360 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPIRInterpreter.h"
+#include "CodeGen/CodeGen.h"
+#include "Utils/FPAUtils.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace gosat {
+
+static std::atomic<unsigned long> s_interpreter_count{0};
+
+// slots are reused by all evaluations of the same interpreter on a thread
+static thread_local std::vector<double> t_slots;
+static thread_local unsigned long t_slots_owner = 0;
+
+FPIRInterpreter::FPIRInterpreter() :
+        m_id{++s_interpreter_count},
+        m_result_slot{0},
+        m_var_count{0}
+{}
+
+bool FPIRInterpreter::translate(const llvm::Function& func) noexcept
+{
+    using namespace llvm;
+    m_code.clear();
+    m_slot_image.clear();
+    m_cone_offsets.clear();
+    m_cone_ops.clear();
+    m_var_count = 0;
+    if (func.size() != 1 || func.arg_size() != 4) {
+        return false;
+    }
+    const Value* arg_x = &(*std::next(func.arg_begin()));
+    DenseMap<const Value*, uint32_t> slots;
+    // pointers into x by variable index
+    DenseMap<const Value*, uint32_t> var_ptrs;
+    var_ptrs[arg_x] = 0;
+    auto get_slot = [this, &slots](const Value* value, uint32_t* slot) {
+        auto slot_iter = slots.find(value);
+        if (slot_iter != slots.end()) {
+            *slot = slot_iter->second;
+            return true;
+        }
+        auto const_fp = dyn_cast<ConstantFP>(value);
+        if (const_fp == nullptr ||
+            !const_fp->getType()->isDoubleTy()) {
+            return false;
+        }
+        *slot = static_cast<uint32_t>(m_slot_image.size());
+        m_slot_image.push_back(const_fp->getValueAPF().convertToDouble());
+        slots[value] = *slot;
+        return true;
+    };
+    bool is_returned = false;
+    for (const auto& inst : func.getEntryBlock()) {
+        Operation code{Opcode::kLoad, 0, 0, 0, 0, 0};
+        bool is_valid = true;
+        if (auto gep = dyn_cast<GetElementPtrInst>(&inst)) {
+            auto idx = (gep->getNumIndices() == 1) ?
+                       dyn_cast<ConstantInt>(*gep->idx_begin()) : nullptr;
+            if (gep->getPointerOperand() != arg_x || idx == nullptr) {
+                return false;
+            }
+            var_ptrs[gep] = static_cast<uint32_t>(idx->getZExtValue());
+            continue;
+        }
+        if (auto load = dyn_cast<LoadInst>(&inst)) {
+            auto ptr_iter = var_ptrs.find(load->getPointerOperand());
+            if (ptr_iter == var_ptrs.end()) {
+                return false;
+            }
+            code.Op = Opcode::kLoad;
+            code.A = ptr_iter->second;
+            m_var_count = std::max(m_var_count, code.A + 1);
+        } else if (auto bin_op = dyn_cast<BinaryOperator>(&inst)) {
+            switch (bin_op->getOpcode()) {
+                case Instruction::FAdd:
+                    code.Op = Opcode::kAdd;
+                    break;
+                case Instruction::FSub:
+                    code.Op = Opcode::kSub;
+                    break;
+                case Instruction::FMul:
+                    code.Op = Opcode::kMul;
+                    break;
+                case Instruction::FDiv:
+                    code.Op = Opcode::kDiv;
+                    break;
+                case Instruction::FRem:
+                    code.Op = Opcode::kRem;
+                    break;
+                default:
+                    return false;
+            }
+            is_valid = get_slot(bin_op->getOperand(0), &code.A) &&
+                       get_slot(bin_op->getOperand(1), &code.B);
+        } else if (auto cmp = dyn_cast<FCmpInst>(&inst)) {
+            code.Op = Opcode::kCmp;
+            code.Pred = static_cast<uint8_t>(cmp->getPredicate());
+            is_valid = get_slot(cmp->getOperand(0), &code.A) &&
+                       get_slot(cmp->getOperand(1), &code.B);
+        } else if (auto select = dyn_cast<SelectInst>(&inst)) {
+            code.Op = Opcode::kSelect;
+            is_valid = get_slot(select->getCondition(), &code.A) &&
+                       get_slot(select->getTrueValue(), &code.B) &&
+                       get_slot(select->getFalseValue(), &code.C);
+        } else if (auto call = dyn_cast<CallInst>(&inst)) {
+            const Function* callee = call->getCalledFunction();
+            if (callee == nullptr) {
+                return false;
+            }
+            if (callee->getIntrinsicID() == Intrinsic::fabs) {
+                code.Op = Opcode::kAbs;
+            } else if (callee->getName() == CodeGenStr::kFunDis) {
+                code.Op = Opcode::kDis;
+            } else if (callee->getName() == CodeGenStr::kFunEqDis) {
+                code.Op = Opcode::kEqDis;
+            } else if (callee->getName() == CodeGenStr::kFunNEqDis) {
+                code.Op = Opcode::kNEqDis;
+            } else if (callee->getName() == CodeGenStr::kFunIsNan) {
+                code.Op = Opcode::kIsNan;
+            } else {
+                return false;
+            }
+            is_valid = get_slot(call->getArgOperand(0), &code.A) &&
+                       (code.Op == Opcode::kAbs ||
+                        get_slot(call->getArgOperand(1), &code.B));
+        } else if (auto ret = dyn_cast<ReturnInst>(&inst)) {
+            is_returned = ret->getReturnValue() != nullptr &&
+                          get_slot(ret->getReturnValue(), &m_result_slot);
+            break;
+        } else {
+            return false;
+        }
+        if (!is_valid) {
+            return false;
+        }
+        code.Dst = static_cast<uint32_t>(m_slot_image.size());
+        m_slot_image.push_back(0.0);
+        slots[&inst] = code.Dst;
+        m_code.push_back(code);
+    }
+    // slots of a previous translation are stale
+    m_id = ++s_interpreter_count;
+    return is_returned;
+}
+
+bool FPIRInterpreter::evalCmp(uint8_t pred, double a, double b) noexcept
+{
+    using llvm::CmpInst;
+    switch (static_cast<CmpInst::Predicate>(pred)) {
+        case CmpInst::FCMP_OEQ:
+            return a == b;
+        case CmpInst::FCMP_OGT:
+            return a > b;
+        case CmpInst::FCMP_OGE:
+            return a >= b;
+        case CmpInst::FCMP_OLT:
+            return a < b;
+        case CmpInst::FCMP_OLE:
+            return a <= b;
+        case CmpInst::FCMP_ONE:
+            return a < b || a > b;
+        case CmpInst::FCMP_ORD:
+            return !std::isnan(a) && !std::isnan(b);
+        case CmpInst::FCMP_UNO:
+            return std::isnan(a) || std::isnan(b);
+        case CmpInst::FCMP_UEQ:
+            return !(a < b || a > b);
+        case CmpInst::FCMP_UGT:
+            return !(a <= b);
+        case CmpInst::FCMP_UGE:
+            return !(a < b);
+        case CmpInst::FCMP_ULT:
+            return !(a >= b);
+        case CmpInst::FCMP_ULE:
+            return !(a > b);
+        case CmpInst::FCMP_UNE:
+            return a != b;
+        case CmpInst::FCMP_TRUE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline double FPIRInterpreter::evalOperation
+        (const Operation& code, const double* x, const double* slots) noexcept
+{
+    switch (code.Op) {
+        case Opcode::kLoad:
+            return x[code.A];
+        case Opcode::kAdd:
+            return slots[code.A] + slots[code.B];
+        case Opcode::kSub:
+            return slots[code.A] - slots[code.B];
+        case Opcode::kMul:
+            return slots[code.A] * slots[code.B];
+        case Opcode::kDiv:
+            return slots[code.A] / slots[code.B];
+        case Opcode::kRem:
+            return std::fmod(slots[code.A], slots[code.B]);
+        case Opcode::kAbs:
+            return std::fabs(slots[code.A]);
+        case Opcode::kCmp:
+            return evalCmp(code.Pred, slots[code.A], slots[code.B]) ? 1.0 : 0.0;
+        case Opcode::kSelect:
+            return (slots[code.A] != 0) ? slots[code.B] : slots[code.C];
+        case Opcode::kDis:
+            return fp64_dis(slots[code.A], slots[code.B]);
+        case Opcode::kEqDis:
+            return fp64_eq_dis(slots[code.A], slots[code.B]);
+        case Opcode::kNEqDis:
+            return fp64_neq_dis(slots[code.A], slots[code.B]);
+        case Opcode::kIsNan:
+            return fp64_isnan(slots[code.A], slots[code.B]);
+    }
+    return 0.0;
+}
+
+double FPIRInterpreter::eval(const double* x) const noexcept
+{
+    if (t_slots_owner != m_id) {
+        t_slots.assign(m_slot_image.cbegin(), m_slot_image.cend());
+        t_slots_owner = m_id;
+    }
+    double* slots = t_slots.data();
+    for (const auto& code : m_code) {
+        slots[code.Dst] = evalOperation(code, x, slots);
+    }
+    return slots[m_result_slot];
+}
+
+double FPIRInterpreter::evalFunc
+        (unsigned n, const double* x, double* grad, void* data)
+{
+    return static_cast<const FPIRInterpreter*>(data)->eval(x);
+}
+
+void FPIRInterpreter::indexDependencies()
+{
+    const auto op_count = static_cast<uint32_t>(m_code.size());
+    // operations using the result of an operation, by slot
+    std::vector<std::vector<uint32_t>> users(m_slot_image.size());
+    for (uint32_t i = 0; i < op_count; ++i) {
+        const auto& code = m_code[i];
+        if (code.Op == Opcode::kLoad) {
+            continue;
+        }
+        users[code.A].push_back(i);
+        if (code.Op != Opcode::kAbs) {
+            users[code.B].push_back(i);
+        }
+        if (code.Op == Opcode::kSelect) {
+            users[code.C].push_back(i);
+        }
+    }
+    std::vector<std::vector<uint32_t>> loads(m_var_count);
+    for (uint32_t i = 0; i < op_count; ++i) {
+        if (m_code[i].Op == Opcode::kLoad) {
+            loads[m_code[i].A].push_back(i);
+        }
+    }
+    m_cone_offsets.assign(1, 0);
+    m_cone_ops.clear();
+    // visited operations are marked by their variable index plus one
+    std::vector<unsigned> marks(op_count, 0);
+    std::vector<uint32_t> work_list;
+    for (unsigned var = 0; var < m_var_count; ++var) {
+        const auto cone_start = m_cone_ops.size();
+        work_list = loads[var];
+        for (const auto op : work_list) {
+            marks[op] = var + 1;
+        }
+        while (!work_list.empty()) {
+            const auto op = work_list.back();
+            work_list.pop_back();
+            m_cone_ops.push_back(op);
+            for (const auto user : users[m_code[op].Dst]) {
+                if (marks[user] != var + 1) {
+                    marks[user] = var + 1;
+                    work_list.push_back(user);
+                }
+            }
+        }
+        std::sort(m_cone_ops.begin() + cone_start, m_cone_ops.end());
+        m_cone_offsets.push_back(m_cone_ops.size());
+    }
+}
+
+bool FPIRInterpreter::isDependencyIndexed() const noexcept
+{
+    return m_cone_offsets.size() == m_var_count + 1;
+}
+
+double FPIRInterpreter::evalState
+        (const double* x, std::vector<double>* state) const noexcept
+{
+    state->assign(m_slot_image.cbegin(), m_slot_image.cend());
+    double* slots = state->data();
+    for (const auto& code : m_code) {
+        slots[code.Dst] = evalOperation(code, x, slots);
+    }
+    return slots[m_result_slot];
+}
+
+double FPIRInterpreter::updateState
+        (const double* x, unsigned var,
+         std::vector<double>* state) const noexcept
+{
+    if (!isDependencyIndexed()) {
+        return evalState(x, state);
+    }
+    if (var >= m_var_count) {
+        // x[var] is not used
+        return (*state)[m_result_slot];
+    }
+    double* slots = state->data();
+    const auto cone_end = m_cone_ops.cbegin() + m_cone_offsets[var + 1];
+    for (auto it = m_cone_ops.cbegin() + m_cone_offsets[var]; it != cone_end;
+         ++it) {
+        const auto& code = m_code[*it];
+        slots[code.Dst] = evalOperation(code, x, slots);
+    }
+    return slots[m_result_slot];
+}
+
+size_t FPIRInterpreter::getInstructionCount() const noexcept
+{
+    return m_code.size();
+}
+
+unsigned FPIRInterpreter::getVarCount() const noexcept
+{
+    return m_var_count;
+}
+
+size_t FPIRInterpreter::getConeSize(unsigned var) const noexcept
+{
+    if (!isDependencyIndexed() || var >= m_var_count) {
+        return 0;
+    }
+    return m_cone_offsets[var + 1] - m_cone_offsets[var];
+}
+}
@@ -0,0 +1,138 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+class Function;
+}
+
+namespace gosat {
+
+/**
+ * /brief Evaluates an objective function generated by FPIRGenerator without
+ * compiling it.
+ *
+ * The unoptimized IR of the function is translated to a compact register
+ * bytecode where every IR value is a slot of doubles. Translation is linear
+ * in the size of the IR, hence evaluation can start right after IR
+ * generation. Distance helpers are evaluated by their C equivalents in
+ * Utils/FPAUtils.h, so results are identical to the jitted function.
+ *
+ * Evaluation is thread-safe, each thread works on its own slots.
+ *
+ * After indexDependencies, the cone of influence of every variable, i.e.,
+ * the operations depending on it, is known. Using evalState and updateState,
+ * a caller can keep all slots in its own state and recompute only the cone
+ * of a changed variable.
+ */
+class FPIRInterpreter {
+public:
+    FPIRInterpreter();
+
+    virtual ~FPIRInterpreter() = default;
+
+    FPIRInterpreter(const FPIRInterpreter&) = delete;
+
+    FPIRInterpreter& operator=(const FPIRInterpreter&) = delete;
+
+    /**
+     * /brief translates func to bytecode. func must be the objective
+     * generated by FPIRGenerator::genFunction before it is optimized.
+     * /returns false if func holds an instruction not supported by the
+     * interpreter
+     */
+    bool translate(const llvm::Function& func) noexcept;
+
+    double eval(const double* x) const noexcept;
+
+    /// same signature as nlopt_func, data points to the interpreter
+    static double
+    evalFunc(unsigned n, const double* x, double* grad, void* data);
+
+    /// builds the cones of influence of variables used by updateState
+    void indexDependencies();
+
+    bool isDependencyIndexed() const noexcept;
+
+    /// evaluates at x and keeps the values of all slots in state
+    double evalState(const double* x, std::vector<double>* state) const noexcept;
+
+    /**
+     * /brief evaluates at x where only x[var] differs from the point state
+     * was computed at. Only the cone of var is recomputed if dependencies are
+     * indexed, otherwise, all operations are.
+     */
+    double updateState
+            (const double* x, unsigned var,
+             std::vector<double>* state) const noexcept;
+
+    size_t getInstructionCount() const noexcept;
+
+    /// one more than the largest variable index loaded
+    unsigned getVarCount() const noexcept;
+
+    /// number of operations depending on variable var
+    size_t getConeSize(unsigned var) const noexcept;
+
+private:
+    enum class Opcode : uint8_t {
+        kLoad,
+        kAdd,
+        kSub,
+        kMul,
+        kDiv,
+        kRem,
+        kAbs,
+        kCmp,
+        kSelect,
+        kDis,
+        kEqDis,
+        kNEqDis,
+        kIsNan
+    };
+
+    /**
+     * /brief writes result to slot Dst. Operands A, B, and C are slots,
+     * except for kLoad where A is the index of the variable. Pred is the
+     * LLVM predicate of kCmp.
+     */
+    struct Operation {
+        Opcode Op;
+        uint8_t Pred;
+        uint32_t Dst;
+        uint32_t A;
+        uint32_t B;
+        uint32_t C;
+    };
+
+    static bool evalCmp(uint8_t pred, double a, double b) noexcept;
+
+    static double evalOperation
+            (const Operation& code, const double* x,
+             const double* slots) noexcept;
+
+private:
+    /// identifies the owner of thread-local slots
+    unsigned long m_id;
+    uint32_t m_result_slot;
+    unsigned m_var_count;
+    std::vector<Operation> m_code;
+    /// initial values of slots, i.e., constants
+    std::vector<double> m_slot_image;
+    /// operations of the cone of variable i, in program order, are
+    /// m_cone_ops[m_cone_offsets[i]] to m_cone_ops[m_cone_offsets[i + 1] - 1]
+    std::vector<size_t> m_cone_offsets;
+    std::vector<uint32_t> m_cone_ops;
+};
+}
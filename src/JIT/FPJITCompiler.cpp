@@ -0,0 +1,232 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPJITCompiler.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/LambdaResolver.h"
+#include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Mangler.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace gosat {
+
+static inline double
+elapsedSecondsFrom(std::chrono::steady_clock::time_point& st_time)
+{
+    return std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - st_time).count();
+}
+
+/**
+ * /brief Host cpu and its features are queried once per process instead
+ * of once per session
+ */
+static const std::vector<std::string>& getHostCPUAttrs()
+{
+    static std::vector<std::string> attrs;
+    static std::once_flag init_flag;
+    std::call_once(init_flag, []() {
+        // jitted code may call libm, e.g., fmod for frem
+        llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
+        llvm::StringMap<bool> host_features;
+        if (llvm::sys::getHostCPUFeatures(host_features)) {
+            for (const auto& feature : host_features) {
+                attrs.push_back((feature.second ? "+" : "-") +
+                                feature.first().str());
+            }
+        }
+    });
+    return attrs;
+}
+
+FPJITCompiler::FPJITCompiler(unsigned opt_level) :
+        m_opt_level{std::min(opt_level, 3u)},
+        m_ir_opt_time{0},
+        m_codegen_time{0},
+        m_has_module{false}
+{
+    using namespace llvm;
+    // tune for host cpu so that the vectorizers can use all available lanes
+    const auto& attrs = getHostCPUAttrs();
+    EngineBuilder engine_builder;
+    engine_builder.setOptLevel(toCodeGenOptLevel(m_opt_level))
+            .setMCPU(sys::getHostCPUName())
+            .setMAttrs(attrs)
+            .setErrorStr(&m_err_str);
+    m_target_machine.reset(engine_builder.selectTarget());
+    if (m_target_machine == nullptr) {
+        return;
+    }
+    m_object_layer = std::make_unique<ObjectLayerType>();
+    m_compile_layer = std::make_unique<CompileLayerType>(
+            *m_object_layer, orc::SimpleCompiler(*m_target_machine));
+}
+
+FPJITCompiler::~FPJITCompiler()
+{
+    if (m_has_module) {
+        // frees code and data sections of this session
+        m_compile_layer->removeModuleSet(m_module_handle);
+    }
+}
+
+llvm::CodeGenOpt::Level FPJITCompiler::toCodeGenOptLevel(unsigned opt_level)
+{
+    switch (opt_level) {
+        case 0:
+            return llvm::CodeGenOpt::None;
+        case 1:
+            return llvm::CodeGenOpt::Less;
+        case 2:
+            return llvm::CodeGenOpt::Default;
+        default:
+            return llvm::CodeGenOpt::Aggressive;
+    }
+}
+
+bool FPJITCompiler::compile(std::unique_ptr<llvm::Module> module) noexcept
+{
+    using namespace llvm;
+    if (m_target_machine == nullptr) {
+        // error string is set by target selection
+        return false;
+    }
+    if (m_has_module) {
+        m_err_str = "JIT session can compile a single module only";
+        return false;
+    }
+    module->setDataLayout(m_target_machine->createDataLayout());
+    module->setTargetTriple(m_target_machine->getTargetTriple().str());
+    auto time_start = std::chrono::steady_clock::now();
+    optimizeModule(*module);
+    m_ir_opt_time = elapsedSecondsFrom(time_start);
+
+    time_start = std::chrono::steady_clock::now();
+    // symbols are resolved within the module first, then in the process
+    auto resolver = orc::createLambdaResolver(
+            [this](const std::string& name) {
+                if (auto sym = m_compile_layer->findSymbol(name, false)) {
+                    return sym;
+                }
+                return JITSymbol(nullptr);
+            },
+            [](const std::string& name) {
+                if (auto sym_addr =
+                        RTDyldMemoryManager::getSymbolAddressInProcess(name)) {
+                    return JITSymbol(sym_addr, JITSymbolFlags::Exported);
+                }
+                return JITSymbol(nullptr);
+            });
+    std::vector<std::unique_ptr<Module>> modules;
+    modules.push_back(std::move(module));
+    m_module_handle = m_compile_layer->addModuleSet(
+            std::move(modules), std::make_unique<SectionMemoryManager>(),
+            std::move(resolver));
+    m_has_module = true;
+    // linking is lazy by default, finalize now so that the reported time
+    // covers all of the work and later lookups are cheap
+    m_compile_layer->emitAndFinalize(m_module_handle);
+    m_codegen_time = elapsedSecondsFrom(time_start);
+    return true;
+}
+
+std::future<bool>
+FPJITCompiler::compileAsync(std::unique_ptr<llvm::Module> module)
+{
+    // std::function requires copyable callables, hence the shared_ptr
+    auto module_ptr = std::make_shared<std::unique_ptr<llvm::Module>>(
+            std::move(module));
+    return std::async(std::launch::async, [this, module_ptr]() {
+        return compile(std::move(*module_ptr));
+    });
+}
+
+void FPJITCompiler::optimizeModule(llvm::Module& module) noexcept
+{
+    using namespace llvm;
+    legacy::FunctionPassManager func_pass_manager(&module);
+    legacy::PassManager module_pass_manager;
+    func_pass_manager.add(createTargetTransformInfoWrapperPass(
+            m_target_machine->getTargetIRAnalysis()));
+    module_pass_manager.add(createTargetTransformInfoWrapperPass(
+            m_target_machine->getTargetIRAnalysis()));
+
+    PassManagerBuilder builder;
+    builder.OptLevel = m_opt_level;
+    builder.SizeLevel = 0;
+    // distance helpers are the only callees, they are always-inline
+    builder.Inliner = createAlwaysInlinerLegacyPass();
+    builder.LoopVectorize = m_opt_level > 1;
+    builder.SLPVectorize = m_opt_level > 1;
+    builder.populateFunctionPassManager(func_pass_manager);
+    builder.populateModulePassManager(module_pass_manager);
+
+    func_pass_manager.doInitialization();
+    for (auto& func : module) {
+        func_pass_manager.run(func);
+    }
+    func_pass_manager.doFinalization();
+    module_pass_manager.run(module);
+}
+
+void FPJITCompiler::setObjectCache(llvm::ObjectCache* obj_cache) noexcept
+{
+    if (m_compile_layer != nullptr) {
+        m_compile_layer->setObjectCache(obj_cache);
+    }
+}
+
+void* FPJITCompiler::getFunctionAddress(const std::string& func_name) noexcept
+{
+    using namespace llvm;
+    if (!m_has_module) {
+        return nullptr;
+    }
+    std::string mangled_name;
+    raw_string_ostream mangled_name_stream(mangled_name);
+    Mangler::getNameWithPrefix(mangled_name_stream, func_name,
+                               m_target_machine->createDataLayout());
+    auto sym = m_compile_layer->findSymbolIn(m_module_handle,
+                                             mangled_name_stream.str(), true);
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(sym.getAddress()));
+}
+
+unsigned FPJITCompiler::getOptLevel() const noexcept
+{
+    return m_opt_level;
+}
+
+const std::string& FPJITCompiler::getErrorStr() const noexcept
+{
+    return m_err_str;
+}
+
+double FPJITCompiler::getIROptTime() const noexcept
+{
+    return m_ir_opt_time;
+}
+
+double FPJITCompiler::getCodeGenTime() const noexcept
+{
+    return m_codegen_time;
+}
+}
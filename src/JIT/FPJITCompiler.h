@@ -0,0 +1,92 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
+#include <future>
+#include <memory>
+#include <string>
+
+namespace gosat {
+
+/**
+ * /brief Optimizes a module generated by FPIRGenerator and jits it using
+ * ORC.
+ *
+ * Optimization levels 0-3 select both the IR pass pipeline and the codegen
+ * level. FP instructions are never given fast-math flags, so only
+ * transformations preserving IEEE semantics are applied.
+ *
+ * Every compiler is an independent JIT session owning its target machine
+ * and linked code, hence several sessions can compile and run concurrently
+ * on different threads. Code is freed when the session is destroyed.
+ */
+class FPJITCompiler {
+public:
+    FPJITCompiler() = delete;
+
+    explicit FPJITCompiler(unsigned opt_level);
+
+    virtual ~FPJITCompiler();
+
+    FPJITCompiler(const FPJITCompiler&) = delete;
+
+    FPJITCompiler& operator=(const FPJITCompiler&) = delete;
+
+    bool compile(std::unique_ptr<llvm::Module> module) noexcept;
+
+    /**
+     * /brief compiles on a background thread. The LLVMContext of module
+     * must not be used until the returned future is ready.
+     */
+    std::future<bool> compileAsync(std::unique_ptr<llvm::Module> module);
+
+    /// cached objects are looked up by module identifier, nullptr disables
+    void setObjectCache(llvm::ObjectCache* obj_cache) noexcept;
+
+    void* getFunctionAddress(const std::string& func_name) noexcept;
+
+    unsigned getOptLevel() const noexcept;
+
+    const std::string& getErrorStr() const noexcept;
+
+    /// elapsed time of IR passes in seconds
+    double getIROptTime() const noexcept;
+
+    /// elapsed time of native code generation and linking in seconds
+    double getCodeGenTime() const noexcept;
+
+    static llvm::CodeGenOpt::Level toCodeGenOptLevel(unsigned opt_level);
+
+private:
+    using ObjectLayerType = llvm::orc::ObjectLinkingLayer<>;
+    using CompileLayerType = llvm::orc::IRCompileLayer<ObjectLayerType>;
+    using ModuleHandleType = CompileLayerType::ModuleSetHandleT;
+
+    void optimizeModule(llvm::Module& module) noexcept;
+
+private:
+    const unsigned m_opt_level;
+    double m_ir_opt_time;
+    double m_codegen_time;
+    std::string m_err_str;
+    std::unique_ptr<llvm::TargetMachine> m_target_machine;
+    std::unique_ptr<ObjectLayerType> m_object_layer;
+    std::unique_ptr<CompileLayerType> m_compile_layer;
+    bool m_has_module;
+    ModuleHandleType m_module_handle;
+};
+}
@@ -0,0 +1,149 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPObjectCache.h"
+#include "CodeGen/CodeGen.h"
+#include "ExprAnalyzer/FPExprHasher.h"
+#include "Utils/FileUtils.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace gosat {
+
+// bump whenever the entry format changes, changes of generated code are
+// covered by CodeGenStr::kCodeGenVersion
+static const char* kCacheFormatVersion = "gosat-objcache-2";
+
+FPObjectCache::FPObjectCache(const std::string& cache_dir) :
+        m_cache_dir{cache_dir}
+{
+    llvm::sys::fs::create_directories(m_cache_dir);
+}
+
+std::string FPObjectCache::getDefaultCacheDir()
+{
+    const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+    if (xdg_cache_home != nullptr && xdg_cache_home[0] != '\0') {
+        return std::string(xdg_cache_home) + "/gosat";
+    }
+    const char* home = std::getenv("HOME");
+    if (home != nullptr && home[0] != '\0') {
+        return std::string(home) + "/.cache/gosat";
+    }
+    return ".gosat-cache";
+}
+
+std::string
+FPObjectCache::genKey
+        (uint64_t expr_hash, unsigned opt_level,
+         const std::vector<std::string>& entry_points) const
+{
+    std::string target_str = kCacheFormatVersion;
+    target_str += CodeGenStr::kCodeGenVersion;
+    target_str += LLVM_VERSION_STRING;
+    target_str += llvm::sys::getHostCPUName();
+    llvm::StringMap<bool> host_features;
+    if (llvm::sys::getHostCPUFeatures(host_features)) {
+        // StringMap iteration order is unspecified
+        std::vector<std::string> features;
+        for (const auto& feature : host_features) {
+            features.push_back((feature.second ? "+" : "-") +
+                               feature.first().str());
+        }
+        std::sort(features.begin(), features.end());
+        for (const auto& feature : features) {
+            target_str += feature;
+        }
+    }
+    target_str += std::to_string(opt_level);
+    std::vector<std::string> entry_names(entry_points);
+    std::sort(entry_names.begin(), entry_names.end());
+    for (const auto& entry_name : entry_names) {
+        // names can not contain a comma
+        target_str += "," + entry_name;
+    }
+    return FPExprHasher::toHexString(expr_hash) + "-" +
+           FPExprHasher::toHexString(FPExprHasher::hashString(target_str));
+}
+
+std::string FPObjectCache::getFilePath
+        (const std::string& key, const char* extension) const
+{
+    return m_cache_dir + "/" + key + extension;
+}
+
+bool FPObjectCache::lookup
+        (const std::string& key, unsigned node_count, unsigned fp_var_count,
+         FPObjectCacheEntry* entry) const
+{
+    if (!llvm::sys::fs::exists(getFilePath(key, ".o"))) {
+        return false;
+    }
+    std::ifstream meta_file(getFilePath(key, ".meta"));
+    unsigned var_count;
+    unsigned has_unsupported_expr;
+    unsigned stored_node_count;
+    unsigned stored_fp_var_count;
+    char separator;
+    if (!(meta_file >> var_count >> separator >> has_unsupported_expr
+                    >> separator >> stored_node_count >> separator
+                    >> stored_fp_var_count)) {
+        return false;
+    }
+    if (stored_node_count != node_count ||
+        stored_fp_var_count != fp_var_count) {
+        // collision of formula hashes
+        return false;
+    }
+    entry->VarCount = var_count;
+    entry->HasUnsupportedExpr = has_unsupported_expr != 0;
+    entry->NodeCount = node_count;
+    entry->FPVarCount = fp_var_count;
+    return true;
+}
+
+void FPObjectCache::storeEntry
+        (const std::string& key, const FPObjectCacheEntry& entry)
+{
+    std::string meta_data = std::to_string(entry.VarCount) + "," +
+                            (entry.HasUnsupportedExpr ? "1" : "0") + "," +
+                            std::to_string(entry.NodeCount) + "," +
+                            std::to_string(entry.FPVarCount) + "\n";
+    file_util::writeFileAtomically(getFilePath(key, ".meta"),
+                                   meta_data.data(), meta_data.size());
+}
+
+void FPObjectCache::notifyObjectCompiled
+        (const llvm::Module* module, llvm::MemoryBufferRef obj)
+{
+    const llvm::StringRef data = obj.getBuffer();
+    file_util::writeFileAtomically
+            (getFilePath(module->getModuleIdentifier(), ".o"), data.data(),
+             data.size());
+}
+
+std::unique_ptr<llvm::MemoryBuffer>
+FPObjectCache::getObject(const llvm::Module* module)
+{
+    auto buffer = llvm::MemoryBuffer::getFile
+            (getFilePath(module->getModuleIdentifier(), ".o"));
+    if (!buffer) {
+        return nullptr;
+    }
+    return std::move(buffer.get());
+}
+}
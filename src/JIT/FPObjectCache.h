@@ -0,0 +1,84 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Facts about a cached objective function which are otherwise
+ * obtained from FPIRGenerator
+ */
+struct FPObjectCacheEntry {
+    unsigned VarCount;
+    bool HasUnsupportedExpr;
+    /// size of the formula, compared on lookup since keys rely on a 64-bit
+    /// hash, see FPExprAnalyzer::countNodes and fpa_util::collectFPVars
+    unsigned NodeCount;
+    unsigned FPVarCount;
+};
+
+/**
+ * /brief Persistent on-disk cache of jitted objective functions.
+ *
+ * Objects are looked up by module identifier, which should be set to a
+ * key obtained from genKey(). Each key maps to an object file and a
+ * small meta data file describing the objective function. The meta data
+ * also holds the size of the formula, so a collision of formula hashes is
+ * detected unless the formulas have equal sizes as well.
+ */
+class FPObjectCache : public llvm::ObjectCache {
+public:
+    FPObjectCache() = delete;
+
+    explicit FPObjectCache(const std::string& cache_dir);
+
+    virtual ~FPObjectCache() = default;
+
+    FPObjectCache(const FPObjectCache&) = delete;
+
+    FPObjectCache& operator=(const FPObjectCache&) = delete;
+
+    /**
+     * /brief key covers formula hash, LLVM version, host cpu and its
+     * features, optimization level, and the names of the functions held
+     * by the object, e.g., CodeGenStr::kFunName
+     */
+    std::string genKey
+            (uint64_t expr_hash, unsigned opt_level,
+             const std::vector<std::string>& entry_points) const;
+
+    /// a hit requires the entry of key to have node_count and fp_var_count
+    bool lookup(const std::string& key, unsigned node_count,
+                unsigned fp_var_count, FPObjectCacheEntry* entry) const;
+
+    void storeEntry(const std::string& key, const FPObjectCacheEntry& entry);
+
+    void notifyObjectCompiled
+            (const llvm::Module* module, llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<llvm::MemoryBuffer>
+    getObject(const llvm::Module* module) override;
+
+    static std::string getDefaultCacheDir();
+
+private:
+    std::string getFilePath
+            (const std::string& key, const char* extension) const;
+
+private:
+    std::string m_cache_dir;
+};
+}
@@ -0,0 +1,111 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPTieredFunction.h"
+#include <cmath>
+
+namespace gosat {
+
+static std::atomic<unsigned long> g_tiered_func_count{0};
+
+FPTieredFunction::FPTieredFunction
+        (std::unique_ptr<FPIRInterpreter> interpreter) :
+        m_id{++g_tiered_func_count},
+        m_interpreter{std::move(interpreter)},
+        m_jit_func{nullptr},
+        m_best_value{HUGE_VAL},
+        m_best_tier{ExecTier::kInterpreter}
+{}
+
+double FPTieredFunction::evalFunc
+        (unsigned n, const double* x, double* grad, void* data)
+{
+    auto tiered_func = static_cast<FPTieredFunction*>(data);
+    // pairs with the release store of setJITFunction, code is visible
+    // once its address is
+    auto jit_func = tiered_func->m_jit_func.load(std::memory_order_acquire);
+    EvalCounts* counts = tiered_func->getThreadCounts();
+    // no other thread writes these counters, a plain increment suffices
+    auto increment = [](std::atomic<unsigned long>& count) {
+        count.store(count.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    };
+    double result;
+    ExecTier tier;
+    if (jit_func != nullptr) {
+        result = jit_func(n, x, grad, nullptr);
+        increment(counts->JITCount);
+        tier = ExecTier::kJIT;
+    } else {
+        result = tiered_func->m_interpreter->eval(x);
+        increment(counts->InterpreterCount);
+        tier = ExecTier::kInterpreter;
+    }
+    if (result < tiered_func->m_best_value.load(std::memory_order_relaxed)) {
+        tiered_func->updateBest(result, tier);
+    }
+    return result;
+}
+
+FPTieredFunction::EvalCounts* FPTieredFunction::getThreadCounts()
+{
+    // counters of the function last evaluated by this thread
+    thread_local unsigned long cached_id = 0;
+    thread_local EvalCounts* cached_counts = nullptr;
+    if (cached_id != m_id) {
+        std::lock_guard<std::mutex> lock(m_counts_mutex);
+        m_eval_counts.emplace_back(new EvalCounts{{0}, {0}, {}});
+        cached_counts = m_eval_counts.back().get();
+        cached_id = m_id;
+    }
+    return cached_counts;
+}
+
+void FPTieredFunction::updateBest(double value, ExecTier tier) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_best_mutex);
+    if (value < m_best_value.load(std::memory_order_relaxed)) {
+        m_best_value.store(value, std::memory_order_relaxed);
+        m_best_tier = tier;
+    }
+}
+
+void FPTieredFunction::setJITFunction(nlopt_func func) noexcept
+{
+    m_jit_func.store(func, std::memory_order_release);
+}
+
+bool FPTieredFunction::isJITReady() const noexcept
+{
+    return m_jit_func.load(std::memory_order_acquire) != nullptr;
+}
+
+unsigned long FPTieredFunction::getEvalCount(ExecTier tier) const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_counts_mutex);
+    unsigned long result = 0;
+    for (const auto& counts : m_eval_counts) {
+        result += (tier == ExecTier::kJIT) ?
+                  counts->JITCount.load(std::memory_order_relaxed) :
+                  counts->InterpreterCount.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+ExecTier FPTieredFunction::getBestTier() const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_best_mutex);
+    return m_best_tier;
+}
+
+const char* FPTieredFunction::getTierName(ExecTier tier) noexcept
+{
+    return (tier == ExecTier::kJIT) ? "jit" : "interpreter";
+}
+}
@@ -0,0 +1,88 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "FPIRInterpreter.h"
+#include <nlopt.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gosat {
+
+enum class ExecTier {
+    kInterpreter,
+    kJIT
+};
+
+/**
+ * /brief Objective function evaluated by the interpreter until its jitted
+ * version becomes available. The jitted function can be set by another
+ * thread at any time while the objective is being evaluated.
+ *
+ * Evaluations are counted per tier, and the tier which produced the best
+ * value so far is tracked. Each thread counts its evaluations on its own
+ * counters, which are summed by getEvalCount, hence, threads evaluating
+ * concurrently do not contend on shared counters.
+ */
+class FPTieredFunction {
+public:
+    FPTieredFunction() = delete;
+
+    explicit FPTieredFunction(std::unique_ptr<FPIRInterpreter> interpreter);
+
+    virtual ~FPTieredFunction() = default;
+
+    FPTieredFunction(const FPTieredFunction&) = delete;
+
+    FPTieredFunction& operator=(const FPTieredFunction&) = delete;
+
+    /// same signature as nlopt_func, data points to the tiered function
+    static double
+    evalFunc(unsigned n, const double* x, double* grad, void* data);
+
+    /// following evaluations are served by func
+    void setJITFunction(nlopt_func func) noexcept;
+
+    bool isJITReady() const noexcept;
+
+    unsigned long getEvalCount(ExecTier tier) const noexcept;
+
+    /// tier of the evaluation which produced the smallest value so far
+    ExecTier getBestTier() const noexcept;
+
+    static const char* getTierName(ExecTier tier) noexcept;
+
+private:
+    /// written by a single thread only, padded to a cache line of its own
+    struct EvalCounts {
+        std::atomic<unsigned long> InterpreterCount;
+        std::atomic<unsigned long> JITCount;
+        char Padding[64];
+    };
+
+    void updateBest(double value, ExecTier tier) noexcept;
+
+    /// counters of the calling thread, registered on its first evaluation
+    EvalCounts* getThreadCounts();
+
+private:
+    /// unlike addresses, ids of destroyed functions are never reused
+    const unsigned long m_id;
+    std::unique_ptr<FPIRInterpreter> m_interpreter;
+    std::atomic<nlopt_func> m_jit_func;
+    mutable std::mutex m_counts_mutex;
+    std::vector<std::unique_ptr<EvalCounts>> m_eval_counts;
+    std::atomic<double> m_best_value;
+    mutable std::mutex m_best_mutex;
+    ExecTier m_best_tier;
+};
+}
@@ -0,0 +1,219 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "BasinHoppingOptimizer.h"
+#include "Utils/Watchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace gosat {
+
+BHConfig::BHConfig() :
+        MaxTime{0},
+        MaxIter{100},
+        MaxLocalIter{100000},
+        RelTolerance{1e-8},
+        Temperature{1.0},
+        StepSize{0.5},
+        Interval{50},
+        AcceptRate{0.5},
+        Bound{1e9},
+        RandomSeed{0}
+{}
+
+BasinHoppingOptimizer::BasinHoppingOptimizer(unsigned thread_count) :
+        m_thread_count{std::max(thread_count, 1u)},
+        m_stats{nullptr},
+        m_func_data{nullptr}
+{}
+
+bool BasinHoppingOptimizer::isAccepted
+        (double new_min, double cur_min, double temperature,
+         double rand_value) noexcept
+{
+    if (new_min < cur_min) {
+        return true;
+    }
+    if (!(temperature > 0)) {
+        return false;
+    }
+    // false for nan
+    return rand_value < std::exp(-(new_min - cur_min) / temperature);
+}
+
+int BasinHoppingOptimizer::optimize
+        (nlopt_func func, unsigned dim, double* x, double* min) noexcept
+{
+    const double max_value = std::numeric_limits<double>::max();
+    // BOBYQA requires at least two variables
+    const nlopt_algorithm local_alg = (dim < 2) ? NLOPT_LN_SBPLX :
+                                      NLOPT_LN_BOBYQA;
+    m_worker_results.assign(m_thread_count,
+                            PortfolioWorkerResult{local_alg, 0, 0,
+                                                  max_value, 0, false, 0, 0});
+    std::vector<OptStatistics> chain_stats(m_thread_count);
+    std::vector<std::vector<double>> chain_x(m_thread_count,
+                                             std::vector<double>(x, x + dim));
+    const unsigned long base_seed = (Config.RandomSeed != 0) ?
+                                    Config.RandomSeed :
+                                    std::random_device()();
+    const bool is_boxed = (m_lower_bounds.size() == dim &&
+                           m_upper_bounds.size() == dim);
+    std::atomic<bool> is_solved{false};
+    const auto start_time = std::chrono::steady_clock::now();
+    // a single watchdog bounds all chains, instead of one per hop
+    std::unique_ptr<Watchdog> watchdog;
+    if (Config.MaxTime > 0) {
+        watchdog = std::make_unique<Watchdog>(Config.MaxTime);
+    }
+    auto chain = [&](unsigned i) {
+        auto& result = m_worker_results[i];
+        result.Seed = base_seed + i;
+        std::mt19937_64 rand_gen(result.Seed);
+        std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+        NLoptOptimizer local_opt(NLOPT_GN_DIRECT, local_alg);
+        local_opt.Config.MaxLocalEvalCount = Config.MaxLocalIter;
+        local_opt.Config.RelTolerance = Config.RelTolerance;
+        local_opt.Config.Bound = Config.Bound;
+        local_opt.Config.StepSize = Config.StepSize;
+        if (is_boxed) {
+            local_opt.Config.LowerBounds = m_lower_bounds;
+            local_opt.Config.UpperBounds = m_upper_bounds;
+        }
+        local_opt.setCancellationFlag(&is_solved);
+        if (watchdog != nullptr) {
+            local_opt.setExpiredFlag(watchdog->getExpiredFlag());
+        }
+        local_opt.setFunctionData(m_func_data);
+        if (m_stats != nullptr) {
+            chain_stats[i].StartTime = m_stats->StartTime;
+            chain_stats[i].IsTraced = m_stats->IsTraced;
+            local_opt.setStatistics(&chain_stats[i]);
+        }
+        auto minimize = [&](std::vector<double>& point, double* value) {
+            if (Config.MaxTime > 0) {
+                const double remaining_time = Config.MaxTime -
+                        std::chrono::duration<double>
+                                (std::chrono::steady_clock::now() -
+                                 start_time).count();
+                if (remaining_time <= 0) {
+                    return static_cast<int>(NLOPT_MAXTIME_REACHED);
+                }
+                local_opt.Config.MaxTime = remaining_time;
+            }
+            return local_opt.optimizeLocally(func, dim, point.data(), value);
+        };
+        auto is_stopped = [](int status) {
+            return status == NLOPT_FORCED_STOP ||
+                   NLoptOptimizer::isTimeout(status);
+        };
+        std::vector<double> cur_x(x, x + dim);
+        std::vector<double> trial_x(dim);
+        double cur_min = HUGE_VAL;
+        result.Status = minimize(cur_x, &cur_min);
+        chain_x[i] = cur_x;
+        double best_min = cur_min;
+        // status of the minimization which found the best point
+        int best_status = result.Status;
+        double step_size = Config.StepSize;
+        unsigned accept_count = 0;
+        for (unsigned iter = 1; iter <= Config.MaxIter && best_min != 0 &&
+                                !is_stopped(result.Status); ++iter) {
+            for (unsigned j = 0; j < dim; ++j) {
+                const double step = step_size * (2 * unit_dist(rand_gen) - 1);
+                const double lower = is_boxed ? m_lower_bounds[j] :
+                                     -Config.Bound;
+                const double upper = is_boxed ? m_upper_bounds[j] :
+                                     Config.Bound;
+                trial_x[j] = std::min(std::max(cur_x[j] + step, lower), upper);
+            }
+            double trial_min = HUGE_VAL;
+            result.Status = minimize(trial_x, &trial_min);
+            if (trial_min < best_min) {
+                best_min = trial_min;
+                best_status = result.Status;
+                chain_x[i] = trial_x;
+            }
+            if (isAccepted(trial_min, cur_min, Config.Temperature,
+                           unit_dist(rand_gen))) {
+                cur_x.swap(trial_x);
+                cur_min = trial_min;
+                ++accept_count;
+            }
+            if (Config.Interval != 0 && iter % Config.Interval == 0) {
+                const double accept_rate =
+                        static_cast<double>(accept_count) / Config.Interval;
+                step_size = (accept_rate > Config.AcceptRate) ?
+                            step_size / 0.9 : step_size * 0.9;
+                accept_count = 0;
+            }
+        }
+        if (best_min == 0) {
+            is_solved.store(true);
+            result.Status = NLOPT_STOPVAL_REACHED;
+        } else if (!is_stopped(result.Status)) {
+            // hops are exhausted, the chain reports how its best point was
+            // found rather than how its last hop ended
+            result.Status = best_status;
+        }
+        result.Minima = std::min(best_min, max_value);
+        result.IsCancelled = (result.Status == NLOPT_FORCED_STOP);
+        result.EvalCount = chain_stats[i].EvalCount;
+        result.ElapsedTime = getElapsedTime(start_time);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(m_thread_count);
+    for (unsigned i = 0; i < m_thread_count; ++i) {
+        threads.emplace_back(chain, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    mergeWorkerStatistics(chain_stats, m_stats);
+    return selectBestWorker(m_worker_results, chain_x, x, min);
+}
+
+const std::vector<PortfolioWorkerResult>&
+BasinHoppingOptimizer::getWorkerResults() const noexcept
+{
+    return m_worker_results;
+}
+
+unsigned BasinHoppingOptimizer::getThreadCount() const noexcept
+{
+    return m_thread_count;
+}
+
+void BasinHoppingOptimizer::setMaxTime(double max_time) noexcept
+{
+    Config.MaxTime = max_time;
+}
+
+void BasinHoppingOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void BasinHoppingOptimizer::setFunctionData(void* func_data) noexcept
+{
+    m_func_data = func_data;
+}
+
+void BasinHoppingOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                                      const std::vector<double>& upper_bounds)
+{
+    m_lower_bounds = lower_bounds;
+    m_upper_bounds = upper_bounds;
+}
+}
@@ -0,0 +1,106 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "WorkerResult.h"
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Knobs of basin hopping, defaults follow SciPy's basinhopping
+ * as used by the former Python bh_solver
+ */
+class BHConfig {
+public:
+    BHConfig();
+
+    virtual ~BHConfig() = default;
+
+    /// wall-clock limit in seconds, zero means no limit
+    double MaxTime;
+    /// number of hops of a chain
+    unsigned MaxIter;
+    /// evaluation limit of a local minimization
+    int MaxLocalIter;
+    double RelTolerance;
+    /// temperature of the Metropolis acceptance test
+    double Temperature;
+    /// initial size of random displacements
+    double StepSize;
+    /// number of hops between step size adaptations
+    unsigned Interval;
+    /// step size grows if more hops than this fraction are accepted
+    double AcceptRate;
+    double Bound;
+    /// seed of the first chain, zero uses a random seed
+    unsigned long RandomSeed;
+};
+
+/**
+ * /brief Basin hopping using NLoptOptimizer::optimizeLocally, i.e., BOBYQA,
+ * for the inner minimization. Formulas of a single variable are minimized
+ * using Sbplx instead, since BOBYQA requires at least two.
+ *
+ * A chain repeatedly displaces its current minimum randomly, minimizes
+ * locally from there, and accepts the new minimum by the Metropolis
+ * criterion. Its step size adapts to keep the acceptance rate near
+ * AcceptRate. Every thread runs an independent chain, and all chains stop
+ * as soon as one finds a zero.
+ */
+class BasinHoppingOptimizer {
+public:
+    BasinHoppingOptimizer() = delete;
+
+    explicit BasinHoppingOptimizer(unsigned thread_count);
+
+    virtual ~BasinHoppingOptimizer() = default;
+
+    BasinHoppingOptimizer(const BasinHoppingOptimizer&) = default;
+
+    BasinHoppingOptimizer& operator=(const BasinHoppingOptimizer&) = default;
+
+    int optimize
+            (nlopt_func func, unsigned dim, double* x, double* min) noexcept;
+
+    /// one result per chain
+    const std::vector<PortfolioWorkerResult>& getWorkerResults() const noexcept;
+
+    unsigned getThreadCount() const noexcept;
+
+    /// sets Config.MaxTime
+    void setMaxTime(double max_time) noexcept;
+
+    /// statistics of all chains are merged into stats
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// see NLoptOptimizer::setFunctionData
+    void setFunctionData(void* func_data) noexcept;
+
+    /// per-variable search box of displacements and local minimizations,
+    /// see OptConfig::LowerBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+private:
+    static bool isAccepted(double new_min, double cur_min, double temperature,
+                           double rand_value) noexcept;
+
+private:
+    unsigned m_thread_count;
+    OptStatistics* m_stats;
+    void* m_func_data;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+    std::vector<PortfolioWorkerResult> m_worker_results;
+public:
+    BHConfig Config;
+};
+}
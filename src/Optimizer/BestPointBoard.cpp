@@ -0,0 +1,103 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "BestPointBoard.h"
+#include <cmath>
+
+namespace gosat {
+
+BestPointBoard::BestPointBoard(unsigned slot_count, unsigned dim) :
+        m_dim{dim},
+        m_slots(slot_count),
+        m_points{new std::atomic<double>[slot_count * dim]}
+{
+    for (auto& slot : m_slots) {
+        slot.Sequence.store(0, std::memory_order_relaxed);
+        slot.Value.store(HUGE_VAL, std::memory_order_relaxed);
+    }
+    for (unsigned i = 0; i < slot_count * dim; ++i) {
+        m_points[i].store(0.0, std::memory_order_relaxed);
+    }
+}
+
+void BestPointBoard::publish
+        (unsigned slot, const double* x, double value) noexcept
+{
+    auto& cur_slot = m_slots[slot];
+    const auto sequence = cur_slot.Sequence.load(std::memory_order_relaxed);
+    cur_slot.Sequence.store(sequence + 1, std::memory_order_relaxed);
+    // orders the odd sequence before writing the point
+    std::atomic_thread_fence(std::memory_order_release);
+    auto point = m_points.get() + slot * m_dim;
+    for (unsigned i = 0; i < m_dim; ++i) {
+        point[i].store(x[i], std::memory_order_relaxed);
+    }
+    cur_slot.Value.store(value, std::memory_order_relaxed);
+    cur_slot.Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool BestPointBoard::readSlot
+        (unsigned slot, double* x, double* value) const noexcept
+{
+    const auto& cur_slot = m_slots[slot];
+    const auto sequence = cur_slot.Sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0) {
+        return false;
+    }
+    auto point = m_points.get() + slot * m_dim;
+    for (unsigned i = 0; i < m_dim; ++i) {
+        x[i] = point[i].load(std::memory_order_relaxed);
+    }
+    *value = cur_slot.Value.load(std::memory_order_relaxed);
+    // orders reading the point before checking the sequence again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return cur_slot.Sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+double BestPointBoard::fetchBest(double* x, unsigned* slot) const noexcept
+{
+    while (true) {
+        unsigned best = getSlotCount();
+        double best_value = HUGE_VAL;
+        for (unsigned i = 0; i < getSlotCount(); ++i) {
+            const double value =
+                    m_slots[i].Value.load(std::memory_order_relaxed);
+            if (value < best_value) {
+                best = i;
+                best_value = value;
+            }
+        }
+        if (best == getSlotCount()) {
+            return HUGE_VAL;
+        }
+        double value;
+        if (readSlot(best, x, &value)) {
+            if (slot != nullptr) {
+                *slot = best;
+            }
+            return value;
+        }
+    }
+}
+
+double BestPointBoard::getBestValue() const noexcept
+{
+    double best_value = HUGE_VAL;
+    for (const auto& slot : m_slots) {
+        best_value = std::fmin(best_value,
+                               slot.Value.load(std::memory_order_relaxed));
+    }
+    return best_value;
+}
+
+unsigned BestPointBoard::getSlotCount() const noexcept
+{
+    return static_cast<unsigned>(m_slots.size());
+}
+}
@@ -0,0 +1,69 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Lock-free board where concurrent searches publish their best
+ * points and fetch the best point published by any of them.
+ *
+ * Every search owns one slot which only it writes to, hence publishing is
+ * wait-free. A slot is guarded by a sequence counter; readers retry while
+ * a slot is being written, so a fetched point is never torn.
+ */
+class BestPointBoard {
+public:
+    BestPointBoard() = delete;
+
+    BestPointBoard(unsigned slot_count, unsigned dim);
+
+    virtual ~BestPointBoard() = default;
+
+    BestPointBoard(const BestPointBoard&) = delete;
+
+    BestPointBoard& operator=(const BestPointBoard&) = delete;
+
+    /// must only be called by the owner of slot
+    void publish(unsigned slot, const double* x, double value) noexcept;
+
+    /**
+     * /brief copies the best point of all slots to x
+     * /returns its value, or HUGE_VAL if nothing is published yet
+     */
+    double fetchBest(double* x, unsigned* slot = nullptr) const noexcept;
+
+    double getBestValue() const noexcept;
+
+    unsigned getSlotCount() const noexcept;
+
+private:
+    struct Slot {
+        /// odd while the slot is being written
+        std::atomic<unsigned long> Sequence;
+        std::atomic<double> Value;
+        /// slots of different searches do not share a cache line
+        char Padding[64 - sizeof(std::atomic<unsigned long>) -
+                     sizeof(std::atomic<double>)];
+    };
+
+    /// /returns false if slot was written concurrently
+    bool readSlot(unsigned slot, double* x, double* value) const noexcept;
+
+private:
+    const unsigned m_dim;
+    std::vector<Slot> m_slots;
+    std::unique_ptr<std::atomic<double>[]> m_points;
+};
+}
@@ -0,0 +1,530 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "CMAESOptimizer.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+
+namespace gosat {
+
+CMAESConfig::CMAESConfig() :
+        MaxEvalCount{500000},
+        MaxTime{0},
+        Bound{1e9},
+        InitialSigma{1.0},
+        TolFun{1e-12},
+        TolX{1e-12},
+        MaxRestarts{9},
+        IncPopSize{2},
+        UseBIPOP{true},
+        RandomSeed{0}
+{}
+
+CMAESOptimizer::CMAESOptimizer(unsigned thread_count) :
+        m_thread_count{std::max(thread_count, 1u)},
+        m_stats{nullptr},
+        m_func_data{nullptr},
+        m_batch_func{nullptr}
+{}
+
+void CMAESOptimizer::decomposeSymmetric
+        (unsigned dim, const std::vector<double>& matrix,
+         std::vector<double>* values, std::vector<double>* vectors)
+{
+    const unsigned kMaxSweepCount = 64;
+    std::vector<double> a(matrix);
+    auto& v = *vectors;
+    v.assign(dim * dim, 0.0);
+    for (unsigned i = 0; i < dim; ++i) {
+        v[i * dim + i] = 1.0;
+    }
+    const double eps = std::numeric_limits<double>::epsilon();
+    for (unsigned sweep = 0; sweep < kMaxSweepCount; ++sweep) {
+        double off_norm = 0;
+        double diag_norm = 0;
+        for (unsigned i = 0; i < dim; ++i) {
+            diag_norm += a[i * dim + i] * a[i * dim + i];
+            for (unsigned j = i + 1; j < dim; ++j) {
+                off_norm += a[i * dim + j] * a[i * dim + j];
+            }
+        }
+        if (off_norm <= eps * eps * diag_norm) {
+            break;
+        }
+        for (unsigned p = 0; p < dim; ++p) {
+            for (unsigned q = p + 1; q < dim; ++q) {
+                const double apq = a[p * dim + q];
+                if (apq == 0) {
+                    continue;
+                }
+                // rotation zeroing a[p][q], see Numerical Recipes
+                const double theta =
+                        (a[q * dim + q] - a[p * dim + p]) / (2 * apq);
+                const double t = std::copysign(1.0, theta) /
+                                 (std::fabs(theta) +
+                                  std::sqrt(theta * theta + 1));
+                const double c = 1 / std::sqrt(t * t + 1);
+                const double s = t * c;
+                for (unsigned k = 0; k < dim; ++k) {
+                    const double akp = a[k * dim + p];
+                    const double akq = a[k * dim + q];
+                    a[k * dim + p] = c * akp - s * akq;
+                    a[k * dim + q] = s * akp + c * akq;
+                }
+                for (unsigned k = 0; k < dim; ++k) {
+                    const double apk = a[p * dim + k];
+                    const double aqk = a[q * dim + k];
+                    a[p * dim + k] = c * apk - s * aqk;
+                    a[q * dim + k] = s * apk + c * aqk;
+                }
+                for (unsigned k = 0; k < dim; ++k) {
+                    const double vkp = v[k * dim + p];
+                    const double vkq = v[k * dim + q];
+                    v[k * dim + p] = c * vkp - s * vkq;
+                    v[k * dim + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    values->resize(dim);
+    for (unsigned i = 0; i < dim; ++i) {
+        (*values)[i] = a[i * dim + i];
+    }
+}
+
+int CMAESOptimizer::optimize
+        (nlopt_func func, unsigned dim, double* x, double* min) noexcept
+{
+    m_run_results.clear();
+    const auto start_time = std::chrono::steady_clock::now();
+    const unsigned long seed = (Config.RandomSeed != 0) ? Config.RandomSeed :
+                               std::random_device()();
+    std::mt19937_64 rand_gen(seed);
+    std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    const bool is_boxed = (m_lower_bounds.size() == dim &&
+                           m_upper_bounds.size() == dim);
+    // clamps the i-th coordinate of a point
+    auto clamp = [&](unsigned i, double value) {
+        const double lower = is_boxed ? m_lower_bounds[i] : -Config.Bound;
+        const double upper = is_boxed ? m_upper_bounds[i] : Config.Bound;
+        return std::min(std::max(value, lower), upper);
+    };
+    std::unique_ptr<ThreadPool> pool;
+    if (m_thread_count > 1) {
+        pool = std::make_unique<ThreadPool>(m_thread_count);
+    }
+    auto is_time_out = [&]() {
+        return Config.MaxTime > 0 &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start_time).count() >=
+               Config.MaxTime;
+    };
+    // points evaluated between two checks of the deadline
+    const unsigned kEvalChunkSize = 16;
+    // evaluates count points stored consecutively in xs. Points left once
+    // the deadline passes get HUGE_VAL, returns the number evaluated
+    auto evaluate = [&](unsigned count, const std::vector<double>& xs,
+                        std::vector<double>& values) {
+        std::atomic<unsigned> evaluated_count{0};
+        auto eval_range = [&](unsigned first, unsigned last) {
+            for (unsigned chunk = first; chunk < last;
+                 chunk += kEvalChunkSize) {
+                const unsigned chunk_last = std::min(chunk + kEvalChunkSize,
+                                                     last);
+                if (is_time_out()) {
+                    std::fill(&values[chunk], &values[0] + last, HUGE_VAL);
+                    return;
+                }
+                if (m_batch_func != nullptr) {
+                    m_batch_func(dim, chunk_last - chunk, &xs[chunk * dim],
+                                 &values[chunk]);
+                } else {
+                    for (unsigned i = chunk; i < chunk_last; ++i) {
+                        values[i] = func(dim, &xs[i * dim], nullptr,
+                                         m_func_data);
+                    }
+                }
+                for (unsigned i = chunk; i < chunk_last; ++i) {
+                    if (std::isnan(values[i])) {
+                        values[i] = HUGE_VAL;
+                    }
+                }
+                evaluated_count += chunk_last - chunk;
+            }
+        };
+        const unsigned job_count = std::min(m_thread_count, count);
+        if (job_count <= 1) {
+            eval_range(0, count);
+            return evaluated_count.load();
+        }
+        for (unsigned job = 0; job < job_count; ++job) {
+            pool->submit([&, job](unsigned) {
+                eval_range(count * job / job_count,
+                           count * (job + 1) / job_count);
+            });
+        }
+        pool->wait();
+        return evaluated_count.load();
+    };
+
+    const unsigned n = dim;
+    std::vector<double> best_x(x, x + n);
+    for (unsigned i = 0; i < n; ++i) {
+        best_x[i] = clamp(i, best_x[i]);
+    }
+    double best_min = HUGE_VAL;
+    unsigned long eval_count = 0;
+    const unsigned default_lambda =
+            4 + static_cast<unsigned>(3 * std::log(static_cast<double>(n)));
+    unsigned large_lambda = default_lambda;
+    unsigned long large_eval_count = 0;
+    unsigned long small_eval_count = 0;
+    bool is_budget_exhausted = false;
+    bool is_timed_out = false;
+
+    for (unsigned run = 0; run <= Config.MaxRestarts; ++run) {
+        // BIPOP alternates regimes such that both spend similar budgets
+        bool is_small_regime = false;
+        unsigned lambda = default_lambda;
+        double sigma_factor = 1.0;
+        if (run > 0) {
+            if (Config.UseBIPOP && small_eval_count < large_eval_count) {
+                is_small_regime = true;
+                const double u = unit_dist(rand_gen);
+                lambda = std::max(default_lambda, static_cast<unsigned>(
+                        default_lambda *
+                        std::pow(0.5 * large_lambda / default_lambda,
+                                 u * u)));
+                sigma_factor = std::pow(10.0, -2 * unit_dist(rand_gen));
+            } else {
+                large_lambda *= std::max(Config.IncPopSize, 1u);
+                lambda = large_lambda;
+            }
+        }
+        std::vector<double> mean(best_x);
+        if (run > 0) {
+            // large magnitudes are as likely as small ones
+            const double max_exp = std::log10(std::max(Config.Bound, 1.0));
+            for (unsigned i = 0; i < n; ++i) {
+                const double magnitude =
+                        std::pow(10.0, max_exp * unit_dist(rand_gen));
+                const double value = (unit_dist(rand_gen) < 0.5) ?
+                                     -magnitude : magnitude;
+                if (is_boxed && value != clamp(i, value)) {
+                    // narrow boxes are sampled uniformly instead
+                    mean[i] = m_lower_bounds[i] + unit_dist(rand_gen) *
+                              (m_upper_bounds[i] - m_lower_bounds[i]);
+                } else {
+                    mean[i] = clamp(i, value);
+                }
+            }
+        }
+        double max_mean = 0;
+        for (const auto value : mean) {
+            max_mean = std::max(max_mean, std::fabs(value));
+        }
+        double sigma = Config.InitialSigma * sigma_factor *
+                       std::max(1.0, max_mean / 10);
+        if (is_boxed) {
+            // steps much wider than the box would mostly be clamped
+            double max_width = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                max_width = std::max(max_width,
+                                     m_upper_bounds[i] - m_lower_bounds[i]);
+            }
+            if (max_width > 0) {
+                sigma = std::min(sigma, max_width / 4);
+            }
+        }
+        CMAESRunResult run_result{lambda, sigma, HUGE_VAL, 0, 0};
+
+        // strategy parameters following Hansen's tutorial
+        const unsigned mu = lambda / 2;
+        std::vector<double> weights(mu);
+        for (unsigned i = 0; i < mu; ++i) {
+            weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+        }
+        const double weight_sum =
+                std::accumulate(weights.cbegin(), weights.cend(), 0.0);
+        double weight_sq_sum = 0;
+        for (auto& weight : weights) {
+            weight /= weight_sum;
+            weight_sq_sum += weight * weight;
+        }
+        const double mueff = 1 / weight_sq_sum;
+        const double cc = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+        const double cs = (mueff + 2) / (n + mueff + 5);
+        const double c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff);
+        const double cmu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) /
+                                            ((n + 2.0) * (n + 2.0) + mueff));
+        const double damps =
+                1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (n + 1)) - 1) +
+                cs;
+        const double chi_n =
+                std::sqrt(static_cast<double>(n)) *
+                (1 - 1 / (4.0 * n) + 1 / (21.0 * n * n));
+        const unsigned history_size = 10 + (30 * n + lambda - 1) / lambda;
+        const unsigned max_stall_count = 120 + (30 * n + lambda - 1) / lambda;
+
+        std::vector<double> pc(n, 0.0);
+        std::vector<double> ps(n, 0.0);
+        std::vector<double> cov(n * n, 0.0);
+        std::vector<double> basis(n * n, 0.0);
+        std::vector<double> inv_sqrt_cov(n * n, 0.0);
+        std::vector<double> scales(n, 1.0);
+        for (unsigned i = 0; i < n; ++i) {
+            cov[i * n + i] = 1.0;
+            basis[i * n + i] = 1.0;
+            inv_sqrt_cov[i * n + i] = 1.0;
+        }
+        std::vector<double> eigen_values;
+        std::vector<double> xs(lambda * n);
+        std::vector<double> values(lambda);
+        std::vector<unsigned> order(lambda);
+        std::vector<double> z(n);
+        std::vector<double> step(n);
+        std::vector<double> old_mean(n);
+        std::deque<double> history;
+        unsigned long run_eval_count = 0;
+        unsigned long eigen_eval_count = 0;
+        unsigned stall_count = 0;
+        bool is_run_stopped = false;
+        while (!is_run_stopped) {
+            if (eval_count + lambda > static_cast<unsigned long>(
+                    std::max(Config.MaxEvalCount, 0))) {
+                is_budget_exhausted = true;
+                break;
+            }
+            if (is_time_out()) {
+                is_timed_out = true;
+                break;
+            }
+            if (run_eval_count - eigen_eval_count >
+                lambda / (c1 + cmu) / n / 10) {
+                eigen_eval_count = run_eval_count;
+                decomposeSymmetric(n, cov, &eigen_values, &basis);
+                const auto min_max = std::minmax_element(eigen_values.cbegin(),
+                                                         eigen_values.cend());
+                if (!(*min_max.first > 0) || !std::isfinite(*min_max.second) ||
+                    *min_max.second > 1e14 * *min_max.first) {
+                    // degenerated or ill-conditioned covariance
+                    break;
+                }
+                for (unsigned i = 0; i < n; ++i) {
+                    scales[i] = std::sqrt(eigen_values[i]);
+                }
+                for (unsigned i = 0; i < n; ++i) {
+                    for (unsigned j = 0; j < n; ++j) {
+                        double sum = 0;
+                        for (unsigned k = 0; k < n; ++k) {
+                            sum += basis[i * n + k] * basis[j * n + k] /
+                                   scales[k];
+                        }
+                        inv_sqrt_cov[i * n + j] = sum;
+                    }
+                }
+            }
+            // sample x = mean + sigma * B * D * z
+            for (unsigned k = 0; k < lambda; ++k) {
+                for (unsigned j = 0; j < n; ++j) {
+                    z[j] = scales[j] * normal_dist(rand_gen);
+                }
+                for (unsigned i = 0; i < n; ++i) {
+                    double sum = 0;
+                    for (unsigned j = 0; j < n; ++j) {
+                        sum += basis[i * n + j] * z[j];
+                    }
+                    xs[k * n + i] = clamp(i, mean[i] + sigma * sum);
+                }
+            }
+            const unsigned evaluated_count = evaluate(lambda, xs, values);
+            eval_count += evaluated_count;
+            run_eval_count += evaluated_count;
+            ++run_result.GenerationCount;
+            std::iota(order.begin(), order.end(), 0u);
+            std::sort(order.begin(), order.end(),
+                      [&values](unsigned lhs, unsigned rhs) {
+                          return values[lhs] < values[rhs];
+                      });
+            const double gen_best = values[order[0]];
+            if (m_stats != nullptr) {
+                m_stats->EvalCount += evaluated_count;
+            }
+            if (gen_best < best_min) {
+                best_min = gen_best;
+                std::copy(&xs[order[0] * n], &xs[order[0] * n] + n,
+                          best_x.begin());
+                if (m_stats != nullptr && m_stats->IsTraced) {
+                    m_stats->BestTrace.emplace_back(
+                            std::chrono::duration<double>(
+                                    std::chrono::steady_clock::now() -
+                                    m_stats->StartTime).count(), gen_best);
+                }
+            }
+            if (gen_best < run_result.Minima) {
+                run_result.Minima = gen_best;
+                stall_count = 0;
+            } else {
+                ++stall_count;
+            }
+            if (best_min == 0) {
+                break;
+            }
+            if (evaluated_count < lambda) {
+                // the deadline passed within the generation
+                is_timed_out = true;
+                break;
+            }
+
+            // recombination and evolution paths
+            old_mean = mean;
+            for (unsigned i = 0; i < n; ++i) {
+                double sum = 0;
+                for (unsigned k = 0; k < mu; ++k) {
+                    sum += weights[k] * xs[order[k] * n + i];
+                }
+                step[i] = (sum - old_mean[i]) / sigma;
+                mean[i] = sum;
+            }
+            double ps_norm = 0;
+            for (unsigned i = 0; i < n; ++i) {
+                double sum = 0;
+                for (unsigned j = 0; j < n; ++j) {
+                    sum += inv_sqrt_cov[i * n + j] * step[j];
+                }
+                ps[i] = (1 - cs) * ps[i] +
+                        std::sqrt(cs * (2 - cs) * mueff) * sum;
+                ps_norm += ps[i] * ps[i];
+            }
+            ps_norm = std::sqrt(ps_norm);
+            const double hsig =
+                    (ps_norm /
+                     std::sqrt(1 - std::pow(1 - cs, 2.0 * run_eval_count /
+                                                    lambda)) /
+                     chi_n < 1.4 + 2 / (n + 1.0)) ? 1.0 : 0.0;
+            for (unsigned i = 0; i < n; ++i) {
+                pc[i] = (1 - cc) * pc[i] +
+                        hsig * std::sqrt(cc * (2 - cc) * mueff) * step[i];
+            }
+
+            // rank-one and rank-mu update of the covariance
+            const double old_factor =
+                    1 - c1 - cmu + (1 - hsig) * c1 * cc * (2 - cc);
+            for (unsigned i = 0; i < n; ++i) {
+                for (unsigned j = 0; j <= i; ++j) {
+                    double rank_mu = 0;
+                    for (unsigned k = 0; k < mu; ++k) {
+                        const double* point = &xs[order[k] * n];
+                        rank_mu += weights[k] *
+                                   (point[i] - old_mean[i]) *
+                                   (point[j] - old_mean[j]);
+                    }
+                    const double value = old_factor * cov[i * n + j] +
+                                         c1 * pc[i] * pc[j] +
+                                         cmu * rank_mu / (sigma * sigma);
+                    cov[i * n + j] = value;
+                    cov[j * n + i] = value;
+                }
+            }
+            sigma *= std::exp((cs / damps) * (ps_norm / chi_n - 1));
+
+            // termination criteria of the run
+            history.push_back(gen_best);
+            if (history.size() > history_size) {
+                history.pop_front();
+            }
+            const auto hist_range = std::minmax_element(history.cbegin(),
+                                                        history.cend());
+            const double max_value = std::max(*hist_range.second,
+                                              values[order[lambda - 1]]);
+            double max_std = 0;
+            double max_mean_value = 1.0;
+            for (unsigned i = 0; i < n; ++i) {
+                max_std = std::max(max_std, std::sqrt(cov[i * n + i]));
+                max_mean_value = std::max(max_mean_value, std::fabs(mean[i]));
+            }
+            is_run_stopped =
+                    (history.size() == history_size &&
+                     max_value - *hist_range.first < Config.TolFun) ||
+                    sigma * max_std < Config.TolX * max_mean_value ||
+                    !std::isfinite(sigma) ||
+                    stall_count > max_stall_count;
+        }
+        run_result.EvalCount = run_eval_count;
+        m_run_results.push_back(run_result);
+        if (is_small_regime) {
+            small_eval_count += run_eval_count;
+        } else {
+            large_eval_count += run_eval_count;
+        }
+        if (best_min == 0 || is_budget_exhausted || is_timed_out) {
+            break;
+        }
+    }
+    std::copy(best_x.cbegin(), best_x.cend(), x);
+    *min = best_min;
+    if (best_min == 0) {
+        return NLOPT_STOPVAL_REACHED;
+    }
+    if (is_timed_out) {
+        return NLOPT_MAXTIME_REACHED;
+    }
+    if (is_budget_exhausted) {
+        return NLOPT_MAXEVAL_REACHED;
+    }
+    return NLOPT_SUCCESS;
+}
+
+const std::vector<CMAESRunResult>&
+CMAESOptimizer::getRunResults() const noexcept
+{
+    return m_run_results;
+}
+
+unsigned CMAESOptimizer::getThreadCount() const noexcept
+{
+    return m_thread_count;
+}
+
+void CMAESOptimizer::setMaxTime(double max_time) noexcept
+{
+    Config.MaxTime = max_time;
+}
+
+void CMAESOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void CMAESOptimizer::setFunctionData(void* func_data) noexcept
+{
+    m_func_data = func_data;
+}
+
+void CMAESOptimizer::setBatchFunction(BatchFunc batch_func) noexcept
+{
+    m_batch_func = batch_func;
+}
+
+void CMAESOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                               const std::vector<double>& upper_bounds)
+{
+    m_lower_bounds = lower_bounds;
+    m_upper_bounds = upper_bounds;
+}
+}
@@ -0,0 +1,132 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "NLoptOptimizer.h"
+#include <vector>
+
+namespace gosat {
+
+class CMAESConfig {
+public:
+    CMAESConfig();
+
+    virtual ~CMAESConfig() = default;
+
+    /// evaluation budget shared by all runs
+    int MaxEvalCount;
+    /// wall-clock limit in seconds, zero means no limit
+    double MaxTime;
+    double Bound;
+    /// step size of a run, scaled up for runs starting at large magnitudes
+    double InitialSigma;
+    /// a run stops once its values of recent generations differ less
+    double TolFun;
+    /// a run stops once its steps are smaller relative to its mean
+    double TolX;
+    /// restarts after the first run
+    unsigned MaxRestarts;
+    /// factor of population growth per large-population restart
+    unsigned IncPopSize;
+    /// alternate small-population runs with growing ones, otherwise IPOP
+    bool UseBIPOP;
+    /// zero uses a random seed
+    unsigned long RandomSeed;
+};
+
+/**
+ * /brief Result of a single CMA-ES run
+ */
+struct CMAESRunResult {
+    unsigned PopulationSize;
+    double InitialSigma;
+    double Minima;
+    unsigned long EvalCount;
+    unsigned GenerationCount;
+};
+
+/**
+ * /brief CMA-ES, i.e., evolution strategy with covariance matrix adaptation,
+ * with IPOP or BIPOP restarts.
+ *
+ * Unlike NLopt's algorithms, CMA-ES learns a full covariance model of
+ * successful steps, which suits the ill-conditioned and coupled landscapes
+ * of formulas over several variables. Samples are clamped to
+ * [-Bound, Bound], or to the box given by setBounds. The first run starts
+ * from the given point, restarts start from a random point whose magnitude
+ * is log-uniformly distributed unless that falls outside of the box, where
+ * points are uniformly distributed. The
+ * population of a generation is evaluated in parallel on a thread pool,
+ * hence, the objective function must be free of side effects. Each thread
+ * evaluates its slice of the population in chunks, using a call of the batch
+ * function per chunk if one is set. The deadline is checked before each
+ * chunk, points left unevaluated end the generation and the search.
+ */
+class CMAESOptimizer {
+public:
+    CMAESOptimizer() = delete;
+
+    explicit CMAESOptimizer(unsigned thread_count);
+
+    virtual ~CMAESOptimizer() = default;
+
+    CMAESOptimizer(const CMAESOptimizer&) = default;
+
+    CMAESOptimizer& operator=(const CMAESOptimizer&) = default;
+
+    int optimize
+            (nlopt_func func, unsigned dim, double* x, double* min) noexcept;
+
+    /// runs of the last call to optimize in order
+    const std::vector<CMAESRunResult>& getRunResults() const noexcept;
+
+    unsigned getThreadCount() const noexcept;
+
+    /// sets Config.MaxTime
+    void setMaxTime(double max_time) noexcept;
+
+    /// evaluation counts and improvements are recorded per generation
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// see NLoptOptimizer::setFunctionData
+    void setFunctionData(void* func_data) noexcept;
+
+    /**
+     * /brief the population is evaluated using batch_func instead of the
+     * objective function passed to optimize unless it is null. Both must
+     * compute the same objective, func_data is not passed to batch_func.
+     */
+    void setBatchFunction(BatchFunc batch_func) noexcept;
+
+    /// per-variable search box, see OptConfig::LowerBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+    /**
+     * /brief computes eigenvalues and orthonormal eigenvectors (columns of
+     * vectors) of the symmetric dim x dim row-major matrix using cyclic
+     * Jacobi rotations
+     */
+    static void decomposeSymmetric
+            (unsigned dim, const std::vector<double>& matrix,
+             std::vector<double>* values, std::vector<double>* vectors);
+
+private:
+    unsigned m_thread_count;
+    OptStatistics* m_stats;
+    void* m_func_data;
+    BatchFunc m_batch_func;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+    std::vector<CMAESRunResult> m_run_results;
+public:
+    CMAESConfig Config;
+};
+}
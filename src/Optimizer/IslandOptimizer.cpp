@@ -0,0 +1,188 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "IslandOptimizer.h"
+#include "BestPointBoard.h"
+#include "Utils/Watchdog.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace gosat {
+
+IslandOptimizer::IslandOptimizer(unsigned thread_count) :
+        m_thread_count{std::max(thread_count, 1u)},
+        m_epoch_count{10},
+        m_max_time{0},
+        m_stats{nullptr},
+        m_func_data{nullptr}
+{}
+
+void IslandOptimizer::addIsland(nlopt_algorithm opt_alg, unsigned long seed)
+{
+    assert(NLoptOptimizer::isSupportedGlobalOptAlg(opt_alg)
+           && "Unsupported global optimization algorithm");
+    m_islands.emplace_back(std::make_pair(opt_alg, seed));
+}
+
+void IslandOptimizer::addDefaultIslands()
+{
+    // DIRECT ignores the starting point, hence it can not import migrants
+    const nlopt_algorithm algorithms[] = {NLOPT_GN_CRS2_LM, NLOPT_GN_ISRES,
+                                          NLOPT_G_MLSL};
+    for (unsigned i = 0; i < m_thread_count; ++i) {
+        addIsland(algorithms[i % 3], i + 1);
+    }
+}
+
+int IslandOptimizer::optimize
+        (nlopt_func func, unsigned dim, double* x, double* min) noexcept
+{
+    if (m_islands.empty()) {
+        addDefaultIslands();
+    }
+    const auto island_count = static_cast<unsigned>(m_islands.size());
+    const double max_value = std::numeric_limits<double>::max();
+    m_worker_results.assign(island_count,
+                            PortfolioWorkerResult{NLOPT_GN_CRS2_LM, 0, 0,
+                                                  max_value, 0, false, 0, 0});
+    std::vector<OptStatistics> island_stats(island_count);
+    std::vector<std::vector<double>> island_x(island_count,
+                                              std::vector<double>(x, x + dim));
+    BestPointBoard board(island_count, dim);
+    std::atomic<bool> is_solved{false};
+    const auto start_time = std::chrono::steady_clock::now();
+    // a single watchdog bounds all workers, instead of one per NLopt run
+    std::unique_ptr<Watchdog> watchdog;
+    if (m_max_time > 0) {
+        watchdog = std::make_unique<Watchdog>(m_max_time);
+    }
+    auto island = [&](unsigned i) {
+        auto& result = m_worker_results[i];
+        result.Algorithm = m_islands[i].first;
+        result.Seed = m_islands[i].second;
+        const int epoch_eval_count = std::max(
+                OptConfig(m_islands[i].first, NLOPT_LN_BOBYQA).MaxEvalCount /
+                static_cast<int>(m_epoch_count), 1);
+        std::vector<double> cur_x(x, x + dim);
+        std::vector<double> migrant_x(dim);
+        double best_minima = HUGE_VAL;
+        if (m_stats != nullptr) {
+            island_stats[i].StartTime = m_stats->StartTime;
+            island_stats[i].IsTraced = m_stats->IsTraced;
+        }
+        for (unsigned epoch = 0; epoch < m_epoch_count; ++epoch) {
+            NLoptOptimizer nl_opt(m_islands[i].first);
+            nl_opt.Config.MaxEvalCount = epoch_eval_count;
+            // epochs explore different populations
+            nl_opt.Config.RandomSeed = m_islands[i].second +
+                                       epoch * island_count;
+            if (m_max_time > 0) {
+                const double remaining_time = m_max_time -
+                        std::chrono::duration<double>
+                                (std::chrono::steady_clock::now() -
+                                 start_time).count();
+                if (remaining_time <= 0) {
+                    result.Status = NLOPT_MAXTIME_REACHED;
+                    break;
+                }
+                nl_opt.Config.MaxTime = remaining_time;
+            }
+            nl_opt.setCancellationFlag(&is_solved);
+            if (watchdog != nullptr) {
+                nl_opt.setExpiredFlag(watchdog->getExpiredFlag());
+            }
+            nl_opt.setFunctionData(m_func_data);
+            nl_opt.Config.LowerBounds = m_lower_bounds;
+            nl_opt.Config.UpperBounds = m_upper_bounds;
+            if (m_stats != nullptr) {
+                nl_opt.setStatistics(&island_stats[i]);
+            }
+            double minima = 1.0;
+            result.Status = nl_opt.optimize(func, dim, cur_x.data(), &minima);
+            if (minima < best_minima) {
+                best_minima = minima;
+                island_x[i] = cur_x;
+                board.publish(i, cur_x.data(), minima);
+            }
+            if (minima == 0) {
+                is_solved.store(true);
+                break;
+            }
+            if (result.Status == NLOPT_FORCED_STOP ||
+                NLoptOptimizer::isTimeout(result.Status)) {
+                break;
+            }
+            // migration, the best point of all islands seeds the next epoch
+            if (board.fetchBest(migrant_x.data()) < best_minima) {
+                cur_x = migrant_x;
+                ++result.ImportCount;
+            } else {
+                cur_x = island_x[i];
+            }
+        }
+        result.Minima = std::min(best_minima, max_value);
+        result.IsCancelled = (result.Status == NLOPT_FORCED_STOP);
+        result.EvalCount = island_stats[i].EvalCount;
+        result.ElapsedTime = getElapsedTime(start_time);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(island_count);
+    for (unsigned i = 0; i < island_count; ++i) {
+        threads.emplace_back(island, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    mergeWorkerStatistics(island_stats, m_stats);
+    return selectBestWorker(m_worker_results, island_x, x, min);
+}
+
+const std::vector<PortfolioWorkerResult>&
+IslandOptimizer::getWorkerResults() const noexcept
+{
+    return m_worker_results;
+}
+
+unsigned IslandOptimizer::getThreadCount() const noexcept
+{
+    return m_thread_count;
+}
+
+void IslandOptimizer::setEpochCount(unsigned epoch_count) noexcept
+{
+    m_epoch_count = std::max(epoch_count, 1u);
+}
+
+void IslandOptimizer::setMaxTime(double max_time) noexcept
+{
+    m_max_time = max_time;
+}
+
+void IslandOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void IslandOptimizer::setFunctionData(void* func_data) noexcept
+{
+    m_func_data = func_data;
+}
+
+void IslandOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                                const std::vector<double>& upper_bounds)
+{
+    m_lower_bounds = lower_bounds;
+    m_upper_bounds = upper_bounds;
+}
+}
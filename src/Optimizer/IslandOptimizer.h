@@ -0,0 +1,80 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "WorkerResult.h"
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Island model where every thread runs its own NLoptOptimizer and
+ * islands cooperate through migration.
+ *
+ * The evaluation budget of an island is split into epochs. After every
+ * epoch, an island publishes its best point to a BestPointBoard and restarts
+ * from the best point of all islands if it is better than its own, i.e.,
+ * the best point migrates. Islands differ in algorithm and seed, and every
+ * epoch is reseeded. All islands are stopped as soon as one finds a zero.
+ */
+class IslandOptimizer {
+public:
+    IslandOptimizer() = delete;
+
+    explicit IslandOptimizer(unsigned thread_count);
+
+    virtual ~IslandOptimizer() = default;
+
+    IslandOptimizer(const IslandOptimizer&) = default;
+
+    IslandOptimizer& operator=(const IslandOptimizer&) = default;
+
+    void addIsland(nlopt_algorithm opt_alg, unsigned long seed);
+
+    int optimize
+            (nlopt_func func, unsigned dim, double* x, double* min) noexcept;
+
+    /// ImportCount of a result is the number of epochs started from a
+    /// point of another island
+    const std::vector<PortfolioWorkerResult>& getWorkerResults() const noexcept;
+
+    unsigned getThreadCount() const noexcept;
+
+    /// number of epochs the evaluation budget of an island is split into
+    void setEpochCount(unsigned epoch_count) noexcept;
+
+    /// wall-clock limit in seconds shared by all islands, zero means no limit
+    void setMaxTime(double max_time) noexcept;
+
+    /// statistics of all islands are merged into stats
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// see NLoptOptimizer::setFunctionData
+    void setFunctionData(void* func_data) noexcept;
+
+    /// per-variable search box of all islands, see OptConfig::LowerBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+private:
+    void addDefaultIslands();
+
+private:
+    unsigned m_thread_count;
+    unsigned m_epoch_count;
+    double m_max_time;
+    OptStatistics* m_stats;
+    void* m_func_data;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+    std::vector<std::pair<nlopt_algorithm, unsigned long>> m_islands;
+    std::vector<PortfolioWorkerResult> m_worker_results;
+};
+}
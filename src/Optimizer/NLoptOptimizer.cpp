@@ -8,8 +8,12 @@
 //
 
 #include "NLoptOptimizer.h"
+#include "Utils/Watchdog.h"
 #include <assert.h>
+#include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <memory>
 #include <vector>
 
 namespace gosat {
@@ -19,7 +23,9 @@ OptConfig::OptConfig() :
         RelTolerance{1e-10},
         Bound{1e9},
         StepSize{0.5},
-        InitialPopulation{0}
+        InitialPopulation{0},
+        RandomSeed{0},
+        MaxTime{0}
 {}
 
 OptConfig::OptConfig(nlopt_algorithm global_alg, nlopt_algorithm local_alg) :
@@ -28,9 +34,11 @@ OptConfig::OptConfig(nlopt_algorithm global_alg, nlopt_algorithm local_alg) :
         RelTolerance{1e-10},
         Bound{1e9},
         StepSize{0.5},
-        InitialPopulation{0}
+        InitialPopulation{0},
+        RandomSeed{0},
+        MaxTime{0}
 {
-    assert(local_alg == NLOPT_LN_BOBYQA &&
+    assert(NLoptOptimizer::isSupportedLocalOptAlg(local_alg) &&
            "Invalid local optimization algorithms!");
     if (global_alg == NLOPT_G_MLSL_LDS || global_alg == NLOPT_G_MLSL) {
         MaxEvalCount = 50000;
@@ -38,59 +46,222 @@ OptConfig::OptConfig(nlopt_algorithm global_alg, nlopt_algorithm local_alg) :
     }
 }
 
+OptStatistics::OptStatistics() :
+        StartTime{std::chrono::steady_clock::now()},
+        EvalCount{0},
+        IsTraced{true}
+{}
+
+void OptStatistics::merge(const OptStatistics& other)
+{
+    EvalCount += other.EvalCount;
+    std::vector<std::pair<double, double>> trace;
+    trace.reserve(BestTrace.size() + other.BestTrace.size());
+    std::merge(BestTrace.cbegin(), BestTrace.cend(), other.BestTrace.cbegin(),
+               other.BestTrace.cend(), std::back_inserter(trace));
+    // keep improvements of the combined best value only
+    BestTrace.clear();
+    for (const auto& point : trace) {
+        if (BestTrace.empty() || point.second < BestTrace.back().second) {
+            BestTrace.push_back(point);
+        }
+    }
+}
+
 NLoptOptimizer::NLoptOptimizer() :
         m_global_opt_alg{NLOPT_GN_DIRECT},
-        m_local_opt_alg{NLOPT_LN_BOBYQA}
+        m_local_opt_alg{NLOPT_LN_BOBYQA},
+        m_cancel_flag{nullptr},
+        m_expired_flag{nullptr},
+        m_stats{nullptr},
+        m_func_data{nullptr}
 {}
 
 NLoptOptimizer::NLoptOptimizer(nlopt_algorithm global_alg,
                                nlopt_algorithm local_alg) :
         m_global_opt_alg{global_alg},
         m_local_opt_alg{local_alg},
+        m_cancel_flag{nullptr},
+        m_expired_flag{nullptr},
+        m_stats{nullptr},
+        m_func_data{nullptr},
         Config{global_alg, local_alg}
 {}
 
+/**
+ * /brief Objective wrapper which forces NLopt to stop once cancelled or
+ * once the watchdog expires. It keeps the best point seen so far, since
+ * not all algorithms report it when forcibly stopped, and optionally
+ * collects statistics.
+ */
+struct MonitoredFunc {
+    nlopt_func Func;
+    void* FuncData;
+    const std::atomic<bool>* CancelFlag;
+    const std::atomic<bool>* ExpiredFlag;
+    nlopt_opt Opt;
+    double BestMinima;
+    std::vector<double> BestX;
+    OptStatistics* Stats;
+};
+
+static double
+evalMonitoredFunc(unsigned n, const double* x, double* grad, void* data)
+{
+    auto mfunc = static_cast<MonitoredFunc*>(data);
+    if ((mfunc->CancelFlag != nullptr &&
+         mfunc->CancelFlag->load(std::memory_order_relaxed)) ||
+        (mfunc->ExpiredFlag != nullptr &&
+         mfunc->ExpiredFlag->load(std::memory_order_relaxed))) {
+        nlopt_force_stop(mfunc->Opt);
+    }
+    const double result = mfunc->Func(n, x, grad, mfunc->FuncData);
+    if (mfunc->Stats != nullptr) {
+        ++mfunc->Stats->EvalCount;
+    }
+    if (result < mfunc->BestMinima) {
+        mfunc->BestMinima = result;
+        std::copy(x, x + n, mfunc->BestX.begin());
+        if (mfunc->Stats != nullptr && mfunc->Stats->IsTraced) {
+            mfunc->Stats->BestTrace.emplace_back(
+                    std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() -
+                            mfunc->Stats->StartTime).count(), result);
+        }
+    }
+    return result;
+}
+
 int
 NLoptOptimizer::optimize
         (nlopt_func func, unsigned dim, double* x, double* min) const noexcept
 {
-    if (func(dim, x, nullptr, nullptr) == 0) {
+    assert(NLoptOptimizer::isSupportedGlobalOptAlg(m_global_opt_alg)
+           && "Unsupported global optimization algorithm");
+    return optimizeWith(m_global_opt_alg, Config.MaxEvalCount, func, dim, x,
+                        min);
+}
+
+int
+NLoptOptimizer::optimizeLocally
+        (nlopt_func func, unsigned dim, double* x, double* min) const noexcept
+{
+    assert(NLoptOptimizer::isSupportedLocalOptAlg(m_local_opt_alg)
+           && "Unsupported local optimization algorithm!");
+    return optimizeWith(m_local_opt_alg, Config.MaxLocalEvalCount, func, dim,
+                        x, min);
+}
+
+int
+NLoptOptimizer::optimizeWith
+        (nlopt_algorithm opt_alg, int max_eval_count, nlopt_func func,
+         unsigned dim, double* x, double* min) const noexcept
+{
+    const bool is_boxed = (Config.LowerBounds.size() == dim &&
+                           Config.UpperBounds.size() == dim);
+    if (is_boxed) {
+        for (unsigned i = 0; i < dim; ++i) {
+            x[i] = std::min(std::max(x[i], Config.LowerBounds[i]),
+                            Config.UpperBounds[i]);
+        }
+    }
+    const double initial_value = func(dim, x, nullptr, m_func_data);
+    if (m_stats != nullptr) {
+        ++m_stats->EvalCount;
+        if (!std::isnan(initial_value) && m_stats->IsTraced) {
+            m_stats->BestTrace.emplace_back(
+                    std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() -
+                            m_stats->StartTime).count(), initial_value);
+        }
+    }
+    if (initial_value == 0) {
         // trivially satisfiable algorithm
         *min = 0;
         return 0;
     }
-    assert(NLoptOptimizer::isSupportedGlobalOptAlg(m_global_opt_alg)
-           && "Unsupported global optimization algorithm");
+    if (Config.RandomSeed != 0) {
+        nlopt_srand(Config.RandomSeed);
+    }
+    // NLopt checks its time limit only between iterations, the watchdog
+    // is polled on every evaluation of the objective. A flag set by the
+    // caller spares starting a thread per call.
+    std::unique_ptr<Watchdog> watchdog;
+    const std::atomic<bool>* expired_flag = m_expired_flag;
+    if (expired_flag == nullptr && Config.MaxTime > 0) {
+        watchdog = std::make_unique<Watchdog>(Config.MaxTime);
+        expired_flag = watchdog->getExpiredFlag();
+    }
     nlopt_opt opt;
-    opt = nlopt_create(m_global_opt_alg, dim);
-    nlopt_set_min_objective(opt, func, NULL);
-    nlopt_set_upper_bounds1(opt, Config.Bound);
-    nlopt_set_lower_bounds1(opt, -Config.Bound);
+    opt = nlopt_create(opt_alg, dim);
+    MonitoredFunc mfunc{func, m_func_data, m_cancel_flag, expired_flag, opt,
+                        std::isnan(initial_value) ? HUGE_VAL : initial_value,
+                        std::vector<double>(x, x + dim), m_stats};
+    const bool is_monitored = (m_cancel_flag != nullptr ||
+                               expired_flag != nullptr || m_stats != nullptr);
+    if (is_monitored) {
+        nlopt_set_min_objective(opt, evalMonitoredFunc, &mfunc);
+    } else {
+        nlopt_set_min_objective(opt, func, m_func_data);
+    }
     std::vector<double> step_size_arr(dim, Config.StepSize);
+    if (is_boxed) {
+        nlopt_set_upper_bounds(opt, Config.UpperBounds.data());
+        nlopt_set_lower_bounds(opt, Config.LowerBounds.data());
+        for (unsigned i = 0; i < dim; ++i) {
+            // steps must stay within tiny boxes, e.g., of subnormals
+            const double width = Config.UpperBounds[i] - Config.LowerBounds[i];
+            if (width > 0) {
+                step_size_arr[i] = std::min(Config.StepSize, width / 4);
+            }
+        }
+    } else {
+        nlopt_set_upper_bounds1(opt, Config.Bound);
+        nlopt_set_lower_bounds1(opt, -Config.Bound);
+    }
     nlopt_set_initial_step(opt, step_size_arr.data());
     nlopt_set_stopval(opt, 0);
     nlopt_set_xtol_rel(opt, Config.RelTolerance);
-    nlopt_set_maxeval(opt, Config.MaxEvalCount);
-    if (NLoptOptimizer::isRequirePopulation(m_global_opt_alg)) {
+    nlopt_set_maxeval(opt, max_eval_count);
+    if (Config.MaxTime > 0) {
+        nlopt_set_maxtime(opt, Config.MaxTime);
+    }
+    if (NLoptOptimizer::isRequirePopulation(opt_alg)) {
         nlopt_set_population(opt, Config.InitialPopulation);
     }
-    if (!NLoptOptimizer::isRequireLocalOptAlg(m_global_opt_alg)) {
-        auto status = nlopt_optimize(opt, x, min);
-        nlopt_destroy(opt);
-        return status;
+    nlopt_opt local_opt = nullptr;
+    if (NLoptOptimizer::isRequireLocalOptAlg(opt_alg)) {
+        assert(NLoptOptimizer::isSupportedLocalOptAlg(m_local_opt_alg)
+               && "Unsupported local optimization algorithm!");
+        local_opt = nlopt_create(m_local_opt_alg, dim);
+        if (is_monitored) {
+            nlopt_set_min_objective(local_opt, evalMonitoredFunc, &mfunc);
+        } else {
+            nlopt_set_min_objective(local_opt, func, m_func_data);
+        }
+        nlopt_set_initial_step(local_opt, step_size_arr.data());
+        nlopt_set_stopval(local_opt, 0);
+        nlopt_set_maxeval(local_opt, Config.MaxLocalEvalCount);
+        nlopt_set_local_optimizer(opt, local_opt);
     }
-    assert(NLoptOptimizer::isSupportedLocalOptAlg(m_local_opt_alg)
-           && "Unsupported local optimization algorithm!");
-    nlopt_opt local_opt;
-    local_opt = nlopt_create(m_local_opt_alg, dim);
-    nlopt_set_min_objective(local_opt, func, NULL);
-    nlopt_set_initial_step(local_opt, step_size_arr.data());
-    nlopt_set_stopval(local_opt, 0);
-    nlopt_set_maxeval(local_opt, Config.MaxLocalEvalCount);
-    nlopt_set_local_optimizer(opt, local_opt);
     auto status = nlopt_optimize(opt, x, min);
-    nlopt_destroy(local_opt);
+    if (local_opt != nullptr) {
+        nlopt_destroy(local_opt);
+    }
     nlopt_destroy(opt);
+    if (!is_monitored) {
+        return status;
+    }
+    if (mfunc.BestMinima < *min || status < 0) {
+        // report the best point seen so far (anytime result)
+        std::copy(mfunc.BestX.cbegin(), mfunc.BestX.cend(), x);
+        *min = mfunc.BestMinima;
+    }
+    if (expired_flag != nullptr && expired_flag->load() &&
+        status == NLOPT_FORCED_STOP &&
+        (m_cancel_flag == nullptr || !m_cancel_flag->load())) {
+        status = NLOPT_MAXTIME_REACHED;
+    }
     return status;
 }
 
@@ -142,13 +313,86 @@ NLoptOptimizer::isRequirePopulation(nlopt_algorithm opt_alg) noexcept
     }
 }
 
+const char*
+NLoptOptimizer::getAlgorithmName(nlopt_algorithm opt_alg) noexcept
+{
+    switch (opt_alg) {
+        case NLOPT_GN_DIRECT:
+        case NLOPT_GN_DIRECT_L:
+        case NLOPT_GN_DIRECT_L_RAND:
+        case NLOPT_GN_ORIG_DIRECT:
+        case NLOPT_GN_ORIG_DIRECT_L:
+            return "direct";
+        case NLOPT_GN_MLSL_LDS:
+        case NLOPT_G_MLSL:
+        case NLOPT_G_MLSL_LDS:
+            return "mlsl";
+        case NLOPT_GN_CRS2_LM:
+            return "crs2";
+        case NLOPT_GN_ISRES:
+            return "isres";
+        case NLOPT_GN_ESCH:
+            return "esch";
+        case NLOPT_LN_BOBYQA:
+            return "bobyqa";
+        case NLOPT_LN_SBPLX:
+            return "sbplx";
+        default:
+            return "unknown";
+    }
+}
+
+void NLoptOptimizer::setCancellationFlag
+        (const std::atomic<bool>* cancel_flag) noexcept
+{
+    m_cancel_flag = cancel_flag;
+}
+
+void NLoptOptimizer::setExpiredFlag
+        (const std::atomic<bool>* expired_flag) noexcept
+{
+    m_expired_flag = expired_flag;
+}
+
+void NLoptOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void NLoptOptimizer::setFunctionData(void* func_data) noexcept
+{
+    m_func_data = func_data;
+}
+
+void NLoptOptimizer::setMaxTime(double max_time) noexcept
+{
+    Config.MaxTime = max_time;
+}
+
+void NLoptOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                               const std::vector<double>& upper_bounds)
+{
+    Config.LowerBounds = lower_bounds;
+    Config.UpperBounds = upper_bounds;
+}
+
+bool NLoptOptimizer::isTimeout(int status) noexcept
+{
+    return status == NLOPT_MAXTIME_REACHED;
+}
+
+nlopt_algorithm NLoptOptimizer::getGlobalOptAlg() const noexcept
+{
+    return m_global_opt_alg;
+}
+
 int
 NLoptOptimizer::refineResult
         (nlopt_func func, unsigned dim, double* x, double* min)
 {
     nlopt_opt opt;
     opt = nlopt_create(NLOPT_LN_BOBYQA, dim);
-    nlopt_set_min_objective(opt, func, NULL);
+    nlopt_set_min_objective(opt, func, m_func_data);
     nlopt_set_initial_step(opt, &Config.StepSize);
     nlopt_set_xtol_rel(opt, Config.RelTolerance);
     nlopt_set_maxeval(opt, Config.MaxLocalEvalCount);
@@ -164,7 +408,7 @@ NLoptOptimizer::existsRoundingError
          const double* x,
          const double* min) const noexcept
 {
-    return func(dim, x, nullptr, nullptr) != *min;
+    return func(dim, x, nullptr, m_func_data) != *min;
 }
 
 void
@@ -182,18 +426,18 @@ NLoptOptimizer::fixRoundingErrorNearZero(nlopt_func const func,
         if (std::fabs(x[i] - int_part) < 1e-6) {
             double temp = x[i];
             x[i] = int_part;
-            const auto min_x = func(dim, x, nullptr, nullptr);
+            const auto min_x = func(dim, x, nullptr, m_func_data);
             if (*min < min_x || std::fpclassify(min_x) == FP_NAN) {
                 x[i] = temp;
             }
         }
     }
-    *min = func(dim, x, nullptr, nullptr);
+    *min = func(dim, x, nullptr, m_func_data);
 }
 
 double NLoptOptimizer::eval
         (nlopt_func func, unsigned dim, const double* x) const noexcept
 {
-    return func(dim, x, nullptr, nullptr);
+    return func(dim, x, nullptr, m_func_data);
 }
 }
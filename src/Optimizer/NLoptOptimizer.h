@@ -10,9 +10,29 @@
 #pragma once
 
 #include <nlopt.h>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <vector>
 
 namespace gosat {
 
+/**
+ * /brief objective function evaluated at count points stored consecutively
+ * in xs. Results are written to out.
+ */
+using BatchFunc = void (*)
+        (unsigned dim, unsigned count, const double* xs, double* out);
+
+/**
+ * /brief objective function keeping a value per clause in state. Only
+ * clauses depending on the changed_count variables listed in changed are
+ * recomputed, all clauses are recomputed if changed is null.
+ */
+using IncFunc = double (*)
+        (unsigned dim, const double* x, double* state, const unsigned* changed,
+         unsigned changed_count);
+
 class OptConfig {
 public:
     OptConfig();
@@ -27,6 +47,38 @@ public:
     double Bound;
     double StepSize;
     unsigned InitialPopulation;
+    /// seed of NLopt's random generator, zero keeps NLopt's time-based seed
+    unsigned long RandomSeed;
+    /// wall-clock limit in seconds, zero means no limit
+    double MaxTime;
+    /**
+     * /brief per-variable search box used instead of [-Bound, Bound] if
+     * both hold a bound per variable. The starting point is clamped into it.
+     */
+    std::vector<double> LowerBounds;
+    std::vector<double> UpperBounds;
+};
+
+/**
+ * /brief Counts evaluations of the objective function and records every
+ * improvement of the best value found so far as (seconds since StartTime,
+ * value).
+ */
+class OptStatistics {
+public:
+    OptStatistics();
+
+    virtual ~OptStatistics() = default;
+
+    /// merges statistics of a concurrent run sharing the same StartTime
+    void merge(const OptStatistics& other);
+
+    std::chrono::steady_clock::time_point StartTime;
+    unsigned long EvalCount;
+    /// improvements are recorded in BestTrace, otherwise evaluations are
+    /// counted only
+    bool IsTraced;
+    std::vector<std::pair<double, double>> BestTrace;
 };
 
 class NLoptOptimizer {
@@ -42,6 +94,14 @@ public:
             (nlopt_func func, unsigned dim, double* x,
              double* min) const noexcept;
 
+    /**
+     * /brief minimizes func starting from x using the local algorithm and
+     * MaxLocalEvalCount. Otherwise, it behaves like optimize.
+     */
+    int optimizeLocally
+            (nlopt_func func, unsigned dim, double* x,
+             double* min) const noexcept;
+
     double eval
             (nlopt_func func, unsigned dim, const double* x) const noexcept;
 
@@ -67,9 +127,53 @@ public:
 
     static bool isRequirePopulation(nlopt_algorithm opt_alg) noexcept;
 
+    static const char* getAlgorithmName(nlopt_algorithm opt_alg) noexcept;
+
+    /**
+     * /brief optimization is forcibly stopped once cancel_flag becomes true.
+     * The flag is polled on every evaluation of the objective function.
+     */
+    void setCancellationFlag(const std::atomic<bool>* cancel_flag) noexcept;
+
+    /**
+     * /brief optimization stops with NLOPT_MAXTIME_REACHED once expired_flag
+     * becomes true, e.g., the flag of a Watchdog shared by several runs.
+     * No watchdog of MaxTime is started per call to optimize then.
+     */
+    void setExpiredFlag(const std::atomic<bool>* expired_flag) noexcept;
+
+    /**
+     * /brief statistics of the following calls to optimize are added
+     * to stats. Collecting them costs a counter increment per evaluation.
+     */
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// func_data is passed to every evaluation of the objective function
+    void setFunctionData(void* func_data) noexcept;
+
+    /// sets Config.MaxTime
+    void setMaxTime(double max_time) noexcept;
+
+    /// sets Config.LowerBounds and Config.UpperBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+    static bool isTimeout(int status) noexcept;
+
+    nlopt_algorithm getGlobalOptAlg() const noexcept;
+
+private:
+    int optimizeWith
+            (nlopt_algorithm opt_alg, int max_eval_count, nlopt_func func,
+             unsigned dim, double* x, double* min) const noexcept;
+
 private:
     const nlopt_algorithm m_global_opt_alg;
     const nlopt_algorithm m_local_opt_alg;
+    const std::atomic<bool>* m_cancel_flag;
+    const std::atomic<bool>* m_expired_flag;
+    OptStatistics* m_stats;
+    void* m_func_data;
 public:
     OptConfig Config;
 };
@@ -0,0 +1,213 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "PartitionOptimizer.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Watchdog.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+namespace gosat {
+
+PartitionOptimizer::PartitionOptimizer
+        (nlopt_algorithm opt_alg, unsigned thread_count) :
+        m_opt_alg{opt_alg},
+        m_thread_count{std::max(thread_count, 1u)},
+        m_max_time{0},
+        m_stats{nullptr},
+        m_func_data{nullptr}
+{}
+
+std::vector<SearchBox>
+PartitionOptimizer::genBoxes(unsigned dim, double bound,
+                             const std::vector<double>& lower_bounds,
+                             const std::vector<double>& upper_bounds)
+{
+    const bool is_clipped = (lower_bounds.size() == dim &&
+                             upper_bounds.size() == dim);
+    std::vector<SearchBox> boxes;
+    // signs holds '+' or '-' per variable, whose magnitude is in [low, high]
+    auto add_band_box = [&](double low, double high,
+                            const std::string& signs) {
+        SearchBox box;
+        for (unsigned i = 0; i < dim; ++i) {
+            double lower = (signs[i] == '+') ? low : -high;
+            double upper = (signs[i] == '+') ? high : -low;
+            if (is_clipped) {
+                lower = std::max(lower, lower_bounds[i]);
+                upper = std::min(upper, upper_bounds[i]);
+                if (lower > upper) {
+                    // band is outside of the bounds
+                    return;
+                }
+            }
+            box.LowerBounds.push_back(lower);
+            box.UpperBounds.push_back(upper);
+        }
+        std::ostringstream name;
+        name << signs << '|' << low << ':' << high;
+        box.Name = name.str();
+        boxes.push_back(std::move(box));
+    };
+    // smallest normal number bounds subnormals
+    const double band_limits[] = {0.0, std::numeric_limits<double>::min(),
+                                  1.0, 1024.0, 1048576.0, bound};
+    const bool is_orthant_split = (dim <= kMaxOrthantSplitDim);
+    for (unsigned band = 0; band < 5 && band_limits[band] < bound; ++band) {
+        const double low = band_limits[band];
+        const double high = std::min(band_limits[band + 1], bound);
+        if (!is_orthant_split) {
+            add_band_box(low, high, std::string(dim, '+'));
+            add_band_box(low, high, std::string(dim, '-'));
+            continue;
+        }
+        for (unsigned long mask = 0; mask < (1ul << dim); ++mask) {
+            std::string signs;
+            for (unsigned i = 0; i < dim; ++i) {
+                signs += (((mask >> i) & 1) != 0) ? '-' : '+';
+            }
+            add_band_box(low, high, signs);
+        }
+    }
+    SearchBox full_box;
+    std::ostringstream name;
+    name << std::string(dim, '*') << "|0:" << bound;
+    full_box.Name = name.str();
+    if (is_clipped) {
+        full_box.LowerBounds = lower_bounds;
+        full_box.UpperBounds = upper_bounds;
+    } else {
+        full_box.LowerBounds.assign(dim, -bound);
+        full_box.UpperBounds.assign(dim, bound);
+    }
+    boxes.push_back(std::move(full_box));
+    return boxes;
+}
+
+int PartitionOptimizer::optimize
+        (nlopt_func func, unsigned dim, double* x, double* min) noexcept
+{
+    const OptConfig base_config(m_opt_alg, NLOPT_LN_BOBYQA);
+    m_boxes = genBoxes(dim, base_config.Bound, m_lower_bounds,
+                       m_upper_bounds);
+    const auto box_count = static_cast<unsigned>(m_boxes.size());
+    // boxes share the evaluation budget of as many runs as there are threads
+    const unsigned thread_count = std::min(m_thread_count, box_count);
+    const int box_eval_count = std::max(
+            static_cast<int>(static_cast<long>(base_config.MaxEvalCount) *
+                             thread_count / box_count), 1);
+    const double max_value = std::numeric_limits<double>::max();
+    m_worker_results.assign(box_count,
+                            PortfolioWorkerResult{m_opt_alg, 0, 0, max_value,
+                                                  0, true, 0, 0});
+    std::vector<OptStatistics> box_stats(box_count);
+    std::vector<std::vector<double>> box_x(box_count,
+                                           std::vector<double>(x, x + dim));
+    std::atomic<bool> is_solved{false};
+    const auto start_time = std::chrono::steady_clock::now();
+    // a single watchdog bounds all workers, instead of one per NLopt run
+    std::unique_ptr<Watchdog> watchdog;
+    if (m_max_time > 0) {
+        watchdog = std::make_unique<Watchdog>(m_max_time);
+    }
+    {
+        ThreadPool pool(thread_count);
+        for (unsigned i = 0; i < box_count; ++i) {
+            pool.submit([&, i](unsigned worker_id) {
+                auto& result = m_worker_results[i];
+                result.Seed = i;
+                if (is_solved.load()) {
+                    // box never started
+                    return;
+                }
+                const auto time_start = std::chrono::steady_clock::now();
+                NLoptOptimizer nl_opt(m_opt_alg);
+                nl_opt.Config.MaxEvalCount = box_eval_count;
+                nl_opt.Config.RandomSeed = i + 1;
+                nl_opt.Config.LowerBounds = m_boxes[i].LowerBounds;
+                nl_opt.Config.UpperBounds = m_boxes[i].UpperBounds;
+                if (m_max_time > 0) {
+                    const double remaining_time = m_max_time -
+                            std::chrono::duration<double>
+                                    (time_start - start_time).count();
+                    if (remaining_time <= 0) {
+                        result.Status = NLOPT_MAXTIME_REACHED;
+                        return;
+                    }
+                    nl_opt.Config.MaxTime = remaining_time;
+                }
+                nl_opt.setCancellationFlag(&is_solved);
+                if (watchdog != nullptr) {
+                    nl_opt.setExpiredFlag(watchdog->getExpiredFlag());
+                }
+                nl_opt.setFunctionData(m_func_data);
+                if (m_stats != nullptr) {
+                    box_stats[i].StartTime = m_stats->StartTime;
+                    box_stats[i].IsTraced = m_stats->IsTraced;
+                    nl_opt.setStatistics(&box_stats[i]);
+                }
+                double minima = 1.0;
+                result.Status = nl_opt.optimize(func, dim, box_x[i].data(),
+                                                &minima);
+                result.Minima = minima;
+                result.IsCancelled = (result.Status == NLOPT_FORCED_STOP);
+                result.EvalCount = box_stats[i].EvalCount;
+                result.ElapsedTime = getElapsedTime(time_start);
+                if (minima == 0) {
+                    is_solved.store(true);
+                }
+            });
+        }
+        pool.wait();
+    }
+    mergeWorkerStatistics(box_stats, m_stats);
+    return selectBestWorker(m_worker_results, box_x, x, min);
+}
+
+const std::vector<PortfolioWorkerResult>&
+PartitionOptimizer::getWorkerResults() const noexcept
+{
+    return m_worker_results;
+}
+
+const std::vector<SearchBox>& PartitionOptimizer::getBoxes() const noexcept
+{
+    return m_boxes;
+}
+
+unsigned PartitionOptimizer::getThreadCount() const noexcept
+{
+    return m_thread_count;
+}
+
+void PartitionOptimizer::setMaxTime(double max_time) noexcept
+{
+    m_max_time = max_time;
+}
+
+void PartitionOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void PartitionOptimizer::setFunctionData(void* func_data) noexcept
+{
+    m_func_data = func_data;
+}
+
+void PartitionOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                                   const std::vector<double>& upper_bounds)
+{
+    m_lower_bounds = lower_bounds;
+    m_upper_bounds = upper_bounds;
+}
+}
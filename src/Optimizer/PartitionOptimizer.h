@@ -0,0 +1,110 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "WorkerResult.h"
+#include <string>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief A sub-box of the search space, Name describes its sign pattern
+ * and magnitude band, e.g., "+-|1:1024". Sign '*' marks a variable
+ * ranging over both signs.
+ */
+struct SearchBox {
+    std::string Name;
+    std::vector<double> LowerBounds;
+    std::vector<double> UpperBounds;
+};
+
+/**
+ * /brief Partitions the search box [-Bound, Bound]^n into sub-boxes by
+ * magnitude band and variable sign, and solves them concurrently on a
+ * thread pool. All sub-boxes are stopped as soon as one finds a zero.
+ *
+ * Bands are disjoint ranges of binades, i.e., all variables of a band box
+ * have a magnitude in [2^k, 2^m] for the band's k and m. The lowest band
+ * covers subnormals and zeros only. Sampling density within small
+ * magnitudes is thereby far higher than in the full box, where almost all
+ * samples have a large exponent. For formulas with few variables, every
+ * band is split into all orthants, i.e., sign patterns. Otherwise, a band
+ * has a box of positive and a box of negative variables.
+ *
+ * Band boxes are disjoint, yet they do not tile the search box since all
+ * variables of a band box share its band, and beyond kMaxOrthantSplitDim
+ * its sign too. Tiling would need a box per band and sign of every
+ * variable, i.e., exponentially many. Points of mixed magnitudes, or of
+ * mixed signs beyond kMaxOrthantSplitDim, are covered by the full box
+ * only, a fallback which is always searched and overlaps all band boxes.
+ * Boxes are clipped to the bounds given by setBounds.
+ */
+class PartitionOptimizer {
+public:
+    PartitionOptimizer() = delete;
+
+    PartitionOptimizer(nlopt_algorithm opt_alg, unsigned thread_count);
+
+    virtual ~PartitionOptimizer() = default;
+
+    PartitionOptimizer(const PartitionOptimizer&) = default;
+
+    PartitionOptimizer& operator=(const PartitionOptimizer&) = default;
+
+    int optimize
+            (nlopt_func func, unsigned dim, double* x, double* min) noexcept;
+
+    /// results are ordered like getBoxes, Seed is the index of a box
+    const std::vector<PortfolioWorkerResult>& getWorkerResults() const noexcept;
+
+    /// boxes of the last call to optimize
+    const std::vector<SearchBox>& getBoxes() const noexcept;
+
+    unsigned getThreadCount() const noexcept;
+
+    /// wall-clock limit in seconds shared by all boxes, zero means no limit
+    void setMaxTime(double max_time) noexcept;
+
+    /// statistics of all boxes are merged into stats
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// see NLoptOptimizer::setFunctionData
+    void setFunctionData(void* func_data) noexcept;
+
+    /// per-variable search box which all sub-boxes are clipped to, see
+    /// OptConfig::LowerBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+    /**
+     * /brief boxes partitioning [-bound, bound]^dim, clipped to lower_bounds
+     * and upper_bounds if both are of size dim. Empty boxes are dropped.
+     */
+    static std::vector<SearchBox>
+    genBoxes(unsigned dim, double bound,
+             const std::vector<double>& lower_bounds,
+             const std::vector<double>& upper_bounds);
+
+private:
+    /// orthants are split up to this number of variables
+    static const unsigned kMaxOrthantSplitDim = 3;
+
+    nlopt_algorithm m_opt_alg;
+    unsigned m_thread_count;
+    double m_max_time;
+    OptStatistics* m_stats;
+    void* m_func_data;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+    std::vector<SearchBox> m_boxes;
+    std::vector<PortfolioWorkerResult> m_worker_results;
+};
+}
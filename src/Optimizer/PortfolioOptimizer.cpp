@@ -0,0 +1,166 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "PortfolioOptimizer.h"
+#include "Utils/Watchdog.h"
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace gosat {
+
+PortfolioOptimizer::PortfolioOptimizer(unsigned thread_count) :
+        m_thread_count{std::max(thread_count, 1u)},
+        m_max_time{0},
+        m_stats{nullptr},
+        m_func_data{nullptr}
+{}
+
+void PortfolioOptimizer::addEntry(nlopt_algorithm opt_alg, unsigned long seed)
+{
+    assert(NLoptOptimizer::isSupportedGlobalOptAlg(opt_alg)
+           && "Unsupported global optimization algorithm");
+    m_entries.emplace_back(std::make_pair(opt_alg, seed));
+}
+
+void PortfolioOptimizer::addDefaultEntries()
+{
+    // DIRECT is deterministic, it is pointless to run it with several seeds.
+    const nlopt_algorithm first_entries[] = {NLOPT_GN_CRS2_LM, NLOPT_GN_ISRES,
+                                             NLOPT_G_MLSL, NLOPT_GN_DIRECT_L};
+    const nlopt_algorithm seeded_entries[] = {NLOPT_GN_CRS2_LM, NLOPT_GN_ISRES,
+                                              NLOPT_G_MLSL};
+    unsigned long seed = 1;
+    for (unsigned i = 0; i < m_thread_count; ++i, ++seed) {
+        if (i < 4) {
+            addEntry(first_entries[i], seed);
+        } else {
+            addEntry(seeded_entries[(i - 4) % 3], seed);
+        }
+    }
+}
+
+int PortfolioOptimizer::optimize
+        (nlopt_func func, unsigned dim, double* x, double* min) noexcept
+{
+    if (m_entries.empty()) {
+        addDefaultEntries();
+    }
+    const auto entry_count = static_cast<unsigned>(m_entries.size());
+    const double max_value = std::numeric_limits<double>::max();
+    m_worker_results.assign(entry_count,
+                            PortfolioWorkerResult{NLOPT_GN_CRS2_LM, 0, 0,
+                                                  max_value, 0, true, 0, 0});
+    std::vector<OptStatistics> worker_stats(entry_count);
+    std::vector<std::vector<double>> worker_x(entry_count,
+                                              std::vector<double>(x, x + dim));
+    std::atomic<bool> is_solved{false};
+    std::atomic<unsigned> next_entry{0};
+    const auto portfolio_start = std::chrono::steady_clock::now();
+    // a single watchdog bounds all workers, instead of one per NLopt run
+    std::unique_ptr<Watchdog> watchdog;
+    if (m_max_time > 0) {
+        watchdog = std::make_unique<Watchdog>(m_max_time);
+    }
+    auto worker = [&]() {
+        for (unsigned i = next_entry++; i < entry_count; i = next_entry++) {
+            auto& result = m_worker_results[i];
+            result.Algorithm = m_entries[i].first;
+            result.Seed = m_entries[i].second;
+            if (is_solved.load()) {
+                // entry never started
+                continue;
+            }
+            auto time_start = std::chrono::steady_clock::now();
+            NLoptOptimizer nl_opt(m_entries[i].first);
+            nl_opt.Config.RandomSeed = m_entries[i].second;
+            if (m_max_time > 0) {
+                // entries started late get what is left of the budget
+                const double remaining_time = m_max_time -
+                        std::chrono::duration<double>
+                                (time_start - portfolio_start).count();
+                if (remaining_time <= 0) {
+                    result.Status = NLOPT_MAXTIME_REACHED;
+                    continue;
+                }
+                nl_opt.Config.MaxTime = remaining_time;
+            }
+            nl_opt.setCancellationFlag(&is_solved);
+            if (watchdog != nullptr) {
+                nl_opt.setExpiredFlag(watchdog->getExpiredFlag());
+            }
+            nl_opt.setFunctionData(m_func_data);
+            nl_opt.Config.LowerBounds = m_lower_bounds;
+            nl_opt.Config.UpperBounds = m_upper_bounds;
+            if (m_stats != nullptr) {
+                worker_stats[i].StartTime = m_stats->StartTime;
+                worker_stats[i].IsTraced = m_stats->IsTraced;
+                nl_opt.setStatistics(&worker_stats[i]);
+            }
+            double minima = 1.0;
+            result.Status = nl_opt.optimize(func, dim, worker_x[i].data(),
+                                            &minima);
+            result.Minima = minima;
+            result.IsCancelled = (result.Status == NLOPT_FORCED_STOP);
+            result.EvalCount = worker_stats[i].EvalCount;
+            result.ElapsedTime = getElapsedTime(time_start);
+            if (minima == 0) {
+                is_solved.store(true);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    const auto thread_count = std::min(m_thread_count, entry_count);
+    threads.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    mergeWorkerStatistics(worker_stats, m_stats);
+    return selectBestWorker(m_worker_results, worker_x, x, min);
+}
+
+const std::vector<PortfolioWorkerResult>&
+PortfolioOptimizer::getWorkerResults() const noexcept
+{
+    return m_worker_results;
+}
+
+unsigned PortfolioOptimizer::getThreadCount() const noexcept
+{
+    return m_thread_count;
+}
+
+void PortfolioOptimizer::setMaxTime(double max_time) noexcept
+{
+    m_max_time = max_time;
+}
+
+void PortfolioOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void PortfolioOptimizer::setFunctionData(void* func_data) noexcept
+{
+    m_func_data = func_data;
+}
+
+void PortfolioOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                                   const std::vector<double>& upper_bounds)
+{
+    m_lower_bounds = lower_bounds;
+    m_upper_bounds = upper_bounds;
+}
+}
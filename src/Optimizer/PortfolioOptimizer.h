@@ -0,0 +1,73 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "NLoptOptimizer.h"
+#include "WorkerResult.h"
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Races several algorithm/seed configurations of NLoptOptimizer
+ * on separate threads. All workers share the same objective function
+ * which must be free of side effects. Workers are stopped as soon as
+ * one of them finds a zero.
+ */
+class PortfolioOptimizer {
+public:
+    PortfolioOptimizer() = delete;
+
+    explicit PortfolioOptimizer(unsigned thread_count);
+
+    virtual ~PortfolioOptimizer() = default;
+
+    PortfolioOptimizer(const PortfolioOptimizer&) = default;
+
+    PortfolioOptimizer& operator=(const PortfolioOptimizer&) = default;
+
+    PortfolioOptimizer& operator=(PortfolioOptimizer&&) = default;
+
+    void addEntry(nlopt_algorithm opt_alg, unsigned long seed);
+
+    int optimize
+            (nlopt_func func, unsigned dim, double* x, double* min) noexcept;
+
+    const std::vector<PortfolioWorkerResult>& getWorkerResults() const noexcept;
+
+    unsigned getThreadCount() const noexcept;
+
+    /// wall-clock limit in seconds shared by all workers, zero means no limit
+    void setMaxTime(double max_time) noexcept;
+
+    /// statistics of all workers are merged into stats
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// func_data is shared by all workers, see NLoptOptimizer::setFunctionData
+    void setFunctionData(void* func_data) noexcept;
+
+    /// per-variable search box of all workers, see OptConfig::LowerBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+private:
+    void addDefaultEntries();
+
+private:
+    unsigned m_thread_count;
+    double m_max_time;
+    OptStatistics* m_stats;
+    void* m_func_data;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+    std::vector<std::pair<nlopt_algorithm, unsigned long>> m_entries;
+    std::vector<PortfolioWorkerResult> m_worker_results;
+};
+}
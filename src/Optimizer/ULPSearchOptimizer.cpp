@@ -0,0 +1,318 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "ULPSearchOptimizer.h"
+#include "WorkerResult.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace gosat {
+
+ULPSearchConfig::ULPSearchConfig() :
+        MaxEvalCount{5000000},
+        MaxTime{0},
+        Bound{DBL_MAX},
+        Temperature{0.2},
+        TabuTenure{4},
+        MaxStallCount{100000},
+        RandomSeed{0}
+{}
+
+ULPSearchOptimizer::ULPSearchOptimizer(unsigned thread_count) :
+        m_thread_count{std::max(thread_count, 1u)},
+        m_stats{nullptr}
+{}
+
+int64_t ULPSearchOptimizer::toOrdered(double value) noexcept
+{
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // negative doubles are ordered by decreasing magnitude, -0 maps to 0
+    return (bits < 0) ? -(bits & std::numeric_limits<int64_t>::max()) : bits;
+}
+
+double ULPSearchOptimizer::fromOrdered(int64_t ordered) noexcept
+{
+    uint64_t bits = (ordered < 0) ?
+                    static_cast<uint64_t>(-ordered) | (1ull << 63) :
+                    static_cast<uint64_t>(ordered);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * /brief Metropolis test on the ratio of values since values are distances
+ * in ULPs spanning many orders of magnitude
+ */
+static bool isAccepted(double new_value, double cur_value, double temperature,
+                       double rand_value) noexcept
+{
+    if (new_value <= cur_value) {
+        return true;
+    }
+    if (!(temperature > 0)) {
+        return false;
+    }
+    // false for nan
+    return rand_value < std::pow(cur_value / new_value, 1 / temperature);
+}
+
+int ULPSearchOptimizer::optimize
+        (const FPIRInterpreter& func, unsigned dim, double* x,
+         double* min) noexcept
+{
+    auto eval = [&func](const double* x, std::vector<double>* state) {
+        return func.evalState(x, state);
+    };
+    auto update = [&func](const double* x, unsigned var,
+                          std::vector<double>* state) {
+        return func.updateState(x, var, state);
+    };
+    return search(eval, update, dim, x, min);
+}
+
+int ULPSearchOptimizer::optimize
+        (IncFunc func, unsigned state_size, unsigned dim, double* x,
+         double* min) noexcept
+{
+    auto eval = [func, state_size, dim](const double* x,
+                                        std::vector<double>* state) {
+        state->resize(state_size);
+        return func(dim, x, state->data(), nullptr, 0);
+    };
+    auto update = [func, dim](const double* x, unsigned var,
+                              std::vector<double>* state) {
+        return func(dim, x, state->data(), &var, 1);
+    };
+    return search(eval, update, dim, x, min);
+}
+
+template <typename EvalFunc, typename UpdateFunc>
+int ULPSearchOptimizer::search
+        (const EvalFunc& eval, const UpdateFunc& update, unsigned dim,
+         double* x, double* min) noexcept
+{
+    if (dim == 0) {
+        std::vector<double> state;
+        *min = eval(x, &state);
+        return (*min == 0) ? NLOPT_STOPVAL_REACHED : NLOPT_MAXEVAL_REACHED;
+    }
+    // keys of variable i are within [min_keys[i], max_keys[i]]
+    const int64_t bound_key = toOrdered(std::min(std::fabs(Config.Bound),
+                                                 DBL_MAX));
+    std::vector<int64_t> min_keys(dim, -bound_key);
+    std::vector<int64_t> max_keys(dim, bound_key);
+    if (m_lower_bounds.size() == dim && m_upper_bounds.size() == dim) {
+        for (unsigned i = 0; i < dim; ++i) {
+            min_keys[i] = std::max(min_keys[i], toOrdered(m_lower_bounds[i]));
+            max_keys[i] = std::min(max_keys[i], toOrdered(m_upper_bounds[i]));
+        }
+    }
+    auto clamp_key = [&min_keys, &max_keys](unsigned var, int64_t key) {
+        return std::min(std::max(key, min_keys[var]), max_keys[var]);
+    };
+    std::vector<OptStatistics> chain_stats(m_thread_count);
+    std::vector<std::vector<double>> chain_x(m_thread_count);
+    std::vector<double> chain_min(m_thread_count, HUGE_VAL);
+    // not vector<bool>, chains write their flags concurrently
+    std::vector<char> chain_timed_out(m_thread_count, 0);
+    const unsigned long base_seed = (Config.RandomSeed != 0) ?
+                                    Config.RandomSeed :
+                                    std::random_device()();
+    std::atomic<bool> is_solved{false};
+    const auto start_time = std::chrono::steady_clock::now();
+    auto chain = [&](unsigned i) {
+        auto& stats = chain_stats[i];
+        stats.IsTraced = (m_stats != nullptr && m_stats->IsTraced);
+        if (m_stats != nullptr) {
+            stats.StartTime = m_stats->StartTime;
+        }
+        std::mt19937_64 rand_gen(base_seed + i);
+        std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+        std::uniform_int_distribution<unsigned> var_dist(0, dim - 1);
+        auto random_key = [&](unsigned var) {
+            return std::uniform_int_distribution<int64_t>
+                    (min_keys[var], max_keys[var])(rand_gen);
+        };
+        std::uniform_int_distribution<int> shift_dist(0, 62);
+        std::uniform_int_distribution<int> bit_dist(0, 63);
+        std::uniform_int_distribution<int> binade_dist(1, 64);
+        const unsigned long tabu_tenure =
+                std::min<unsigned long>(Config.TabuTenure, dim - 1);
+        std::vector<unsigned long> last_move(dim, 0);
+        std::vector<double> state;
+        // state before the last move, restored when the move is rejected
+        std::vector<double> saved_state;
+        std::vector<double> cur_x(x, x + dim);
+        for (unsigned j = 0; j < dim; ++j) {
+            cur_x[j] = fromOrdered(clamp_key(j, toOrdered(cur_x[j])));
+        }
+        auto record_best = [&](double value) {
+            chain_min[i] = value;
+            chain_x[i] = cur_x;
+            if (stats.IsTraced) {
+                stats.BestTrace.emplace_back(
+                        std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() -
+                                stats.StartTime).count(), value);
+            }
+        };
+        double cur_value = eval(cur_x.data(), &state);
+        ++stats.EvalCount;
+        record_best(cur_value);
+        unsigned long stall_count = 0;
+        unsigned long restart_count = 0;
+        for (unsigned long step = 1;
+             chain_min[i] != 0 && stats.EvalCount < Config.MaxEvalCount;
+             ++step) {
+            if (is_solved.load(std::memory_order_relaxed)) {
+                break;
+            }
+            if (Config.MaxTime > 0 && step % 256 == 0 &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                              - start_time).count() >=
+                Config.MaxTime) {
+                chain_timed_out[i] = 1;
+                break;
+            }
+            if (stall_count > Config.MaxStallCount) {
+                // restart alternately from the best point and a random one
+                if (restart_count++ % 2 == 0) {
+                    cur_x = chain_x[i];
+                } else {
+                    for (unsigned j = 0; j < dim; ++j) {
+                        cur_x[j] = fromOrdered(random_key(j));
+                    }
+                }
+                cur_value = eval(cur_x.data(), &state);
+                ++stats.EvalCount;
+                std::fill(last_move.begin(), last_move.end(), 0);
+                stall_count = 0;
+                continue;
+            }
+            const unsigned var = var_dist(rand_gen);
+            const double old_value = cur_x[var];
+            const int64_t key = toOrdered(old_value);
+            int64_t new_key;
+            const double move = unit_dist(rand_gen);
+            if (move < 0.6) {
+                // shift by a power of two ULPs, saturating at the bounds
+                const int64_t delta = int64_t(1) << shift_dist(rand_gen);
+                const int64_t max_key = max_keys[var];
+                const int64_t min_key = min_keys[var];
+                // key is within [min_key, max_key], the differences can not
+                // overflow unlike max_key - delta and min_key + delta
+                if (unit_dist(rand_gen) < 0.5) {
+                    new_key = (max_key - key < delta) ? max_key : key + delta;
+                } else {
+                    new_key = (key - min_key < delta) ? min_key : key - delta;
+                }
+            } else if (move < 0.75) {
+                // flip a sign, exponent, or significand bit
+                uint64_t bits;
+                std::memcpy(&bits, &old_value, sizeof(bits));
+                bits ^= uint64_t(1) << bit_dist(rand_gen);
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                // nan patterns are beyond infinity and get clamped
+                new_key = clamp_key(var, toOrdered(value));
+            } else if (old_value == 0) {
+                new_key = random_key(var);
+            } else {
+                const int binades = (unit_dist(rand_gen) < 0.5) ?
+                                    binade_dist(rand_gen) :
+                                    -binade_dist(rand_gen);
+                new_key = clamp_key(var, toOrdered(std::ldexp(old_value,
+                                                              binades)));
+            }
+            if (new_key == key) {
+                continue;
+            }
+            cur_x[var] = fromOrdered(new_key);
+            saved_state = state;
+            const double new_value = update(cur_x.data(), var, &state);
+            ++stats.EvalCount;
+            const bool is_best = new_value < chain_min[i];
+            const bool is_tabu = last_move[var] != 0 &&
+                                 step - last_move[var] <= tabu_tenure;
+            if ((is_tabu && !is_best) ||
+                !isAccepted(new_value, cur_value, Config.Temperature,
+                            unit_dist(rand_gen))) {
+                cur_x[var] = old_value;
+                state.swap(saved_state);
+                ++stall_count;
+                continue;
+            }
+            cur_value = new_value;
+            last_move[var] = step;
+            if (is_best) {
+                record_best(new_value);
+                stall_count = 0;
+            } else {
+                ++stall_count;
+            }
+        }
+        if (chain_min[i] == 0) {
+            is_solved.store(true);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(m_thread_count);
+    for (unsigned i = 0; i < m_thread_count; ++i) {
+        threads.emplace_back(chain, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    mergeWorkerStatistics(chain_stats, m_stats);
+    const auto best = static_cast<unsigned>(
+            std::min_element(chain_min.cbegin(), chain_min.cend()) -
+            chain_min.cbegin());
+    std::copy(chain_x[best].cbegin(), chain_x[best].cend(), x);
+    *min = chain_min[best];
+    if (*min == 0) {
+        return NLOPT_STOPVAL_REACHED;
+    }
+    if (std::find(chain_timed_out.cbegin(), chain_timed_out.cend(), 1) !=
+        chain_timed_out.cend()) {
+        return NLOPT_MAXTIME_REACHED;
+    }
+    return NLOPT_MAXEVAL_REACHED;
+}
+
+unsigned ULPSearchOptimizer::getThreadCount() const noexcept
+{
+    return m_thread_count;
+}
+
+void ULPSearchOptimizer::setMaxTime(double max_time) noexcept
+{
+    Config.MaxTime = max_time;
+}
+
+void ULPSearchOptimizer::setStatistics(OptStatistics* stats) noexcept
+{
+    m_stats = stats;
+}
+
+void ULPSearchOptimizer::setBounds(const std::vector<double>& lower_bounds,
+                                   const std::vector<double>& upper_bounds)
+{
+    m_lower_bounds = lower_bounds;
+    m_upper_bounds = upper_bounds;
+}
+}
@@ -0,0 +1,116 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "JIT/FPIRInterpreter.h"
+#include "NLoptOptimizer.h"
+#include <cstdint>
+#include <vector>
+
+namespace gosat {
+
+class ULPSearchConfig {
+public:
+    ULPSearchConfig();
+
+    virtual ~ULPSearchConfig() = default;
+
+    /// evaluation budget of a chain
+    unsigned long MaxEvalCount;
+    /// wall-clock limit in seconds, zero means no limit
+    double MaxTime;
+    /// values are searched in [-Bound, Bound], all finite values by default
+    double Bound;
+    /// temperature of the Metropolis test on log(value)
+    double Temperature;
+    /// steps during which a moved variable is not moved again
+    unsigned TabuTenure;
+    /// steps without improving the best value of a chain before it restarts
+    unsigned long MaxStallCount;
+    /// seed of the first chain, zero uses a random seed
+    unsigned long RandomSeed;
+};
+
+/**
+ * /brief Stochastic local search over IEEE-754 bit patterns.
+ *
+ * The objective measures distances in ULPs, hence, moves are done in ULP
+ * space where doubles are ordered integers: shifts by a power of two ULPs,
+ * bit flips, and jumps by a random number of binades. Each move changes a
+ * single variable and is accepted by the Metropolis criterion, recently
+ * moved variables are tabu unless their move improves the best value.
+ * Only the part of the objective depending on the moved variable is
+ * re-evaluated, i.e., its cone of influence when interpreted, see
+ * FPIRInterpreter::updateState, or its clauses when jitted, see IncFunc.
+ * A rejected move restores the state saved before it instead of
+ * re-evaluating.
+ * A chain stalling for too long restarts alternately from its best point and
+ * from a random point.
+ *
+ * Every thread runs an independent chain, and all chains stop as soon as
+ * one finds a zero. Moves saturate at the bounds of the moved variable.
+ */
+class ULPSearchOptimizer {
+public:
+    ULPSearchOptimizer() = delete;
+
+    explicit ULPSearchOptimizer(unsigned thread_count);
+
+    virtual ~ULPSearchOptimizer() = default;
+
+    ULPSearchOptimizer(const ULPSearchOptimizer&) = default;
+
+    ULPSearchOptimizer& operator=(const ULPSearchOptimizer&) = default;
+
+    /// func should have its dependencies indexed
+    int optimize
+            (const FPIRInterpreter& func, unsigned dim, double* x,
+             double* min) noexcept;
+
+    /// func keeps state_size values per chain, see
+    /// FPIRGenerator::genIncrementalFunction
+    int optimize
+            (IncFunc func, unsigned state_size, unsigned dim, double* x,
+             double* min) noexcept;
+
+    unsigned getThreadCount() const noexcept;
+
+    /// sets Config.MaxTime
+    void setMaxTime(double max_time) noexcept;
+
+    /// statistics of all chains are merged into stats
+    void setStatistics(OptStatistics* stats) noexcept;
+
+    /// per-variable search box within [-Bound, Bound], see
+    /// OptConfig::LowerBounds
+    void setBounds(const std::vector<double>& lower_bounds,
+                   const std::vector<double>& upper_bounds);
+
+    /// maps doubles to integers such that adjacent doubles differ by one
+    static int64_t toOrdered(double value) noexcept;
+
+    static double fromOrdered(int64_t ordered) noexcept;
+
+private:
+    /// eval computes the objective into a chain's state, update
+    /// re-evaluates it after a single variable changed
+    template <typename EvalFunc, typename UpdateFunc>
+    int search
+            (const EvalFunc& eval, const UpdateFunc& update, unsigned dim,
+             double* x, double* min) noexcept;
+
+    unsigned m_thread_count;
+    OptStatistics* m_stats;
+    std::vector<double> m_lower_bounds;
+    std::vector<double> m_upper_bounds;
+public:
+    ULPSearchConfig Config;
+};
+}
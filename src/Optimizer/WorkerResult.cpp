@@ -0,0 +1,62 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "WorkerResult.h"
+#include <algorithm>
+#include <limits>
+
+namespace gosat {
+
+float getElapsedTime(std::chrono::steady_clock::time_point start_time) noexcept
+{
+    return static_cast<float>(
+            std::chrono::duration_cast<std::chrono::milliseconds>
+                    (std::chrono::steady_clock::now() - start_time)
+                    .count()) / 1000;
+}
+
+void mergeWorkerStatistics
+        (const std::vector<OptStatistics>& worker_stats, OptStatistics* stats)
+{
+    if (stats == nullptr) {
+        return;
+    }
+    for (const auto& worker_stat : worker_stats) {
+        stats->merge(worker_stat);
+    }
+}
+
+int selectBestWorker
+        (const std::vector<PortfolioWorkerResult>& results,
+         const std::vector<std::vector<double>>& worker_x, double* x,
+         double* min) noexcept
+{
+    const size_t worker_count = results.size();
+    size_t best = worker_count;
+    for (size_t i = 0; i < worker_count; ++i) {
+        const auto& result = results[i];
+        // failed runs, e.g., NLOPT_ROUNDOFF_LIMITED, still report their best
+        // point, workers without any finite value are skipped
+        if (!(result.Minima < std::numeric_limits<double>::max())) {
+            continue;
+        }
+        if (best == worker_count || result.Minima < results[best].Minima) {
+            best = i;
+        }
+    }
+    if (best == worker_count) {
+        *min = std::numeric_limits<double>::max();
+        return results.empty() ? static_cast<int>(NLOPT_FAILURE) :
+               results[0].Status;
+    }
+    std::copy(worker_x[best].cbegin(), worker_x[best].cend(), x);
+    *min = results[best].Minima;
+    return results[best].Status;
+}
+}
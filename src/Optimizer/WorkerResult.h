@@ -0,0 +1,53 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "NLoptOptimizer.h"
+#include <chrono>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Outcome of a single worker of a parallel optimizer, e.g., a
+ * portfolio entry or a basin hopping chain
+ */
+struct PortfolioWorkerResult {
+    nlopt_algorithm Algorithm;
+    unsigned long Seed;
+    int Status;
+    double Minima;
+    float ElapsedTime;
+    bool IsCancelled;
+    unsigned long EvalCount;
+    /// restarts from a point found by another worker, see IslandOptimizer
+    unsigned ImportCount;
+};
+
+/// seconds since start_time at millisecond resolution
+float getElapsedTime(std::chrono::steady_clock::time_point start_time) noexcept;
+
+/// statistics of all workers are merged into stats unless it is null
+void mergeWorkerStatistics
+        (const std::vector<OptStatistics>& worker_stats, OptStatistics* stats);
+
+/**
+ * /brief copies the point and minima of the best worker to x and min. The
+ * best worker has the smallest minima of all workers that found a finite
+ * value, including workers that failed afterwards.
+ * /returns status of the best worker. If no worker found a finite value,
+ * min is set to the largest double and the status of the first worker is
+ * returned.
+ */
+int selectBestWorker
+        (const std::vector<PortfolioWorkerResult>& results,
+         const std::vector<std::vector<double>>& worker_x, double* x,
+         double* min) noexcept;
+}
@@ -0,0 +1,145 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPBatchSolver.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace gosat {
+
+BatchSummary::BatchSummary() :
+        FormulaCount{0},
+        SatCount{0},
+        ErrorCount{0},
+        SolvingTime{0},
+        WallTime{0},
+        StolenJobCount{0}
+{}
+
+FPBatchSolver::FPBatchSolver
+        (const SolverOptions& options, unsigned worker_count,
+         bool smtlib_output) :
+        m_solver{options},
+        m_worker_count{std::max(worker_count, 1u)},
+        m_smtlib_output{smtlib_output}
+{}
+
+bool FPBatchSolver::collectFiles
+        (const std::string& path, std::vector<std::string>* files)
+{
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) {
+        return false;
+    }
+    if (!S_ISDIR(path_stat.st_mode)) {
+        std::ifstream list_file(path);
+        if (!list_file.good()) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(list_file, line)) {
+            if (!line.empty()) {
+                files->push_back(line);
+            }
+        }
+        return true;
+    }
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    const std::string dir_path = (path.back() == '/') ? path : path + "/";
+    std::vector<std::string> dir_files;
+    while (dirent* entry = readdir(dir)) {
+        std::string file_path = dir_path + entry->d_name;
+        struct stat file_stat;
+        if (stat(file_path.c_str(), &file_stat) == 0 &&
+            S_ISREG(file_stat.st_mode)) {
+            dir_files.emplace_back(std::move(file_path));
+        }
+    }
+    closedir(dir);
+    std::sort(dir_files.begin(), dir_files.end());
+    files->insert(files->end(), dir_files.begin(), dir_files.end());
+    return true;
+}
+
+BatchSummary FPBatchSolver::solve
+        (const std::vector<std::string>& file_paths, std::ostream& out)
+{
+    FPSolver::initializeNativeTarget();
+    BatchSummary summary;
+    std::mutex mutex;
+    auto time_start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(m_worker_count);
+        for (const auto& file_path : file_paths) {
+            pool.submit([this, &file_path, &summary, &mutex, &out]
+                                (unsigned worker_id) {
+                std::ostringstream result_out;
+                std::ostringstream stats_out;
+                bool is_sat = false;
+                bool is_error = false;
+                double solving_time = 0;
+                try {
+                    z3::context smt_ctx;
+                    SolverResult result = m_solver.solveFile(smt_ctx,
+                                                             file_path);
+                    FPSolver::printResult(result_out, result,
+                                          m_smtlib_output);
+                    if (m_solver.getOptions().CollectStatistics) {
+                        FPSolver::printStatistics(stats_out, result);
+                        stats_out << "\n";
+                    }
+                    is_sat = result.IsSat;
+                    solving_time = result.ElapsedTime;
+                } catch (const z3::exception& exp) {
+                    result_out << file_path << ",error," << exp.msg();
+                    is_error = true;
+                }
+                result_out << "\n";
+                std::lock_guard<std::mutex> lock(mutex);
+                out << result_out.str();
+                out.flush();
+                std::cerr << stats_out.str();
+                ++summary.FormulaCount;
+                summary.SatCount += (is_sat) ? 1 : 0;
+                summary.ErrorCount += (is_error) ? 1 : 0;
+                summary.SolvingTime += solving_time;
+            });
+        }
+        pool.wait();
+        summary.StolenJobCount = pool.getStolenJobCount();
+    }
+    summary.WallTime = std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - time_start).count();
+    return summary;
+}
+
+void FPBatchSolver::printSummary(std::ostream& out, const BatchSummary& summary)
+{
+    const double throughput = (summary.WallTime > 0) ?
+                              summary.FormulaCount / summary.WallTime : 0;
+    out << std::setprecision(4);
+    out << "formulas," << summary.FormulaCount
+        << ",sat," << summary.SatCount
+        << ",error," << summary.ErrorCount
+        << ",wall," << summary.WallTime
+        << ",solving," << summary.SolvingTime
+        << ",throughput," << throughput
+        << ",stolen," << summary.StolenJobCount << "\n";
+}
+}
@@ -0,0 +1,77 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "FPSolver.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace gosat {
+
+class BatchSummary {
+public:
+    BatchSummary();
+
+    virtual ~BatchSummary() = default;
+
+    unsigned FormulaCount;
+    unsigned SatCount;
+    unsigned ErrorCount;
+    /// sum of solving times of all formulas
+    double SolvingTime;
+    double WallTime;
+    unsigned long StolenJobCount;
+};
+
+/**
+ * /brief Solves many SMT files concurrently in one process.
+ *
+ * Every formula gets its own z3::context and LLVMContext. Files are
+ * scheduled on a work-stealing ThreadPool, so a few slow formulas occupy
+ * only their workers while remaining files are taken by idle ones.
+ */
+class FPBatchSolver {
+public:
+    FPBatchSolver() = delete;
+
+    FPBatchSolver(const SolverOptions& options, unsigned worker_count,
+                  bool smtlib_output);
+
+    virtual ~FPBatchSolver() = default;
+
+    FPBatchSolver(const FPBatchSolver&) = delete;
+
+    FPBatchSolver& operator=(const FPBatchSolver&) = delete;
+
+    /**
+     * /brief solves all files and prints a result line per formula
+     * as soon as it is solved
+     */
+    BatchSummary solve(const std::vector<std::string>& file_paths,
+                       std::ostream& out);
+
+    /**
+     * /brief collects smt files of a directory, sorted by name, or the
+     * paths listed line by line in a file
+     *
+     * /returns false if path could not be read
+     */
+    static bool
+    collectFiles(const std::string& path, std::vector<std::string>* files);
+
+    static void printSummary(std::ostream& out, const BatchSummary& summary);
+
+private:
+    FPSolver m_solver;
+    unsigned m_worker_count;
+    bool m_smtlib_output;
+};
+}
@@ -0,0 +1,213 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPForkServer.h"
+#include "FPSolverServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace gosat {
+
+namespace {
+
+/// /returns false if fd is closed by its peer
+bool writeAll(int fd, const std::string& str)
+{
+    size_t written = 0;
+    while (written < str.size()) {
+        auto res = write(fd, str.data() + written, str.size() - written);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(res);
+    }
+    return true;
+}
+}
+
+FPForkServer::FPForkServer
+        (const SolverOptions& options, unsigned child_count,
+         bool smtlib_output) :
+        m_solver{options},
+        m_smtlib_output{smtlib_output},
+        m_child_count{std::max(child_count, 1u)},
+        m_formula_count{0},
+        m_out_fd{-1}
+{
+    FPSolver::initializeNativeTarget();
+    // parsing once loads the FP theory, children start parsing warm
+    m_smt_ctx.parse_string("(declare-fun x () (_ FloatingPoint 11 53))"
+                           "(assert (fp.isNaN x))");
+    // a closed output is detected by write instead
+    signal(SIGPIPE, SIG_IGN);
+}
+
+int FPForkServer::serve(int in_fd, int out_fd)
+{
+    m_out_fd = out_fd;
+    std::string buffer;
+    size_t buffer_pos = 0;
+    FPSolverServer::readRequests(
+            [this, in_fd, &buffer, &buffer_pos](std::string& line) {
+                while (true) {
+                    auto line_end = buffer.find('\n', buffer_pos);
+                    if (line_end != std::string::npos) {
+                        line = buffer.substr(buffer_pos,
+                                             line_end - buffer_pos);
+                        buffer_pos = line_end + 1;
+                        return true;
+                    }
+                    buffer.erase(0, buffer_pos);
+                    buffer_pos = 0;
+                    // results of children are written while input is idle
+                    if (!pollEvents(in_fd)) {
+                        continue;
+                    }
+                    char chunk[4096];
+                    auto res = read(in_fd, chunk, sizeof(chunk));
+                    if (res < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (res <= 0) {
+                        // end of input, flush last unterminated line
+                        line = buffer;
+                        buffer.clear();
+                        return !line.empty();
+                    }
+                    buffer.append(chunk, static_cast<size_t>(res));
+                }
+            },
+            [this](const std::string& request, bool is_smt_str) {
+                forkChild(request, is_smt_str);
+            });
+    while (!m_children.empty()) {
+        pollEvents(-1);
+    }
+    return 0;
+}
+
+void FPForkServer::forkChild(const std::string& request, bool is_smt_str)
+{
+    while (m_children.size() >= m_child_count) {
+        pollEvents(-1);
+    }
+    std::string func_name = (is_smt_str) ?
+                            "formula" + std::to_string(m_formula_count++) :
+                            request;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        writeResponse(func_name + ",error," + std::strerror(errno) + "\n");
+        return;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        writeResponse(func_name + ",error," + std::strerror(errno) + "\n");
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        runChild(request, is_smt_str, func_name, fds[1]);
+    }
+    close(fds[1]);
+    m_children.push_back(Child{pid, fds[0], func_name, ""});
+}
+
+void FPForkServer::runChild
+        (const std::string& request, bool is_smt_str,
+         const std::string& func_name, int fd)
+{
+    std::ostringstream out;
+    try {
+        SolverResult result = (is_smt_str) ?
+                              m_solver.solveString(m_smt_ctx, request,
+                                                   func_name) :
+                              m_solver.solveFile(m_smt_ctx, request);
+        FPSolver::printResult(out, result, m_smtlib_output);
+    } catch (const z3::exception& exp) {
+        out << func_name << ",error," << exp.msg();
+    }
+    out << "\n";
+    writeAll(fd, out.str());
+    // objects of tiered execution are cached in the background
+    FPSolver::waitForBackgroundCompilations();
+    // skips exit handlers and destructors of state shared with the server
+    _exit(0);
+}
+
+bool FPForkServer::pollEvents(int in_fd)
+{
+    std::vector<pollfd> poll_fds;
+    for (const auto& child : m_children) {
+        poll_fds.push_back(pollfd{child.Fd, static_cast<short>(POLLIN), 0});
+    }
+    if (in_fd >= 0) {
+        poll_fds.push_back(pollfd{in_fd, static_cast<short>(POLLIN), 0});
+    }
+    if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+        // EINTR, callers poll again
+        return false;
+    }
+    // erasing in reverse keeps indices of remaining children valid
+    for (size_t i = m_children.size(); i-- > 0;) {
+        if (poll_fds[i].revents == 0) {
+            continue;
+        }
+        auto& child = m_children[i];
+        char chunk[4096];
+        auto res = read(child.Fd, chunk, sizeof(chunk));
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res > 0) {
+            child.Output.append(chunk, static_cast<size_t>(res));
+            continue;
+        }
+        reapChild(child);
+        m_children.erase(m_children.begin() + i);
+    }
+    return in_fd >= 0 && poll_fds.back().revents != 0;
+}
+
+void FPForkServer::reapChild(const Child& child)
+{
+    close(child.Fd);
+    int status = 0;
+    while (waitpid(child.Pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+        !child.Output.empty()) {
+        writeResponse(child.Output);
+        return;
+    }
+    std::string reason = (WIFSIGNALED(status)) ?
+                         "killed by signal " +
+                         std::to_string(WTERMSIG(status)) :
+                         "exited with code " +
+                         std::to_string(WEXITSTATUS(status));
+    writeResponse(child.FuncName + ",error," + reason + "\n");
+}
+
+void FPForkServer::writeResponse(const std::string& str)
+{
+    // nothing else to do if the output is closed
+    writeAll(m_out_fd, str);
+}
+}
@@ -0,0 +1,87 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "FPSolver.h"
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Serves a stream of formulas, each solved in its own process.
+ *
+ * The server is a zygote: it initializes LLVM and z3 once, then forks a
+ * child per formula which inherits the initialized state, solves, and
+ * writes its result line back over a pipe. A crash of a child is reported
+ * as an error line of its formula only. Requests and results follow the
+ * format of FPSolverServer, results may be reordered.
+ *
+ * The server itself stays single-threaded, since forking a process with
+ * several threads may leave locks of the child held forever. Children are
+ * free to start threads.
+ */
+class FPForkServer {
+public:
+    FPForkServer() = delete;
+
+    /// at most child_count children solve concurrently
+    FPForkServer(const SolverOptions& options, unsigned child_count,
+                 bool smtlib_output);
+
+    virtual ~FPForkServer() = default;
+
+    FPForkServer(const FPForkServer&) = delete;
+
+    FPForkServer& operator=(const FPForkServer&) = delete;
+
+    /// serves requests read from in_fd until end of input, results are
+    /// written to out_fd
+    int serve(int in_fd, int out_fd);
+
+private:
+    struct Child {
+        pid_t Pid;
+        /// read end of the pipe of the result
+        int Fd;
+        std::string FuncName;
+        std::string Output;
+    };
+
+    /// forks a child once fewer than m_child_count are running
+    void forkChild(const std::string& request, bool is_smt_str);
+
+    [[noreturn]] void
+    runChild(const std::string& request, bool is_smt_str,
+             const std::string& func_name, int fd);
+
+    /**
+     * /brief waits until a child writes or exits, or in_fd is readable if
+     * not negative. Exited children are reaped and their results written.
+     * /returns true if in_fd is readable
+     */
+    bool pollEvents(int in_fd);
+
+    void reapChild(const Child& child);
+
+    void writeResponse(const std::string& str);
+
+private:
+    FPSolver m_solver;
+    bool m_smtlib_output;
+    unsigned m_child_count;
+    unsigned m_formula_count;
+    int m_out_fd;
+    /// inherited by children, hence z3 is initialized once
+    z3::context m_smt_ctx;
+    std::vector<Child> m_children;
+};
+}
@@ -0,0 +1,133 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPResultCache.h"
+#include "CodeGen/CodeGen.h"
+#include "ExprAnalyzer/FPExprHasher.h"
+#include "Utils/FileUtils.h"
+#include "llvm/Support/FileSystem.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace gosat {
+
+// bump whenever the entry format changes, changes of the objective
+// function are covered by CodeGenStr::kCodeGenVersion
+static const char* kResultCacheFormatVersion = "gosat-resultcache-2";
+
+namespace {
+
+/// doubles are stored as their bit patterns, so NaNs and signed zeros
+/// survive a round trip
+std::string toBitString(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return FPExprHasher::toHexString(bits);
+}
+
+bool fromBitString(const std::string& str, double* value)
+{
+    if (str.size() != 16) {
+        return false;
+    }
+    uint64_t bits = 0;
+    for (const auto ch : str) {
+        bits <<= 4;
+        if (ch >= '0' && ch <= '9') {
+            bits |= static_cast<uint64_t>(ch - '0');
+        } else if (ch >= 'a' && ch <= 'f') {
+            bits |= static_cast<uint64_t>(ch - 'a' + 10);
+        } else {
+            return false;
+        }
+    }
+    std::memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+}
+
+FPResultCacheEntry::FPResultCacheEntry() :
+        IsSat{false},
+        Algorithm{0},
+        Timeout{0},
+        EvalCount{0},
+        Status{0},
+        Minima{1.0}
+{}
+
+FPResultCache::FPResultCache(const std::string& cache_dir) :
+        m_cache_dir{cache_dir}
+{
+    llvm::sys::fs::create_directories(m_cache_dir);
+}
+
+std::string FPResultCache::genKey(uint64_t expr_hash) const
+{
+    return FPExprHasher::toHexString(expr_hash) + "-" +
+           FPExprHasher::toHexString(
+                   FPExprHasher::hashString(kResultCacheFormatVersion +
+                                            CodeGenStr::kCodeGenVersion));
+}
+
+std::string FPResultCache::getFilePath(const std::string& key) const
+{
+    return m_cache_dir + "/" + key + ".result";
+}
+
+bool FPResultCache::lookup
+        (const std::string& key, FPResultCacheEntry* entry) const
+{
+    std::ifstream result_file(getFilePath(key));
+    std::string result_str;
+    std::string timeout_str;
+    std::string minima_str;
+    size_t var_count;
+    if (!(result_file >> result_str >> entry->Algorithm
+                      >> entry->SearchOptions >> timeout_str
+                      >> entry->EvalCount >> entry->Status >> minima_str
+                      >> var_count)) {
+        return false;
+    }
+    if ((result_str != "sat" && result_str != "unknown") ||
+        !fromBitString(timeout_str, &entry->Timeout) ||
+        !fromBitString(minima_str, &entry->Minima)) {
+        return false;
+    }
+    entry->IsSat = (result_str == "sat");
+    entry->Model.resize(var_count);
+    std::string value_str;
+    for (size_t i = 0; i < var_count; ++i) {
+        if (!(result_file >> value_str) ||
+            !fromBitString(value_str, &entry->Model[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FPResultCache::store
+        (const std::string& key, const FPResultCacheEntry& entry)
+{
+    std::ostringstream data;
+    data << (entry.IsSat ? "sat" : "unknown") << " " << entry.Algorithm
+         << " " << (entry.SearchOptions.empty() ? "-" : entry.SearchOptions)
+         << " " << toBitString(entry.Timeout) << " " << entry.EvalCount
+         << " " << entry.Status << " " << toBitString(entry.Minima)
+         << " " << entry.Model.size();
+    for (const auto value : entry.Model) {
+        data << " " << toBitString(value);
+    }
+    data << "\n";
+    const std::string data_str = data.str();
+    return file_util::writeFileAtomically(getFilePath(key), data_str.data(),
+                                          data_str.size());
+}
+}
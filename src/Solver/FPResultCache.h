@@ -0,0 +1,78 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Result of solving a formula, either a model or the budget spent
+ * without finding one
+ */
+class FPResultCacheEntry {
+public:
+    FPResultCacheEntry();
+
+    virtual ~FPResultCacheEntry() = default;
+
+    bool IsSat;
+    /// goSATAlgorithm of an unknown result
+    int Algorithm;
+    /// other options shaping the search of an unknown result, e.g., thread
+    /// count and presolving, encoded without whitespace
+    std::string SearchOptions;
+    /// wall-clock budget in seconds of an unknown result, zero means the
+    /// algorithm stopped by itself
+    double Timeout;
+    /// objective evaluations spent, an unknown result without any is
+    /// never reused
+    unsigned long EvalCount;
+    int Status;
+    double Minima;
+    /// values of FP variables in the variable order of FPIRGenerator
+    std::vector<double> Model;
+};
+
+/**
+ * /brief Persistent on-disk cache of solver results.
+ *
+ * Results are looked up by a key obtained from genKey() given a
+ * renaming-invariant hash of the formula, see FPExprHasher. Hence, a
+ * result is reused by every formula equal up to renaming of variables.
+ * Models are stored bit-exact.
+ */
+class FPResultCache {
+public:
+    FPResultCache() = delete;
+
+    explicit FPResultCache(const std::string& cache_dir);
+
+    virtual ~FPResultCache() = default;
+
+    FPResultCache(const FPResultCache&) = delete;
+
+    FPResultCache& operator=(const FPResultCache&) = delete;
+
+    std::string genKey(uint64_t expr_hash) const;
+
+    bool lookup(const std::string& key, FPResultCacheEntry* entry) const;
+
+    bool store(const std::string& key, const FPResultCacheEntry& entry);
+
+private:
+    std::string getFilePath(const std::string& key) const;
+
+private:
+    std::string m_cache_dir;
+};
+}
@@ -0,0 +1,1107 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPSolver.h"
+#include "CodeGen/FPExprCodeGenerator.h"
+#include "ExprAnalyzer/FPExprAnalyzer.h"
+#include "ExprAnalyzer/FPExprHasher.h"
+#include "ExprAnalyzer/FPIntervalAnalyzer.h"
+#include "IRGen/FPIRGenerator.h"
+#include "JIT/FPIRInterpreter.h"
+#include "JIT/FPJITCompiler.h"
+#include "JIT/FPObjectCache.h"
+#include "Optimizer/BasinHoppingOptimizer.h"
+#include "Optimizer/CMAESOptimizer.h"
+#include "Optimizer/IslandOptimizer.h"
+#include "Optimizer/ModelValidator.h"
+#include "Optimizer/PartitionOptimizer.h"
+#include "Optimizer/PortfolioOptimizer.h"
+#include "Optimizer/NLoptOptimizer.h"
+#include "Optimizer/ULPSearchOptimizer.h"
+#include "Solver/FPResultCache.h"
+#include "Utils/FPAUtils.h"
+#include "Utils/ThreadPool.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace gosat {
+
+typedef std::numeric_limits<double> dbl;
+
+SolverOptions::SolverOptions() :
+        Algorithm{kCRS2},
+        PartitionAlgorithm{kCRS2},
+        ThreadCount{0},
+        OptLevel{2},
+        ValidateModel{false},
+        UseObjectCache{false},
+        PrintJITReport{false},
+        Timeout{0},
+        CollectStatistics{false},
+        CountEvaluations{false},
+        UseTieredExecution{false},
+        SplitComponents{false},
+        InferBounds{false},
+        EliminateVars{false},
+        UseResultCache{false}
+{}
+
+SolverStatistics::SolverStatistics() :
+        ParseTime{0},
+        PresolveTime{0},
+        CacheLookupTime{0},
+        IRGenTime{0},
+        IROptTime{0},
+        CodeGenTime{0},
+        OptTime{0},
+        ValidationTime{0}
+{}
+
+SolverResult::SolverResult() :
+        IsSat{false},
+        HasUnsupportedExpr{false},
+        ElapsedTime{0},
+        Minima{1.0},
+        Status{0},
+        IsModelValidated{false},
+        IsModelValid{false},
+        IsCacheUsed{false},
+        IsCacheHit{false},
+        IsResultCacheHit{false},
+        IsTimedOut{false},
+        IsTiered{false},
+        IsBoxInfeasible{false},
+        EliminatedVarCount{0},
+        AnswerTier{ExecTier::kJIT},
+        InterpreterEvalCount{0},
+        JITEvalCount{0}
+{}
+
+static inline float
+elapsedTimeFrom(const std::chrono::steady_clock::time_point& st_time)
+{
+    const auto res = std::chrono::duration_cast<std::chrono::milliseconds>
+            (std::chrono::steady_clock::now() - st_time).count();
+    return static_cast<float>(res) / 1000;
+}
+
+static inline double
+secondsFrom(const std::chrono::steady_clock::time_point& st_time)
+{
+    return std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - st_time).count();
+}
+
+static void printJSONString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+/// JSON has no representation of inf and nan
+static void printJSONNumber(std::ostream& out, double value)
+{
+    if (std::isfinite(value)) {
+        out << value;
+    } else {
+        out << "null";
+    }
+}
+
+/**
+ * /brief Intersects inferred bounds with [-bound, bound], which keeps
+ * sampling dense where inference gives no information. Bounds of a variable
+ * lying entirely outside are kept as inferred.
+ */
+static void
+clipBounds(const FPIntervalAnalyzer& analyzer, double bound,
+           std::vector<double>* lower_bounds, std::vector<double>* upper_bounds)
+{
+    lower_bounds->clear();
+    upper_bounds->clear();
+    for (unsigned i = 0; i < analyzer.getVarCount(); ++i) {
+        const double lower = analyzer.getLowerBounds()[i];
+        const double upper = analyzer.getUpperBounds()[i];
+        if (lower > bound || upper < -bound) {
+            lower_bounds->push_back(lower);
+            upper_bounds->push_back(upper);
+        } else {
+            lower_bounds->push_back(std::max(lower, -bound));
+            upper_bounds->push_back(std::min(upper, bound));
+        }
+    }
+}
+
+/**
+ * /brief Applies the time limit, statistics, and search box common to all
+ * optimizers, where a zero max_time means no limit
+ */
+template <typename Optimizer>
+static void setUpOptimizer(Optimizer& optimizer, double max_time,
+                           OptStatistics* stats,
+                           const std::vector<double>& lower_bounds,
+                           const std::vector<double>& upper_bounds)
+{
+    if (max_time > 0) {
+        optimizer.setMaxTime(max_time);
+    }
+    optimizer.setStatistics(stats);
+    optimizer.setBounds(lower_bounds, upper_bounds);
+}
+
+/**
+ * /brief Validates a model given in the variable order of smt_expr, whose IR
+ * is generated for this purpose only
+ */
+static bool isValidModel(const z3::expr& smt_expr,
+                         const std::vector<double>& model,
+                         const std::string& func_name)
+{
+    // IR of the whole formula gives the variables to substitute
+    llvm::LLVMContext context;
+    llvm::Module module(func_name, context);
+    FPIRGenerator ir_gen(&context, &module);
+    ir_gen.genFunction(smt_expr);
+    assert(ir_gen.getVarCount() == model.size() && "Model size mismatch!");
+    ModelValidator validator(&ir_gen);
+    return validator.isValid(smt_expr, model);
+}
+
+/**
+ * /brief evaluates the objective of smt_expr at model once using the
+ * interpreter, i.e., without jitting it.
+ * /returns false if the objective can not be evaluated at model
+ */
+static bool evalObjective(const z3::expr& smt_expr,
+                          const std::vector<double>& model,
+                          const std::string& func_name, double* value)
+{
+    llvm::LLVMContext context;
+    llvm::Module module(func_name, context);
+    FPIRGenerator ir_gen(&context, &module);
+    llvm::Function* func = ir_gen.genFunction(smt_expr);
+    if (ir_gen.getVarCount() != model.size() ||
+        ir_gen.isFoundUnsupportedSMTExpr()) {
+        return false;
+    }
+    FPIRInterpreter interpreter;
+    if (!interpreter.translate(*func)) {
+        return false;
+    }
+    *value = interpreter.eval(model.data());
+    return true;
+}
+
+/**
+ * /brief Jits the objective function at every optimization level and
+ * reports JIT time against evaluation time relative to -O0. Evaluation
+ * time is given for single and batch evaluation. Break-even is
+ * the number of evaluations after which a level pays off its extra JIT time.
+ * IR is generated for this purpose only, hence, the objective jitted for
+ * solving is neither affected nor cached with the extra batch function.
+ */
+static void
+printJITReport(const z3::expr& smt_expr, const std::string& func_name)
+{
+    llvm::LLVMContext context;
+    llvm::Module module(func_name, context);
+    FPIRGenerator ir_gen(&context, &module);
+    ir_gen.genFunction(smt_expr);
+    ir_gen.genBatchFunction();
+    const unsigned dim = ir_gen.getVarCount();
+    const unsigned eval_count = 20000;
+    std::mt19937_64 rand_gen(1);
+    std::uniform_real_distribution<double> rand_dist(-1e9, 1e9);
+    std::vector<double> points(dim * eval_count);
+    std::vector<double> results(eval_count);
+    for (auto& val : points) {
+        val = rand_dist(rand_gen);
+    }
+    double base_jit_time = 0;
+    double base_eval_time = 0;
+    for (unsigned level = 0; level <= 3; ++level) {
+        FPJITCompiler jit_compiler(level);
+        if (!jit_compiler.compile(llvm::CloneModule(&module))) {
+            std::cerr << func_name << ",O" << level << ",error,"
+                      << jit_compiler.getErrorStr() << "\n";
+            continue;
+        }
+        auto func_ptr = reinterpret_cast<nlopt_func>(
+                jit_compiler.getFunctionAddress(CodeGenStr::kFunName));
+        auto batch_func_ptr = reinterpret_cast<BatchFunc>(
+                jit_compiler.getFunctionAddress(CodeGenStr::kBatchFunName));
+        volatile double sink = 0;
+        auto time_start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < eval_count; ++i) {
+            sink = func_ptr(dim, points.data() + i * dim, nullptr, nullptr);
+        }
+        (void) sink;
+        const double eval_time = std::chrono::duration<double>
+                (std::chrono::steady_clock::now() - time_start).count()
+                                 / eval_count;
+        time_start = std::chrono::steady_clock::now();
+        batch_func_ptr(dim, eval_count, points.data(), results.data());
+        const double batch_eval_time = std::chrono::duration<double>
+                (std::chrono::steady_clock::now() - time_start).count()
+                                       / eval_count;
+        const double jit_time = jit_compiler.getIROptTime() +
+                                jit_compiler.getCodeGenTime();
+        if (level == 0) {
+            base_jit_time = jit_time;
+            base_eval_time = eval_time;
+        }
+        std::cerr << std::setprecision(4);
+        std::cerr << func_name << ",O" << level << ","
+                  << jit_compiler.getIROptTime() << ","
+                  << jit_compiler.getCodeGenTime() << ","
+                  << eval_time * 1e9 << "ns,"
+                  << batch_eval_time * 1e9 << "ns,"
+                  << base_eval_time / eval_time << "x,";
+        if (level == 0 || eval_time >= base_eval_time) {
+            std::cerr << "-\n";
+        } else {
+            std::cerr << static_cast<unsigned long>(
+                    (jit_time - base_jit_time) /
+                    (base_eval_time - eval_time)) << "\n";
+        }
+    }
+}
+
+/**
+ * /brief JIT state of a formula. In tiered execution, it is shared with a
+ * background compilation which may outlive the call to solve.
+ */
+struct JITSession {
+    explicit JITSession(unsigned opt_level) : Compiler{opt_level}
+    {}
+
+    llvm::LLVMContext Context;
+    std::unique_ptr<FPObjectCache> ObjCache;
+    FPJITCompiler Compiler;
+    std::unique_ptr<FPTieredFunction> TieredFunc;
+};
+
+static std::mutex s_compile_mutex;
+static std::condition_variable s_compile_cond;
+static unsigned s_compile_count = 0;
+
+/**
+ * /brief Jits module on a detached thread and hot-swaps the result into
+ * the tiered function of session. The session is released by the thread.
+ */
+static void
+compileInBackground(std::shared_ptr<JITSession> session,
+                    std::unique_ptr<llvm::Module> module,
+                    const std::string& func_name)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_compile_mutex);
+        ++s_compile_count;
+    }
+    std::thread([session, func_name](std::unique_ptr<llvm::Module> module)
+                        mutable {
+        if (session->Compiler.compile(std::move(module))) {
+            session->TieredFunc->setJITFunction(
+                    reinterpret_cast<nlopt_func>(
+                            session->Compiler.getFunctionAddress(
+                                    CodeGenStr::kFunName)));
+        } else {
+            std::cerr << func_name << ": Failed to jit objective function: "
+                      << session->Compiler.getErrorStr() << "\n";
+        }
+        // LLVM may be shut down as soon as the count drops to zero
+        session.reset();
+        std::lock_guard<std::mutex> lock(s_compile_mutex);
+        --s_compile_count;
+        s_compile_cond.notify_all();
+    }, std::move(module)).detach();
+}
+
+void FPSolver::waitForBackgroundCompilations()
+{
+    std::unique_lock<std::mutex> lock(s_compile_mutex);
+    s_compile_cond.wait(lock, []() { return s_compile_count == 0; });
+}
+
+FPSolver::FPSolver(const SolverOptions& options) :
+        m_options{options}
+{}
+
+void FPSolver::initializeNativeTarget()
+{
+    static std::once_flag init_flag;
+    std::call_once(init_flag, []() {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        // global state of LLVM and z3 is released by the embedding
+        // process, compilations finish before its handlers run
+        atexit(FPSolver::waitForBackgroundCompilations);
+    });
+}
+
+SolverResult
+FPSolver::solveFile(z3::context& smt_ctx, const std::string& file_path)
+{
+    const auto time_start = std::chrono::steady_clock::now();
+    z3::expr smt_expr = smt_ctx.parse_file(file_path.c_str());
+    const double parse_time = secondsFrom(time_start);
+    SolverResult result = solve(smt_expr,
+                                FPExprCodeGenerator::getFuncNameFrom(file_path));
+    result.Stats.ParseTime = parse_time;
+    return result;
+}
+
+SolverResult
+FPSolver::solveString(z3::context& smt_ctx, const std::string& smt_str,
+                      const std::string& func_name)
+{
+    const auto time_start = std::chrono::steady_clock::now();
+    z3::expr smt_expr = smt_ctx.parse_string(smt_str.c_str());
+    const double parse_time = secondsFrom(time_start);
+    SolverResult result = solve(smt_expr, func_name);
+    result.Stats.ParseTime = parse_time;
+    return result;
+}
+
+SolverResult
+FPSolver::solve(const z3::expr& smt_expr, const std::string& func_name)
+{
+    using namespace llvm;
+    initializeNativeTarget();
+    SolverResult result;
+    result.FuncName = func_name;
+    std::chrono::steady_clock::time_point
+            time_start = std::chrono::steady_clock::now();
+    if (m_options.UseResultCache) {
+        return solveCached(smt_expr, func_name, time_start);
+    }
+    if (!m_options.PresolveStages.empty()) {
+        return solvePresolved(smt_expr, func_name, time_start);
+    }
+    if (m_options.EliminateVars) {
+        FPVarEliminator eliminator;
+        const z3::expr reduced_expr = eliminator.eliminate(smt_expr);
+        if (eliminator.getEliminatedCount() > 0) {
+            return solveEliminated(smt_expr, reduced_expr, eliminator,
+                                   func_name, time_start);
+        }
+    }
+    if (m_options.SplitComponents) {
+        FPExprSplitter splitter;
+        const auto components = splitter.split(smt_expr);
+        if (components.size() > 1) {
+            return solveComponents(smt_expr, components,
+                                   splitter.getVarCount(), func_name,
+                                   time_start);
+        }
+    }
+    // empty unless bounds are inferred
+    std::vector<double> lower_bounds;
+    std::vector<double> upper_bounds;
+    if (m_options.InferBounds) {
+        FPIntervalAnalyzer interval_analyzer;
+        if (!interval_analyzer.analyze(smt_expr)) {
+            result.IsBoxInfeasible = true;
+            result.Status = NLOPT_FAILURE;
+            result.ElapsedTime = elapsedTimeFrom(time_start);
+            return result;
+        }
+        clipBounds(interval_analyzer, OptConfig().Bound, &lower_bounds,
+                   &upper_bounds);
+    }
+
+    // JIT formula to an objective function
+    auto session = std::make_shared<JITSession>(m_options.OptLevel);
+    LLVMContext& context = session->Context;
+    std::string cache_key;
+    FPObjectCacheEntry cache_entry{0, false, 0, 0};
+    // ULP search evaluates incrementally, using the interpreter if tiered
+    // and using the jitted gofunc_inc otherwise
+    const bool is_ulp_search = (m_options.Algorithm == kULPSearch);
+    const bool has_inc_func = is_ulp_search &&
+                              !m_options.UseTieredExecution;
+    // CMA-ES evaluates its population using the jitted gofunc_batch
+    const bool has_batch_func = (m_options.Algorithm == kCMAES) &&
+                                !m_options.UseTieredExecution;
+    if (m_options.UseObjectCache || !m_options.CacheDir.empty()) {
+        session->ObjCache = std::make_unique<FPObjectCache>(
+                m_options.CacheDir.empty() ?
+                FPObjectCache::getDefaultCacheDir() : m_options.CacheDir);
+        // objects of runs jitting different entry points must not be
+        // mixed up, e.g., CRS2 runs lack gofunc_inc
+        std::vector<std::string> entry_points = {CodeGenStr::kFunName};
+        if (has_inc_func) {
+            entry_points.push_back(CodeGenStr::kIncFunName);
+        }
+        if (has_batch_func) {
+            entry_points.push_back(CodeGenStr::kBatchFunName);
+        }
+        FPExprHasher hasher;
+        cache_key = session->ObjCache->genKey(hasher.hash(smt_expr),
+                                              m_options.OptLevel,
+                                              entry_points);
+        std::vector<z3::expr> fp_vars;
+        fpa_util::collectFPVars(smt_expr, &fp_vars);
+        cache_entry.NodeCount = FPExprAnalyzer::countNodes(smt_expr);
+        cache_entry.FPVarCount = static_cast<unsigned>(fp_vars.size());
+        result.IsCacheUsed = true;
+        result.IsCacheHit = session->ObjCache->lookup(
+                cache_key, cache_entry.NodeCount, cache_entry.FPVarCount,
+                &cache_entry);
+        result.Stats.CacheLookupTime = secondsFrom(time_start);
+    }
+    FPObjectCache* obj_cache = session->ObjCache.get();
+    std::unique_ptr<Module> module = std::make_unique<Module>(
+            StringRef(func_name), context);
+    FPIRGenerator ir_gen(&context, module.get());
+    if (!result.IsCacheHit || m_options.ValidateModel || is_ulp_search) {
+        // on cache hits, IR is only needed for variables of the model and
+        // for ULP search, which needs its clauses
+        const auto phase_start = std::chrono::steady_clock::now();
+        ir_gen.genFunction(smt_expr);
+        if (has_inc_func && !result.IsCacheHit) {
+            ir_gen.genIncrementalFunction();
+        }
+        if (has_batch_func && !result.IsCacheHit) {
+            ir_gen.genBatchFunction();
+        }
+        result.Stats.IRGenTime = secondsFrom(phase_start);
+    }
+    if (m_options.PrintJITReport) {
+        printJITReport(smt_expr, func_name);
+    }
+    // the interpreter evaluates incrementally right away, the objective is
+    // not jitted at all
+    std::unique_ptr<FPIRInterpreter> ulp_interpreter;
+    if (is_ulp_search && !has_inc_func) {
+        ulp_interpreter = std::make_unique<FPIRInterpreter>();
+        if (ulp_interpreter->translate(
+                *module->getFunction(CodeGenStr::kFunName))) {
+            ulp_interpreter->indexDependencies();
+        } else {
+            ulp_interpreter.reset();
+        }
+    }
+    if (ulp_interpreter != nullptr) {
+        // nothing is jitted, hence, a cached object is never loaded
+        result.IsCacheUsed = false;
+        result.IsCacheHit = false;
+    }
+    if (m_options.UseTieredExecution && !result.IsCacheHit &&
+        ulp_interpreter == nullptr) {
+        // cached objects are loaded quickly, there is nothing to hide
+        auto interpreter = std::make_unique<FPIRInterpreter>();
+        if (interpreter->translate(
+                *module->getFunction(CodeGenStr::kFunName))) {
+            session->TieredFunc = std::make_unique<FPTieredFunction>(
+                    std::move(interpreter));
+            result.IsTiered = true;
+        }
+    }
+    // module handed to the compiler, on cache hits the module of ir_gen
+    // stays alive since its IR is used for the model and ULP search
+    std::unique_ptr<Module> jit_module;
+    if (obj_cache != nullptr && result.IsCacheHit) {
+        // an empty module suffices to load the cached object
+        jit_module = std::make_unique<Module>(StringRef(cache_key), context);
+    } else {
+        if (obj_cache != nullptr) {
+            module->setModuleIdentifier(cache_key);
+        }
+        jit_module = std::move(module);
+    }
+    session->Compiler.setObjectCache(obj_cache);
+    std::future<bool> is_compiled;
+    if (ulp_interpreter != nullptr) {
+        // nothing to compile
+    } else if (result.IsTiered) {
+        compileInBackground(session, std::move(jit_module), func_name);
+    } else {
+        is_compiled = session->Compiler.compileAsync(std::move(jit_module));
+    }
+    // overlapped with compilation, an entry is ignored until its object
+    // is written by the cache
+    if (obj_cache != nullptr && !result.IsCacheHit &&
+        ulp_interpreter == nullptr) {
+        cache_entry.VarCount = ir_gen.getVarCount();
+        cache_entry.HasUnsupportedExpr = ir_gen.isFoundUnsupportedSMTExpr();
+        obj_cache->storeEntry(cache_key, cache_entry);
+    }
+    const unsigned var_count = (result.IsCacheHit) ? cache_entry.VarCount :
+                               ir_gen.getVarCount();
+    result.HasUnsupportedExpr = (result.IsCacheHit) ?
+                                cache_entry.HasUnsupportedExpr :
+                                ir_gen.isFoundUnsupportedSMTExpr();
+    result.Model.resize(var_count, 0.0);
+    nlopt_func func_ptr = FPTieredFunction::evalFunc;
+    void* func_data = session->TieredFunc.get();
+    IncFunc inc_func_ptr = nullptr;
+    BatchFunc batch_func_ptr = nullptr;
+    if (ulp_interpreter != nullptr) {
+        func_ptr = FPIRInterpreter::evalFunc;
+        func_data = ulp_interpreter.get();
+    } else if (!result.IsTiered) {
+        if (!is_compiled.get()) {
+            std::cerr << func_name << ": Failed to jit objective function: "
+                      << session->Compiler.getErrorStr()
+                      << "\n";
+            result.Status = NLOPT_FAILURE;
+            result.ElapsedTime = elapsedTimeFrom(time_start);
+            return result;
+        }
+        func_ptr = reinterpret_cast<nlopt_func>(
+                session->Compiler.getFunctionAddress(CodeGenStr::kFunName));
+        if (has_inc_func) {
+            inc_func_ptr = reinterpret_cast<IncFunc>(
+                    session->Compiler.getFunctionAddress(
+                            CodeGenStr::kIncFunName));
+        }
+        if (has_batch_func) {
+            batch_func_ptr = reinterpret_cast<BatchFunc>(
+                    session->Compiler.getFunctionAddress(
+                            CodeGenStr::kBatchFunName));
+        }
+        result.Stats.IROptTime = session->Compiler.getIROptTime();
+        result.Stats.CodeGenTime = session->Compiler.getCodeGenTime();
+    }
+
+    // Now working with optimization backend
+    goSATAlgorithm current_alg = (m_options.Algorithm == kUndefinedAlg) ?
+                                 kCRS2 : m_options.Algorithm;
+    if (current_alg == kULPSearch && ulp_interpreter == nullptr &&
+        inc_func_ptr == nullptr) {
+        // the objective can not be evaluated incrementally
+        current_alg = kCRS2;
+    }
+    // the budget covers JIT time as well
+    const double remaining_time = m_options.Timeout - secondsFrom(time_start);
+    const double max_time = (m_options.Timeout > 0) ? remaining_time : 0;
+    OptStatistics* opt_stats = (m_options.CollectStatistics ||
+                                m_options.CountEvaluations) ?
+                               &result.Stats.Opt : nullptr;
+    result.Stats.Opt.StartTime = std::chrono::steady_clock::now();
+    result.Stats.Opt.IsTraced = m_options.CollectStatistics;
+    if (var_count == 0) {
+        // const function
+        result.Minima = (func_ptr)(0, nullptr, nullptr, func_data);
+        result.Stats.Opt.EvalCount = 1;
+    } else if (m_options.Timeout > 0 && remaining_time <= 0) {
+        result.Minima = (func_ptr)(var_count, result.Model.data(), nullptr,
+                                   func_data);
+        result.Status = (result.Minima == 0) ? 0 : NLOPT_MAXTIME_REACHED;
+    } else if (current_alg == kPortfolio) {
+        PortfolioOptimizer portfolio(getThreadCount());
+        setUpOptimizer(portfolio, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        portfolio.setFunctionData(func_data);
+        result.Status = portfolio.optimize(func_ptr, var_count,
+                                           result.Model.data(),
+                                           &result.Minima);
+        result.WorkerResults = portfolio.getWorkerResults();
+    } else if (current_alg == kIslands) {
+        IslandOptimizer islands(getThreadCount());
+        setUpOptimizer(islands, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        islands.setFunctionData(func_data);
+        result.Status = islands.optimize(func_ptr, var_count,
+                                         result.Model.data(), &result.Minima);
+        result.WorkerResults = islands.getWorkerResults();
+    } else if (current_alg == kPartition) {
+        PartitionOptimizer partition(static_cast<nlopt_algorithm>(
+                m_options.PartitionAlgorithm), getThreadCount());
+        setUpOptimizer(partition, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        partition.setFunctionData(func_data);
+        result.Status = partition.optimize(func_ptr, var_count,
+                                           result.Model.data(),
+                                           &result.Minima);
+        result.WorkerResults = partition.getWorkerResults();
+    } else if (current_alg == kBasinHopping) {
+        BasinHoppingOptimizer basin_hopping(getThreadCount());
+        setUpOptimizer(basin_hopping, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        basin_hopping.setFunctionData(func_data);
+        result.Status = basin_hopping.optimize(func_ptr, var_count,
+                                               result.Model.data(),
+                                               &result.Minima);
+        result.WorkerResults = basin_hopping.getWorkerResults();
+    } else if (current_alg == kULPSearch) {
+        ULPSearchOptimizer ulp_search(getThreadCount());
+        setUpOptimizer(ulp_search, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        if (ulp_interpreter != nullptr) {
+            result.Status = ulp_search.optimize(*ulp_interpreter, var_count,
+                                                result.Model.data(),
+                                                &result.Minima);
+        } else {
+            result.Status = ulp_search.optimize(inc_func_ptr,
+                                                ir_gen.getClauseCount(),
+                                                var_count,
+                                                result.Model.data(),
+                                                &result.Minima);
+        }
+    } else if (current_alg == kCMAES) {
+        CMAESOptimizer cma_es(getThreadCount());
+        setUpOptimizer(cma_es, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        cma_es.setFunctionData(func_data);
+        cma_es.setBatchFunction(batch_func_ptr);
+        result.Status = cma_es.optimize(func_ptr, var_count,
+                                        result.Model.data(), &result.Minima);
+    } else {
+        NLoptOptimizer nl_opt(static_cast<nlopt_algorithm>(current_alg));
+        setUpOptimizer(nl_opt, max_time, opt_stats, lower_bounds,
+                       upper_bounds);
+        nl_opt.setFunctionData(func_data);
+        result.Status = nl_opt.optimize(func_ptr, var_count,
+                                        result.Model.data(),
+                                        &result.Minima);
+    }
+    result.IsSat = (result.Minima == 0 && !result.HasUnsupportedExpr);
+    result.IsTimedOut = NLoptOptimizer::isTimeout(result.Status);
+    result.Stats.OptTime = secondsFrom(result.Stats.Opt.StartTime);
+    if (result.IsTiered) {
+        const auto tiered_func = session->TieredFunc.get();
+        result.AnswerTier = tiered_func->getBestTier();
+        result.InterpreterEvalCount =
+                tiered_func->getEvalCount(ExecTier::kInterpreter);
+        result.JITEvalCount = tiered_func->getEvalCount(ExecTier::kJIT);
+        if (tiered_func->isJITReady()) {
+            // otherwise compilation is still running
+            result.Stats.IROptTime = session->Compiler.getIROptTime();
+            result.Stats.CodeGenTime = session->Compiler.getCodeGenTime();
+        }
+    }
+    result.ElapsedTime = elapsedTimeFrom(time_start);
+    if (result.Minima == 0 && m_options.ValidateModel) {
+        const auto phase_start = std::chrono::steady_clock::now();
+        ModelValidator validator(&ir_gen);
+        result.IsModelValidated = true;
+        result.IsModelValid = validator.isValid(smt_expr, result.Model);
+        result.Stats.ValidationTime = secondsFrom(phase_start);
+    }
+    return result;
+}
+
+unsigned FPSolver::getThreadCount() const noexcept
+{
+    return std::max((m_options.ThreadCount == 0) ?
+                    std::thread::hardware_concurrency() :
+                    m_options.ThreadCount, 1u);
+}
+
+std::string FPSolver::genSearchOptionsStr() const
+{
+    std::string result = "j=" + std::to_string(getThreadCount());
+    if (m_options.Algorithm == kPartition) {
+        result += ",partition=" + std::to_string(
+                static_cast<int>(m_options.PartitionAlgorithm));
+    }
+    result += ",presolve=";
+    for (const auto stage : m_options.PresolveStages) {
+        result += std::to_string(static_cast<int>(stage)) + ":";
+    }
+    result += ",bounds=" + std::to_string(m_options.InferBounds) +
+              ",elim=" + std::to_string(m_options.EliminateVars) +
+              ",split=" + std::to_string(m_options.SplitComponents);
+    return result;
+}
+
+SolverResult FPSolver::solveComponents
+        (const z3::expr& smt_expr,
+         const std::vector<FPExprComponent>& components, unsigned var_count,
+         const std::string& func_name,
+         const std::chrono::steady_clock::time_point& time_start)
+{
+    const auto component_count = static_cast<unsigned>(components.size());
+    // z3 contexts are not thread-safe, hence, components are translated
+    // to their own contexts before solving starts
+    std::vector<std::unique_ptr<z3::context>> contexts;
+    std::vector<z3::expr> exprs;
+    for (const auto& component : components) {
+        contexts.emplace_back(std::make_unique<z3::context>());
+        exprs.push_back(z3::to_expr(
+                *contexts.back(), Z3_translate(smt_expr.ctx(), component.Expr,
+                                               *contexts.back())));
+    }
+    const unsigned thread_count = getThreadCount();
+    SolverOptions options = m_options;
+    options.SplitComponents = false;
+    // the merged model is validated instead
+    options.ValidateModel = false;
+    // cores are shared among concurrently solved components
+    options.ThreadCount = std::max(thread_count / component_count, 1u);
+    std::vector<SolverResult> results(component_count);
+    {
+        ThreadPool pool(std::min(thread_count, component_count));
+        for (unsigned i = 0; i < component_count; ++i) {
+            pool.submit([&, i](unsigned) {
+                SolverOptions component_options = options;
+                if (m_options.Timeout > 0) {
+                    // queued components get what is left of the budget
+                    component_options.Timeout = std::max(
+                            m_options.Timeout - secondsFrom(time_start),
+                            1e-3);
+                }
+                FPSolver solver(component_options);
+                results[i] = solver.solve(exprs[i], func_name);
+            });
+        }
+        pool.wait();
+    }
+
+    SolverResult result;
+    result.FuncName = func_name;
+    result.Model.resize(var_count, 0.0);
+    result.Minima = 0;
+    result.IsSat = true;
+    result.IsCacheHit = true;
+    // status and tier are reported of the component farthest from a zero
+    unsigned worst = 0;
+    for (unsigned i = 0; i < component_count; ++i) {
+        const auto& component_result = results[i];
+        const auto& var_ids = components[i].VarIds;
+        assert(var_ids.size() == component_result.Model.size() &&
+               "Model size mismatch!");
+        for (unsigned j = 0; j < var_ids.size(); ++j) {
+            result.Model[var_ids[j]] = component_result.Model[j];
+        }
+        result.Minima += component_result.Minima;
+        result.IsSat = result.IsSat && component_result.IsSat;
+        result.HasUnsupportedExpr = result.HasUnsupportedExpr ||
+                                    component_result.HasUnsupportedExpr;
+        result.IsCacheUsed = component_result.IsCacheUsed;
+        result.IsCacheHit = result.IsCacheHit && component_result.IsCacheHit;
+        result.IsTimedOut = result.IsTimedOut || component_result.IsTimedOut;
+        result.IsTiered = result.IsTiered || component_result.IsTiered;
+        result.IsBoxInfeasible = result.IsBoxInfeasible ||
+                                 component_result.IsBoxInfeasible;
+        result.InterpreterEvalCount += component_result.InterpreterEvalCount;
+        result.JITEvalCount += component_result.JITEvalCount;
+        result.WorkerResults.insert(result.WorkerResults.end(),
+                                    component_result.WorkerResults.cbegin(),
+                                    component_result.WorkerResults.cend());
+        // phase times are summed over components
+        const auto& stats = component_result.Stats;
+        result.Stats.CacheLookupTime += stats.CacheLookupTime;
+        result.Stats.IRGenTime += stats.IRGenTime;
+        result.Stats.IROptTime += stats.IROptTime;
+        result.Stats.CodeGenTime += stats.CodeGenTime;
+        result.Stats.OptTime += stats.OptTime;
+        result.Stats.Opt.EvalCount += stats.Opt.EvalCount;
+        if (results[worst].Status >= 0 &&
+            (component_result.Status < 0 ||
+             component_result.Minima > results[worst].Minima)) {
+            worst = i;
+        }
+    }
+    result.Status = results[worst].Status;
+    result.AnswerTier = results[worst].AnswerTier;
+    result.IsCacheHit = result.IsCacheUsed && result.IsCacheHit;
+    result.ElapsedTime = elapsedTimeFrom(time_start);
+    if (result.Minima == 0 && m_options.ValidateModel) {
+        const auto phase_start = std::chrono::steady_clock::now();
+        result.IsModelValidated = true;
+        result.IsModelValid = isValidModel(smt_expr, result.Model, func_name);
+        result.Stats.ValidationTime = secondsFrom(phase_start);
+    }
+    return result;
+}
+
+SolverResult FPSolver::solveEliminated
+        (const z3::expr& smt_expr, const z3::expr& reduced_expr,
+         const FPVarEliminator& eliminator, const std::string& func_name,
+         const std::chrono::steady_clock::time_point& time_start)
+{
+    SolverOptions options = m_options;
+    options.EliminateVars = false;
+    // the reconstructed model is validated instead
+    options.ValidateModel = false;
+    if (m_options.Timeout > 0) {
+        options.Timeout = std::max(m_options.Timeout - secondsFrom(time_start),
+                                   1e-3);
+    }
+    FPSolver solver(options);
+    SolverResult result = solver.solve(reduced_expr, func_name);
+    result.EliminatedVarCount = eliminator.getEliminatedCount();
+    if (result.Model.size() == eliminator.getReducedVarCount()) {
+        // otherwise, solving stopped before optimization
+        result.Model = eliminator.reconstructModel(result.Model);
+    }
+    result.ElapsedTime = elapsedTimeFrom(time_start);
+    if (result.Minima == 0 && m_options.ValidateModel) {
+        const auto phase_start = std::chrono::steady_clock::now();
+        result.IsModelValidated = true;
+        result.IsModelValid = isValidModel(smt_expr, result.Model, func_name);
+        result.Stats.ValidationTime = secondsFrom(phase_start);
+    }
+    return result;
+}
+
+SolverResult FPSolver::solvePresolved
+        (const z3::expr& smt_expr, const std::string& func_name,
+         const std::chrono::steady_clock::time_point& time_start)
+{
+    FPExprPresolver presolver(m_options.PresolveStages);
+    const z3::expr presolved_expr = presolver.presolve(smt_expr);
+    const double presolve_time = secondsFrom(time_start);
+    SolverOptions options = m_options;
+    options.PresolveStages.clear();
+    // the mapped model is validated instead
+    options.ValidateModel = false;
+    if (m_options.Timeout > 0) {
+        options.Timeout = std::max(m_options.Timeout - presolve_time, 1e-3);
+    }
+    FPSolver solver(options);
+    SolverResult result = solver.solve(presolved_expr, func_name);
+    result.Stats.PresolveTime = presolve_time;
+    result.Stats.Presolve = presolver.getStageResults();
+    if (result.Model.size() == presolver.getPresolvedVarCount()) {
+        // otherwise, solving stopped before optimization
+        result.Model = presolver.reconstructModel(result.Model);
+    }
+    result.ElapsedTime = elapsedTimeFrom(time_start);
+    if (result.Minima == 0 && m_options.ValidateModel) {
+        const auto phase_start = std::chrono::steady_clock::now();
+        result.IsModelValidated = true;
+        result.IsModelValid = isValidModel(smt_expr, result.Model, func_name);
+        result.Stats.ValidationTime = secondsFrom(phase_start);
+    }
+    return result;
+}
+
+SolverResult FPSolver::solveCached
+        (const z3::expr& smt_expr, const std::string& func_name,
+         const std::chrono::steady_clock::time_point& time_start)
+{
+    FPResultCache result_cache(m_options.CacheDir.empty() ?
+                               FPObjectCache::getDefaultCacheDir() :
+                               m_options.CacheDir);
+    FPExprHasher hasher(true);
+    const std::string key = result_cache.genKey(hasher.hash(smt_expr));
+    const int algorithm = (m_options.Algorithm == kUndefinedAlg) ?
+                          kCRS2 : m_options.Algorithm;
+    const std::string search_options = genSearchOptionsStr();
+    FPResultCacheEntry entry;
+    if (result_cache.lookup(key, &entry)) {
+        double value = 1.0;
+        // a model is checked by a single evaluation in case of hash
+        // collisions or stale entries
+        const bool is_model_reused =
+                entry.IsSat &&
+                evalObjective(smt_expr, entry.Model, func_name, &value) &&
+                value == 0;
+        // a run which exhausted its evaluation budget is repeated by any
+        // run of the same options, otherwise, by runs of at most its
+        // timeout. An unlimited run is at least as long as any limited one.
+        const bool is_unknown_reused =
+                !entry.IsSat && entry.Algorithm == algorithm &&
+                entry.SearchOptions == search_options && entry.EvalCount > 0 &&
+                (!NLoptOptimizer::isTimeout(entry.Status) ||
+                 entry.Timeout == 0 ||
+                 (m_options.Timeout > 0 && m_options.Timeout <= entry.Timeout));
+        if (is_model_reused || is_unknown_reused) {
+            SolverResult result;
+            result.FuncName = func_name;
+            result.IsResultCacheHit = true;
+            result.IsSat = is_model_reused;
+            result.Minima = is_model_reused ? 0 : entry.Minima;
+            result.Status = entry.Status;
+            result.IsTimedOut = NLoptOptimizer::isTimeout(entry.Status);
+            result.Model = entry.Model;
+            result.Stats.CacheLookupTime = secondsFrom(time_start);
+            result.ElapsedTime = elapsedTimeFrom(time_start);
+            if (is_model_reused && m_options.ValidateModel) {
+                const auto phase_start = std::chrono::steady_clock::now();
+                result.IsModelValidated = true;
+                result.IsModelValid = isValidModel(smt_expr, result.Model,
+                                                   func_name);
+                result.Stats.ValidationTime = secondsFrom(phase_start);
+            }
+            return result;
+        }
+    }
+    const double lookup_time = secondsFrom(time_start);
+    SolverOptions options = m_options;
+    options.UseResultCache = false;
+    // unknown results are stored along with their evaluation count
+    options.CountEvaluations = true;
+    if (m_options.Timeout > 0) {
+        options.Timeout = std::max(m_options.Timeout - lookup_time, 1e-3);
+    }
+    FPSolver solver(options);
+    SolverResult result = solver.solve(smt_expr, func_name);
+    result.Stats.CacheLookupTime += lookup_time;
+    result.ElapsedTime = elapsedTimeFrom(time_start);
+    // failures before optimization, e.g., of jitting, are not stored
+    const bool is_storable =
+            !result.HasUnsupportedExpr &&
+            (result.IsSat || result.Status >= 0 || result.IsTimedOut) &&
+            !(result.IsModelValidated && !result.IsModelValid);
+    if (is_storable) {
+        entry.IsSat = result.IsSat;
+        entry.Algorithm = algorithm;
+        entry.SearchOptions = search_options;
+        entry.Timeout = m_options.Timeout;
+        entry.EvalCount = result.Stats.Opt.EvalCount;
+        entry.Status = result.Status;
+        entry.Minima = result.Minima;
+        entry.Model = result.Model;
+        result_cache.store(key, entry);
+    }
+    return result;
+}
+
+const SolverOptions& FPSolver::getOptions() const noexcept
+{
+    return m_options;
+}
+
+void FPSolver::printResult(std::ostream& out, const SolverResult& result,
+                           bool smtlib_output)
+{
+    if (result.HasUnsupportedExpr) {
+        out << "unsupported\n";
+    }
+    const char* result_str = (result.IsSat) ? "sat" : "unknown";
+    if (smtlib_output) {
+        out << result_str;
+        return;
+    }
+    if (result.Status < 0) {
+        out << std::setprecision(4);
+        out << result.FuncName << "," << result_str << ","
+            << result.ElapsedTime
+            << ",INF," << result.Status;
+    } else {
+        out << std::setprecision(4);
+        out << result.FuncName << "," << result_str << ",";
+        out << result.ElapsedTime << ",";
+        out << std::setprecision(dbl::digits10) << result.Minima << ","
+            << result.Status;
+    }
+    if (result.IsModelValidated) {
+        out << (result.IsModelValid ? ",valid" : ",invalid");
+    }
+    if (result.IsCacheUsed) {
+        out << (result.IsCacheHit ? ",cache-hit" : ",cache-miss");
+    }
+    if (result.IsTiered) {
+        out << "," << FPTieredFunction::getTierName(result.AnswerTier);
+    }
+    if (result.IsBoxInfeasible) {
+        out << ",unsat-within-bounds";
+    }
+    if (result.IsResultCacheHit) {
+        out << ",result-cache-hit";
+    }
+}
+
+void FPSolver::printModel(std::ostream& out, const SolverResult& result)
+{
+    out << result.FuncName << ",model";
+    out << std::setprecision(dbl::max_digits10);
+    for (const auto value : result.Model) {
+        out << "," << value;
+    }
+}
+
+void FPSolver::printStatistics(std::ostream& out, const SolverResult& result)
+{
+    const auto& stats = result.Stats;
+    const double evals_per_sec = (stats.OptTime > 0) ?
+                                 stats.Opt.EvalCount / stats.OptTime : 0;
+    out << std::setprecision(6);
+    out << "{\"name\":";
+    printJSONString(out, result.FuncName);
+    out << ",\"result\":\"" << (result.IsSat ? "sat" : "unknown") << "\""
+        << ",\"status\":" << result.Status
+        << ",\"minima\":";
+    printJSONNumber(out, result.Minima);
+    out << ",\"cache_hit\":" << (result.IsCacheHit ? "true" : "false")
+        << ",\"result_cache_hit\":"
+        << (result.IsResultCacheHit ? "true" : "false")
+        << ",\"eliminated_vars\":" << result.EliminatedVarCount
+        << ",\"phases\":{\"parse\":" << stats.ParseTime
+        << ",\"presolve\":" << stats.PresolveTime
+        << ",\"cache_lookup\":" << stats.CacheLookupTime
+        << ",\"irgen\":" << stats.IRGenTime
+        << ",\"iropt\":" << stats.IROptTime
+        << ",\"codegen\":" << stats.CodeGenTime
+        << ",\"optimize\":" << stats.OptTime
+        << ",\"validate\":" << stats.ValidationTime << "}"
+        << ",\"evals\":" << stats.Opt.EvalCount
+        << ",\"evals_per_sec\":" << evals_per_sec;
+    if (result.IsTiered) {
+        out << ",\"tier\":{\"answer\":\""
+            << FPTieredFunction::getTierName(result.AnswerTier) << "\""
+            << ",\"interpreter_evals\":" << result.InterpreterEvalCount
+            << ",\"jit_evals\":" << result.JITEvalCount << "}";
+    }
+    out << ",\"workers\":[";
+    for (size_t i = 0; i < result.WorkerResults.size(); ++i) {
+        const auto& worker = result.WorkerResults[i];
+        out << ((i == 0) ? "" : ",")
+            << "{\"alg\":\""
+            << NLoptOptimizer::getAlgorithmName(worker.Algorithm) << "\""
+            << ",\"seed\":" << worker.Seed
+            << ",\"evals\":" << worker.EvalCount
+            << ",\"imports\":" << worker.ImportCount << ",\"minima\":";
+        printJSONNumber(out, worker.Minima);
+        out << "}";
+    }
+    out << "],\"presolve\":[";
+    for (size_t i = 0; i < stats.Presolve.size(); ++i) {
+        const auto& stage = stats.Presolve[i];
+        out << ((i == 0) ? "" : ",")
+            << "{\"stage\":\""
+            << FPExprPresolver::getStageName(stage.Stage) << "\""
+            << ",\"time\":" << stage.Time
+            << ",\"nodes_before\":" << stage.NodeCountBefore
+            << ",\"nodes_after\":" << stage.NodeCountAfter << "}";
+    }
+    out << "],\"best_trace\":[";
+    out << std::setprecision(dbl::max_digits10);
+    for (size_t i = 0; i < stats.Opt.BestTrace.size(); ++i) {
+        out << ((i == 0) ? "[" : ",[") << stats.Opt.BestTrace[i].first << ",";
+        printJSONNumber(out, stats.Opt.BestTrace[i].second);
+        out << "]";
+    }
+    out << "]}";
+}
+
+void FPSolver::printWorkerResults(std::ostream& out, const SolverResult& result)
+{
+    unsigned worker_id = 0;
+    for (const auto& worker : result.WorkerResults) {
+        out << std::setprecision(4);
+        out << result.FuncName << ",worker" << worker_id++ << ","
+            << NLoptOptimizer::getAlgorithmName(worker.Algorithm) << ","
+            << worker.Seed << "," << worker.ElapsedTime << ","
+            << std::setprecision(dbl::digits10) << worker.Minima
+            << "," << worker.Status
+            << (worker.IsCancelled ? ",cancelled" : "") << "\n";
+    }
+}
+}
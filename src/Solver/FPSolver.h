@@ -0,0 +1,247 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "ExprAnalyzer/FPExprPresolver.h"
+#include "ExprAnalyzer/FPExprSplitter.h"
+#include "ExprAnalyzer/FPVarEliminator.h"
+#include "JIT/FPTieredFunction.h"
+#include "Optimizer/PortfolioOptimizer.h"
+#include "z3++.h"
+#include <chrono>
+#include <nlopt.h>
+#include <string>
+#include <vector>
+
+namespace gosat {
+
+enum goSATAlgorithm {
+    kUndefinedAlg = 0,
+    kCRS2 = NLOPT_GN_CRS2_LM,
+    kISRES = NLOPT_GN_ISRES,
+    kMLSL = NLOPT_G_MLSL,
+    kDirect = NLOPT_GN_DIRECT_L,
+    kPortfolio = NLOPT_NUM_ALGORITHMS,
+    kIslands,
+    kPartition,
+    kBasinHopping,
+    kCMAES,
+    kULPSearch
+};
+
+class SolverOptions {
+public:
+    SolverOptions();
+
+    virtual ~SolverOptions() = default;
+
+    goSATAlgorithm Algorithm;
+    /// NLopt algorithm searching the sub-boxes of kPartition
+    goSATAlgorithm PartitionAlgorithm;
+    /// worker threads of portfolio algorithm, zero uses core count
+    unsigned ThreadCount;
+    unsigned OptLevel;
+    bool ValidateModel;
+    bool UseObjectCache;
+    /// empty for the default cache directory
+    std::string CacheDir;
+    bool PrintJITReport;
+    /// wall-clock budget in seconds of a formula, zero means no limit
+    double Timeout;
+    bool CollectStatistics;
+    /// count evaluations of the objective without CollectStatistics, which
+    /// spares recording improvements
+    bool CountEvaluations;
+    /// interpret the objective while it is jitted in the background
+    bool UseTieredExecution;
+    /// solve variable-disjoint components of a conjunction separately
+    bool SplitComponents;
+    /// restrict the search box of all algorithms to bounds inferred by
+    /// interval propagation
+    bool InferBounds;
+    /// substitute variables defined by top-level equalities before solving
+    bool EliminateVars;
+    /// stages run in order before solving, empty disables presolving
+    std::vector<PresolveStage> PresolveStages;
+    /// reuse results of formulas equal up to renaming, which are stored
+    /// in CacheDir
+    bool UseResultCache;
+};
+
+/**
+ * /brief Time in seconds spent in each solving phase, along with
+ * statistics of the optimization phase
+ */
+class SolverStatistics {
+public:
+    SolverStatistics();
+
+    virtual ~SolverStatistics() = default;
+
+    double ParseTime;
+    double PresolveTime;
+    /// hashing the formula and probing the object cache
+    double CacheLookupTime;
+    double IRGenTime;
+    double IROptTime;
+    double CodeGenTime;
+    double OptTime;
+    double ValidationTime;
+    OptStatistics Opt;
+    /// results of presolve stages in order
+    std::vector<PresolveStageResult> Presolve;
+};
+
+class SolverResult {
+public:
+    SolverResult();
+
+    virtual ~SolverResult() = default;
+
+    std::string FuncName;
+    bool IsSat;
+    bool HasUnsupportedExpr;
+    float ElapsedTime;
+    double Minima;
+    int Status;
+    bool IsModelValidated;
+    bool IsModelValid;
+    bool IsCacheUsed;
+    bool IsCacheHit;
+    /// the result of an equal formula up to renaming was reused
+    bool IsResultCacheHit;
+    /// optimization stopped at the deadline, Model and Minima are the
+    /// best found so far
+    bool IsTimedOut;
+    /// the objective was interpreted until its jitted version was ready
+    bool IsTiered;
+    /// inferred bounds of some variable are empty, i.e., the formula is
+    /// unsat within finite values and optimization is skipped
+    bool IsBoxInfeasible;
+    /// variables substituted by their definitions, Model covers them too
+    unsigned EliminatedVarCount;
+    /// tier which evaluated Minima
+    ExecTier AnswerTier;
+    unsigned long InterpreterEvalCount;
+    unsigned long JITEvalCount;
+    std::vector<double> Model;
+    std::vector<PortfolioWorkerResult> WorkerResults;
+    /// filled only if statistics collection is enabled
+    SolverStatistics Stats;
+};
+
+/**
+ * /brief Solves a formula natively, i.e., jits its objective function and
+ * minimizes it using the optimization backend.
+ *
+ * A solver can be shared by several threads as long as each thread uses
+ * its own z3::context. Every call to solve owns an LLVM context, module,
+ * and engine which are all released before returning. In tiered execution,
+ * they are released once background compilation finishes instead.
+ */
+class FPSolver {
+public:
+    FPSolver() = delete;
+
+    explicit FPSolver(const SolverOptions& options);
+
+    virtual ~FPSolver() = default;
+
+    FPSolver(const FPSolver&) = default;
+
+    FPSolver& operator=(const FPSolver&) = default;
+
+    SolverResult solve(const z3::expr& smt_expr, const std::string& func_name);
+
+    SolverResult
+    solveFile(z3::context& smt_ctx, const std::string& file_path);
+
+    SolverResult
+    solveString(z3::context& smt_ctx, const std::string& smt_str,
+                const std::string& func_name);
+
+    const SolverOptions& getOptions() const noexcept;
+
+    /**
+     * /brief prints result in csv format (or SMT-LIBv2 format)
+     * without a trailing new line
+     */
+    static void printResult(std::ostream& out, const SolverResult& result,
+                            bool smtlib_output);
+
+    static void printWorkerResults(std::ostream& out,
+                                   const SolverResult& result);
+
+    /// prints model values in variable order without a trailing new line
+    static void printModel(std::ostream& out, const SolverResult& result);
+
+    /// prints statistics as a single-line JSON object
+    static void printStatistics(std::ostream& out, const SolverResult& result);
+
+    /// initializes native target once per process. Shutting down LLVM and
+    /// z3 is left to the process, see gosat_shutdown
+    static void initializeNativeTarget();
+
+    /// blocks until all background compilations of tiered execution finish
+    static void waitForBackgroundCompilations();
+
+private:
+    /// threads given by ThreadCount, all hardware threads if zero
+    unsigned getThreadCount() const noexcept;
+
+    /**
+     * /brief options besides Algorithm and Timeout which shape the search,
+     * hence, the evaluation budget of a run, see
+     * FPResultCacheEntry::SearchOptions
+     */
+    std::string genSearchOptionsStr() const;
+
+    /**
+     * /brief solves components concurrently, each using its own z3 context
+     * and objective, and merges their models in the variable order of
+     * smt_expr. Minima is the sum of minima of components, which equals the
+     * objective of smt_expr at the merged model.
+     */
+    SolverResult solveComponents
+            (const z3::expr& smt_expr,
+             const std::vector<FPExprComponent>& components,
+             unsigned var_count, const std::string& func_name,
+             const std::chrono::steady_clock::time_point& time_start);
+
+    /**
+     * /brief solves reduced_expr, where eliminator substituted defined
+     * variables of smt_expr, and reconstructs the model of smt_expr
+     */
+    SolverResult solveEliminated
+            (const z3::expr& smt_expr, const z3::expr& reduced_expr,
+             const FPVarEliminator& eliminator, const std::string& func_name,
+             const std::chrono::steady_clock::time_point& time_start);
+
+    /**
+     * /brief solves smt_expr after presolving it and maps the model back to
+     * the variable order of smt_expr
+     */
+    SolverResult solvePresolved
+            (const z3::expr& smt_expr, const std::string& func_name,
+             const std::chrono::steady_clock::time_point& time_start);
+
+    /**
+     * /brief answers from the result cache if it holds a model of
+     * smt_expr, or an unknown result obtained using at least the current
+     * budget. Otherwise, solves smt_expr and stores its result.
+     */
+    SolverResult solveCached
+            (const z3::expr& smt_expr, const std::string& func_name,
+             const std::chrono::steady_clock::time_point& time_start);
+
+private:
+    SolverOptions m_options;
+};
+}
@@ -0,0 +1,277 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FPSolverServer.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace gosat {
+
+/**
+ * /brief Serializes result lines written by concurrent workers to either
+ * an output stream or a socket. A socket is closed once the last pending
+ * request of its connection is answered.
+ */
+class FPSolverServer::ResponseChannel {
+public:
+    explicit ResponseChannel(std::ostream* out) : m_out{out}, m_fd{-1}
+    {}
+
+    explicit ResponseChannel(int fd) : m_out{nullptr}, m_fd{fd}
+    {}
+
+    ~ResponseChannel()
+    {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    void write(const std::string& str)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_out != nullptr) {
+            *m_out << str;
+            m_out->flush();
+            return;
+        }
+        size_t written = 0;
+        while (written < str.size()) {
+            auto res = send(m_fd, str.data() + written, str.size() - written,
+                            MSG_NOSIGNAL);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                // peer is gone, nothing else to do
+                return;
+            }
+            written += static_cast<size_t>(res);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::ostream* m_out;
+    int m_fd;
+};
+
+FPSolverServer::FPSolverServer
+        (const SolverOptions& options, unsigned worker_count,
+         bool smtlib_output) :
+        m_solver{options},
+        m_smtlib_output{smtlib_output},
+        m_formula_count{0},
+        m_pool{worker_count}
+{
+    FPSolver::initializeNativeTarget();
+    for (unsigned i = 0; i < m_pool.getThreadCount(); ++i) {
+        m_smt_ctxs.emplace_back(std::make_unique<z3::context>());
+    }
+}
+
+void FPSolverServer::submitRequest
+        (const std::string& request, bool is_smt_str,
+         const std::shared_ptr<ResponseChannel>& channel)
+{
+    std::string func_name = (is_smt_str) ?
+                            "formula" + std::to_string(m_formula_count++) :
+                            request;
+    m_pool.submit([this, request, is_smt_str, func_name, channel]
+                          (unsigned worker_id) {
+        std::ostringstream out;
+        try {
+            z3::context& smt_ctx = *m_smt_ctxs[worker_id];
+            SolverResult result = (is_smt_str) ?
+                                  m_solver.solveString(smt_ctx, request,
+                                                       func_name) :
+                                  m_solver.solveFile(smt_ctx, request);
+            FPSolver::printResult(out, result, m_smtlib_output);
+        } catch (const z3::exception& exp) {
+            out << func_name << ",error," << exp.msg();
+        }
+        out << "\n";
+        channel->write(out.str());
+    });
+}
+
+void FPSolverServer::readRequests
+        (const std::function<bool(std::string&)>& read_line,
+         const std::function<void(const std::string&, bool)>& submit)
+{
+    std::string line;
+    std::string smt_str;
+    bool is_reading_smt_str = false;
+    while (read_line(line)) {
+        auto first = line.find_first_not_of(" \t\r");
+        auto last = line.find_last_not_of(" \t\r");
+        line = (first == std::string::npos) ? "" :
+               line.substr(first, last - first + 1);
+        if (is_reading_smt_str) {
+            smt_str += line + "\n";
+            if (line == "(check-sat)") {
+                submit(smt_str, true);
+                smt_str.clear();
+                is_reading_smt_str = false;
+            }
+            continue;
+        }
+        if (line.empty() || line == "(exit)") {
+            continue;
+        }
+        if (line[0] == '(') {
+            is_reading_smt_str = (line != "(check-sat)");
+            smt_str = line + "\n";
+            if (!is_reading_smt_str) {
+                submit(smt_str, true);
+            }
+            continue;
+        }
+        submit(line, false);
+    }
+    if (is_reading_smt_str) {
+        // input ended without (check-sat)
+        submit(smt_str, true);
+    }
+}
+
+int FPSolverServer::serveStream(std::istream& in, std::ostream& out)
+{
+    auto channel = std::make_shared<ResponseChannel>(&out);
+    readRequests([&in](std::string& line) {
+        return static_cast<bool>(std::getline(in, line));
+    }, [this, &channel](const std::string& request, bool is_smt_str) {
+        submitRequest(request, is_smt_str, channel);
+    });
+    m_pool.wait();
+    return 0;
+}
+
+void FPSolverServer::serveConnection(int conn_fd)
+{
+    auto channel = std::make_shared<ResponseChannel>(conn_fd);
+    std::string buffer;
+    size_t buffer_pos = 0;
+    readRequests([conn_fd, &buffer, &buffer_pos](std::string& line) {
+        while (true) {
+            auto line_end = buffer.find('\n', buffer_pos);
+            if (line_end != std::string::npos) {
+                line = buffer.substr(buffer_pos, line_end - buffer_pos);
+                buffer_pos = line_end + 1;
+                return true;
+            }
+            buffer.erase(0, buffer_pos);
+            buffer_pos = 0;
+            char chunk[4096];
+            auto res = recv(conn_fd, chunk, sizeof(chunk), 0);
+            if (res < 0 && errno == EINTR) {
+                continue;
+            }
+            if (res <= 0) {
+                // connection closed, flush last unterminated line
+                line = buffer;
+                buffer.clear();
+                return !line.empty();
+            }
+            buffer.append(chunk, static_cast<size_t>(res));
+        }
+    }, [this, &channel](const std::string& request, bool is_smt_str) {
+        submitRequest(request, is_smt_str, channel);
+    });
+    {
+        // the channel keeps the socket open until unregistered
+        std::lock_guard<std::mutex> lock(m_conn_mutex);
+        m_conn_fds.erase(conn_fd);
+    }
+    // socket is closed by the channel once pending requests are answered
+    shutdown(conn_fd, SHUT_RD);
+}
+
+int FPSolverServer::serveUnixSocket(const std::string& socket_path)
+{
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        std::cerr << "Failed to create socket: " << std::strerror(errno)
+                  << std::endl;
+        return 1;
+    }
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path is too long!" << std::endl;
+        close(server_fd);
+        return 1;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if (bind(server_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+        || listen(server_fd, SOMAXCONN) < 0) {
+        std::cerr << "Failed to listen on socket: " << std::strerror(errno)
+                  << std::endl;
+        close(server_fd);
+        return 1;
+    }
+    struct Connection {
+        std::thread Thread;
+        std::shared_ptr<std::atomic<bool>> IsDone;
+    };
+    std::vector<Connection> connections;
+    while (true) {
+        // threads of closed connections are joined as new ones arrive
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->IsDone->load()) {
+                it->Thread.join();
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        int conn_fd = accept(server_fd, nullptr, nullptr);
+        if (conn_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Failed to accept connection: "
+                      << std::strerror(errno) << std::endl;
+            break;
+        }
+        {
+            // registered before its thread starts, so none is missed once
+            // serving stops
+            std::lock_guard<std::mutex> lock(m_conn_mutex);
+            m_conn_fds.insert(conn_fd);
+        }
+        auto is_done = std::make_shared<std::atomic<bool>>(false);
+        connections.push_back(Connection{std::thread([this, conn_fd, is_done] {
+            serveConnection(conn_fd);
+            is_done->store(true);
+        }), is_done});
+    }
+    close(server_fd);
+    unlink(socket_path.c_str());
+    {
+        // unblocks connections waiting for requests
+        std::lock_guard<std::mutex> lock(m_conn_mutex);
+        for (const auto conn_fd : m_conn_fds) {
+            shutdown(conn_fd, SHUT_RD);
+        }
+    }
+    for (auto& connection : connections) {
+        connection.Thread.join();
+    }
+    m_pool.wait();
+    return 1;
+}
+}
@@ -0,0 +1,86 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include "FPSolver.h"
+#include "Utils/ThreadPool.h"
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace gosat {
+
+/**
+ * /brief Long-running solver serving a stream of formulas.
+ *
+ * Requests are read line by line. A line holds either a path to an SMT
+ * file or the start of SMT-LIB text, i.e., a line starting with '('. Text
+ * is accumulated up to and including a line holding (check-sat).
+ * Empty lines and (exit) commands are ignored. One result line in the
+ * format of FPSolver::printResult is written back per formula as soon as
+ * it is solved, hence results may be reordered.
+ *
+ * LLVM is initialized once, and each worker keeps its z3::context for
+ * its lifetime.
+ */
+class FPSolverServer {
+public:
+    FPSolverServer() = delete;
+
+    FPSolverServer(const SolverOptions& options, unsigned worker_count,
+                   bool smtlib_output);
+
+    virtual ~FPSolverServer() = default;
+
+    FPSolverServer(const FPSolverServer&) = delete;
+
+    FPSolverServer& operator=(const FPSolverServer&) = delete;
+
+    /// serves requests until end of input
+    int serveStream(std::istream& in, std::ostream& out);
+
+    /**
+     * /brief serves connections on a unix domain socket until an error
+     * occurs. Open connections are then shut down for reading, and it
+     * returns once their pending requests are answered.
+     */
+    int serveUnixSocket(const std::string& socket_path);
+
+    /**
+     * /brief splits lines returned by read_line into requests in the format
+     * described above. submit receives a request along with whether it is
+     * SMT-LIB text, otherwise it is a file path.
+     */
+    static void
+    readRequests(const std::function<bool(std::string&)>& read_line,
+                 const std::function<void(const std::string&, bool)>& submit);
+
+private:
+    class ResponseChannel;
+
+    void serveConnection(int conn_fd);
+
+    void submitRequest(const std::string& request, bool is_smt_str,
+                       const std::shared_ptr<ResponseChannel>& channel);
+
+private:
+    FPSolver m_solver;
+    bool m_smtlib_output;
+    std::atomic<unsigned> m_formula_count;
+    std::vector<std::unique_ptr<z3::context>> m_smt_ctxs;
+    std::mutex m_conn_mutex;
+    /// sockets of connections whose requests are still being read
+    std::unordered_set<int> m_conn_fds;
+    ThreadPool m_pool;
+};
+}
@@ -11,6 +11,7 @@
 #include <cmath>
 #include <cstring>
 #include <limits>
+#include <unordered_set>
 
 /**
  * /brief Provides a scaled distance value between representations
@@ -141,6 +142,46 @@ bool isBoolExpr(const z3::expr& expr) noexcept
     }
 }
 
+bool isFPNumeral(const z3::expr& expr) noexcept
+{
+    if (!expr.is_app() ||
+        expr.get_sort().sort_kind() != Z3_FLOATING_POINT_SORT) {
+        return false;
+    }
+    switch (expr.decl().decl_kind()) {
+        case Z3_OP_FPA_PLUS_INF:
+        case Z3_OP_FPA_MINUS_INF:
+        case Z3_OP_FPA_NAN:
+        case Z3_OP_FPA_PLUS_ZERO:
+        case Z3_OP_FPA_MINUS_ZERO:
+            return true;
+        default:
+            return expr.is_numeral();
+    }
+}
+
+void collectFPVars(const z3::expr& expr, std::vector<z3::expr>* vars)
+{
+    std::unordered_set<unsigned> visited;
+    std::vector<z3::expr> stack;
+    stack.push_back(expr);
+    while (!stack.empty()) {
+        const z3::expr cur_expr = stack.back();
+        stack.pop_back();
+        if (!cur_expr.is_app() ||
+            !visited.insert(Z3_get_ast_id(cur_expr.ctx(), cur_expr)).second) {
+            continue;
+        }
+        if (isFPVar(cur_expr)) {
+            vars->push_back(cur_expr);
+            continue;
+        }
+        for (unsigned i = cur_expr.num_args(); i > 0; --i) {
+            stack.push_back(cur_expr.arg(i - 1));
+        }
+    }
+}
+
 bool
 isFloat32VarDecl(const z3::expr& expr) noexcept
 {
@@ -10,8 +10,10 @@
 #pragma once
 
 #include "z3++.h"
+#include <vector>
 
-// functions called by JIT engine
+// reference implementations of distance functions. FPIRGenerator emits
+// equivalent IR bodies into the jitted module
 
 double fp64_dis(double a, double b);
 double fp64_eq_dis(double a, double b);
@@ -53,6 +55,15 @@ bool isRoundingModeApp(const z3::expr expr) noexcept;
 
 bool isBoolExpr(const z3::expr& expr) noexcept;
 
+/// FP numerals including special values, e.g., +oo and NaN
+bool isFPNumeral(const z3::expr& expr) noexcept;
+
+/**
+ * /brief appends FP variables of expr by first occurrence in a left-to-right
+ * depth-first traversal, i.e., in the order FPIRGenerator numbers them
+ */
+void collectFPVars(const z3::expr& expr, std::vector<z3::expr>* vars);
+
 /**
  *
  * @param expr
@@ -0,0 +1,42 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "FileUtils.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace gosat {
+namespace file_util {
+
+bool writeFileAtomically
+        (const std::string& path, const char* data, size_t size)
+{
+    // names are unique across processes and threads sharing a directory
+    static std::atomic<unsigned> tmp_file_count{0};
+    const std::string tmp_path = path + ".tmp." + std::to_string(getpid()) +
+                                 "." + std::to_string(tmp_file_count++);
+    {
+        std::ofstream tmp_file(tmp_path, std::ios::out | std::ios::binary |
+                                         std::ios::trunc);
+        if (!tmp_file.good()) {
+            return false;
+        }
+        tmp_file.write(data, size);
+        if (!tmp_file.good()) {
+            tmp_file.close();
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+}
+}
@@ -0,0 +1,26 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace gosat {
+namespace file_util {
+
+/**
+ * /brief writes data to a temporary file which is then renamed to path,
+ * hence, concurrent readers, possibly of other processes, never observe
+ * partial files. Returns false if writing or renaming fails.
+ */
+bool writeFileAtomically
+        (const std::string& path, const char* data, size_t size);
+}
+}
@@ -0,0 +1,72 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief Allocates objects of type T in fixed-size blocks.
+ *
+ * Objects are never moved, hence pointers stay valid until the arena is
+ * destroyed. This replaces one heap allocation per object with one per
+ * block, and keeps objects created together close in memory.
+ */
+template <typename T, unsigned BlockSize = 1024>
+class ObjectArena {
+public:
+    ObjectArena() : m_block_used{BlockSize}
+    {}
+
+    virtual ~ObjectArena()
+    {
+        for (unsigned i = 0; i < m_blocks.size(); ++i) {
+            const unsigned used = (i + 1 == m_blocks.size()) ? m_block_used :
+                                  BlockSize;
+            for (unsigned j = 0; j < used; ++j) {
+                reinterpret_cast<T*>(&m_blocks[i][j])->~T();
+            }
+        }
+    }
+
+    ObjectArena(const ObjectArena&) = delete;
+
+    ObjectArena& operator=(const ObjectArena&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args)
+    {
+        if (m_block_used == BlockSize) {
+            m_blocks.emplace_back(new Storage[BlockSize]);
+            m_block_used = 0;
+        }
+        T* result = new(&m_blocks.back()[m_block_used])
+                T(std::forward<Args>(args)...);
+        ++m_block_used;
+        return result;
+    }
+
+    size_t size() const noexcept
+    {
+        return (m_blocks.empty()) ? 0 :
+               (m_blocks.size() - 1) * BlockSize + m_block_used;
+    }
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+    std::vector<std::unique_ptr<Storage[]>> m_blocks;
+    unsigned m_block_used;
+};
+}
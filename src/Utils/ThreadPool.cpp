@@ -0,0 +1,134 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace gosat {
+
+ThreadPool::ThreadPool(unsigned thread_count) :
+        m_is_stopped{false},
+        m_queued_count{0},
+        m_pending_count{0},
+        m_next_queue{0},
+        m_stolen_count{0}
+{
+    thread_count = std::max(thread_count, 1u);
+    for (unsigned i = 0; i < thread_count; ++i) {
+        m_queues.emplace_back(std::make_unique<JobQueue>());
+    }
+    m_threads.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; ++i) {
+        m_threads.emplace_back(&ThreadPool::runWorker, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopped = true;
+    }
+    m_job_available.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Job job)
+{
+    auto& queue = *m_queues[m_next_queue++ % m_queues.size()];
+    {
+        // counters are updated together with the queue so that a woken
+        // worker always finds the job
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::lock_guard<std::mutex> queue_lock(queue.Mutex);
+        queue.Jobs.emplace_back(std::move(job));
+        ++m_queued_count;
+        ++m_pending_count;
+    }
+    m_job_available.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobs_done.wait(lock, [this]() {
+        return m_pending_count == 0;
+    });
+}
+
+unsigned ThreadPool::getThreadCount() const noexcept
+{
+    return static_cast<unsigned>(m_threads.size());
+}
+
+unsigned long ThreadPool::getStolenJobCount() const noexcept
+{
+    return m_stolen_count;
+}
+
+bool ThreadPool::popJob(unsigned worker_id, Job* job)
+{
+    {
+        auto& queue = *m_queues[worker_id];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (!queue.Jobs.empty()) {
+            *job = std::move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+            return true;
+        }
+    }
+    const auto queue_count = m_queues.size();
+    for (unsigned i = 1; i < queue_count; ++i) {
+        auto& queue = *m_queues[(worker_id + i) % queue_count];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (!queue.Jobs.empty()) {
+            *job = std::move(queue.Jobs.back());
+            queue.Jobs.pop_back();
+            ++m_stolen_count;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runWorker(unsigned worker_id)
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_available.wait(lock, [this]() {
+                return m_is_stopped || m_queued_count > 0;
+            });
+            if (m_queued_count == 0) {
+                // stopped
+                return;
+            }
+            // a queued job is reserved before searching queues
+            --m_queued_count;
+        }
+        while (!popJob(worker_id, &job)) {
+            // a job queued behind the scan may satisfy this reservation
+            std::this_thread::yield();
+        }
+        job(worker_id);
+        bool is_done;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            is_done = (--m_pending_count == 0);
+        }
+        if (is_done) {
+            m_jobs_done.notify_all();
+        }
+    }
+}
+}
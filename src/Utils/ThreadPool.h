@@ -0,0 +1,81 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gosat {
+
+/**
+ * /brief A fixed-size pool of worker threads processing submitted jobs.
+ *
+ * Every worker owns a job queue. Jobs are distributed round-robin over
+ * queues, a worker takes jobs from the front of its own queue and, once it
+ * runs dry, steals from the back of the others. Hence, a few long jobs
+ * do not hold back jobs queued behind them.
+ *
+ * Jobs receive the id of the worker running them, which allows keeping
+ * per-worker state (e.g., a z3::context) that is reused across jobs.
+ */
+class ThreadPool {
+public:
+    using Job = std::function<void(unsigned worker_id)>;
+
+    ThreadPool() = delete;
+
+    explicit ThreadPool(unsigned thread_count);
+
+    /// waits for all submitted jobs before joining workers
+    virtual ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Job job);
+
+    /// blocks until all submitted jobs are finished
+    void wait();
+
+    unsigned getThreadCount() const noexcept;
+
+    /// number of jobs run by a worker other than the one they were queued to
+    unsigned long getStolenJobCount() const noexcept;
+
+private:
+    struct JobQueue {
+        std::mutex Mutex;
+        std::deque<Job> Jobs;
+    };
+
+    bool popJob(unsigned worker_id, Job* job);
+
+    void runWorker(unsigned worker_id);
+
+private:
+    bool m_is_stopped;
+    unsigned m_queued_count;
+    unsigned m_pending_count;
+    std::atomic<unsigned> m_next_queue;
+    std::atomic<unsigned long> m_stolen_count;
+    std::mutex m_mutex;
+    std::condition_variable m_job_available;
+    std::condition_variable m_jobs_done;
+    std::vector<std::unique_ptr<JobQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+};
+}
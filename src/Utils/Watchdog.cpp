@@ -0,0 +1,56 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "Watchdog.h"
+#include <chrono>
+
+namespace gosat {
+
+Watchdog::Watchdog(double time_budget) :
+        m_is_stopped{false},
+        m_is_expired{time_budget <= 0}
+{
+    if (m_is_expired) {
+        return;
+    }
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<
+                                  std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double>(time_budget));
+    m_thread = std::thread([this, deadline]() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_stopped.wait_until(lock, deadline,
+                                  [this]() { return m_is_stopped; })) {
+            m_is_expired.store(true);
+        }
+    });
+}
+
+Watchdog::~Watchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopped = true;
+    }
+    m_stopped.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool Watchdog::isExpired() const noexcept
+{
+    return m_is_expired.load();
+}
+
+const std::atomic<bool>* Watchdog::getExpiredFlag() const noexcept
+{
+    return &m_is_expired;
+}
+}
@@ -0,0 +1,50 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace gosat {
+
+/**
+ * /brief Raises a flag once a time budget is exhausted.
+ *
+ * A background thread sleeps until the deadline, so the hot path only
+ * needs to poll an atomic flag instead of reading the clock.
+ */
+class Watchdog {
+public:
+    Watchdog() = delete;
+
+    /// starts the watchdog, a non-positive budget expires immediately
+    explicit Watchdog(double time_budget);
+
+    /// stops the watchdog without raising its flag
+    virtual ~Watchdog();
+
+    Watchdog(const Watchdog&) = delete;
+
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    bool isExpired() const noexcept;
+
+    const std::atomic<bool>* getExpiredFlag() const noexcept;
+
+private:
+    bool m_is_stopped;
+    std::atomic<bool> m_is_expired;
+    std::mutex m_mutex;
+    std::condition_variable m_stopped;
+    std::thread m_thread;
+};
+}
@@ -8,41 +8,45 @@
 //
 
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "ExprAnalyzer/FPExprAnalyzer.h"
 #include "CodeGen/FPExprLibGenerator.h"
 #include "CodeGen/FPExprCodeGenerator.h"
-#include "IRGen/FPIRGenerator.h"
-#include "Utils/FPAUtils.h"
-#include "llvm/ExecutionEngine/ExecutionEngine.h"
-#include "llvm/ExecutionEngine/MCJIT.h"
-#include "llvm/Support/TargetSelect.h"
-#include "Optimizer/ModelValidator.h"
-#include <nlopt.h>
-#include <Optimizer/NLoptOptimizer.h>
-#include <iomanip>
-
-typedef std::numeric_limits<double> dbl;
+#include "Solver/FPBatchSolver.h"
+#include "Solver/FPForkServer.h"
+#include "Solver/FPSolver.h"
+#include "Solver/FPSolverServer.h"
+#include <fstream>
+#include <thread>
+#include <unistd.h>
 
 enum goSATMode {
     kUndefinedMode = 0,
     kFormulaAnalysis,
     kCCodeGeneration,
-    kNativeSolving
+    kNativeSolving,
+    kServer,
+    kForkServer
 };
 
-enum goSATAlgorithm {
-    kUndefinedAlg = 0,
-    kCRS2 = NLOPT_GN_CRS2_LM,
-    kISRES = NLOPT_GN_ISRES,
-    kMLSL = NLOPT_G_MLSL,
-    kDirect = NLOPT_GN_DIRECT_L
-};
+using gosat::goSATAlgorithm;
+using gosat::kUndefinedAlg;
+using gosat::kCRS2;
+using gosat::kISRES;
+using gosat::kMLSL;
+using gosat::kDirect;
+using gosat::kPortfolio;
+using gosat::kIslands;
+using gosat::kPartition;
+using gosat::kBasinHopping;
+using gosat::kCMAES;
+using gosat::kULPSearch;
 
 llvm::cl::OptionCategory
         SolverCategory("Solver Options", "Options for controlling FPA solver.");
 
 static llvm::cl::opt<std::string>
-        opt_input_file(llvm::cl::Required,
+        opt_input_file(llvm::cl::Optional,
                        "f",
                        llvm::cl::desc("path to smt file"),
                        llvm::cl::value_desc("filename"),
@@ -68,7 +72,16 @@ static llvm::cl::opt<goSATMode>
                                                   "formula analysis"),
                                        clEnumValN(kCCodeGeneration,
                                                   "cg",
-                                                  "C code generation")));
+                                                  "C code generation"),
+                                       clEnumValN(kServer,
+                                                  "server",
+                                                  "Serve formulas read from "
+                                                  "stdin or a socket"),
+                                       clEnumValN(kForkServer,
+                                                  "fork-server",
+                                                  "Serve formulas read from "
+                                                  "stdin, each in a forked "
+                                                  "process")));
 
 static llvm::cl::opt<gosat::LibAPIGenMode>
         opt_api_dump_mode("fmt", llvm::cl::Optional,
@@ -97,7 +110,164 @@ static llvm::cl::opt<goSATAlgorithm>
                                                      "ISRES algorithm"),
                                           clEnumValN(kMLSL,
                                                      "mlsl",
-                                                     "MLSL algorithm")));
+                                                     "MLSL algorithm"),
+                                          clEnumValN(kPortfolio,
+                                                     "portfolio",
+                                                     "Race several algorithms "
+                                                     "in parallel"),
+                                          clEnumValN(kIslands,
+                                                     "islands",
+                                                     "Parallel islands sharing "
+                                                     "their best points"),
+                                          clEnumValN(kPartition,
+                                                     "partition",
+                                                     "Parallel search of "
+                                                     "sub-boxes by sign and "
+                                                     "magnitude"),
+                                          clEnumValN(kBasinHopping,
+                                                     "bh",
+                                                     "Basin hopping with a chain "
+                                                     "per thread"),
+                                          clEnumValN(kCMAES,
+                                                     "cmaes",
+                                                     "CMA-ES with BIPOP restarts "
+                                                     "and parallel evaluation"),
+                                          clEnumValN(kULPSearch,
+                                                     "ulp",
+                                                     "Local search over bit "
+                                                     "patterns with a chain per "
+                                                     "thread")));
+
+static llvm::cl::opt<goSATAlgorithm>
+        opt_partition_algorithm("partition-alg", llvm::cl::Optional,
+                                llvm::cl::desc("Algorithm searching sub-boxes "
+                                               "of -alg=partition:"),
+                                llvm::cl::cat(SolverCategory),
+                                llvm::cl::values(clEnumValN(kDirect,
+                                                            "direct",
+                                                            "Direct algorithm"),
+                                                 clEnumValN(kCRS2,
+                                                            "crs2",
+                                                            "CRS2 algorithm "
+                                                            "(default)"),
+                                                 clEnumValN(kISRES,
+                                                            "isres",
+                                                            "ISRES algorithm"),
+                                                 clEnumValN(kMLSL,
+                                                            "mlsl",
+                                                            "MLSL algorithm")),
+                                llvm::cl::init(kCRS2));
+
+static llvm::cl::opt<unsigned>
+        opt_thread_count("j", llvm::cl::Optional,
+                         llvm::cl::desc("Number of worker threads of parallel "
+                                        "algorithms, batch, and server modes "
+                                        "(default is core count)"),
+                         llvm::cl::value_desc("threads"),
+                         llvm::cl::cat(SolverCategory),
+                         llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned>
+        opt_level("O", llvm::cl::Optional, llvm::cl::Prefix,
+                  llvm::cl::desc("Optimization level of jitted objective "
+                                 "function -O0..-O3 (default -O2)"),
+                  llvm::cl::cat(SolverCategory),
+                  llvm::cl::init(2));
+
+static llvm::cl::opt<bool>
+        opt_jit_report("jit-report", llvm::cl::Optional,
+                       llvm::cl::desc("Report JIT time and evaluation speed "
+                                      "of all optimization levels"),
+                       llvm::cl::cat(SolverCategory),
+                       llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+        opt_use_cache("cache", llvm::cl::Optional,
+                      llvm::cl::desc("Cache jitted objective functions on disk"),
+                      llvm::cl::cat(SolverCategory),
+                      llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+        opt_cache_dir("cache-dir", llvm::cl::Optional,
+                      llvm::cl::desc("Directory of object cache, implies "
+                                     "-cache (default ~/.cache/gosat)"),
+                      llvm::cl::value_desc("directory"),
+                      llvm::cl::cat(SolverCategory));
+
+static llvm::cl::opt<bool>
+        opt_result_cache("result-cache", llvm::cl::Optional,
+                         llvm::cl::desc("Reuse results of formulas equal up "
+                                        "to renaming of variables, stored in "
+                                        "the cache directory"),
+                         llvm::cl::cat(SolverCategory),
+                         llvm::cl::init(false));
+
+static llvm::cl::opt<double>
+        opt_timeout("timeout", llvm::cl::Optional,
+                    llvm::cl::desc("Wall-clock limit per formula in seconds, "
+                                   "the best model found so far is printed "
+                                   "on timeout (default no limit)"),
+                    llvm::cl::value_desc("seconds"),
+                    llvm::cl::cat(SolverCategory),
+                    llvm::cl::init(0));
+
+static llvm::cl::opt<bool>
+        opt_stats("stats", llvm::cl::Optional,
+                  llvm::cl::desc("Print per-phase timings and evaluation "
+                                 "statistics as JSON to stderr"),
+                  llvm::cl::cat(SolverCategory),
+                  llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+        opt_tiered("tiered", llvm::cl::Optional,
+                   llvm::cl::desc("Interpret the objective function while "
+                                  "it is jitted in the background"),
+                   llvm::cl::cat(SolverCategory),
+                   llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+        opt_split("split", llvm::cl::Optional,
+                  llvm::cl::desc("Solve variable-disjoint components of a "
+                                 "conjunction separately and concurrently"),
+                  llvm::cl::cat(SolverCategory),
+                  llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+        opt_infer_bounds("infer-bounds", llvm::cl::Optional,
+                         llvm::cl::desc("Restrict the search box to variable "
+                                        "bounds inferred from the formula"),
+                         llvm::cl::cat(SolverCategory),
+                         llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+        opt_elim_vars("elim-vars", llvm::cl::Optional,
+                      llvm::cl::desc("Eliminate variables defined by "
+                                     "top-level equalities before solving"),
+                      llvm::cl::cat(SolverCategory),
+                      llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+        opt_presolve("presolve", llvm::cl::Optional,
+                     llvm::cl::desc("Presolve stages run in order before "
+                                    "solving, a comma-separated list of "
+                                    "simplify, propagate-values, "
+                                    "ctx-simplify, fp-fold, or all"),
+                     llvm::cl::value_desc("stages"),
+                     llvm::cl::cat(SolverCategory));
+
+static llvm::cl::opt<std::string>
+        opt_batch_path("batch", llvm::cl::Optional,
+                       llvm::cl::desc("Solve all smt files in a directory, or "
+                                      "listed in a file, using -j workers"),
+                       llvm::cl::value_desc("directory|list-file"),
+                       llvm::cl::cat(SolverCategory));
+
+static llvm::cl::opt<std::string>
+        opt_socket_path("socket", llvm::cl::Optional,
+                        llvm::cl::desc("Unix socket served in server mode "
+                                       "(default is stdin/stdout)"),
+                        llvm::cl::value_desc("path"),
+                        llvm::cl::cat(SolverCategory));
 
 static llvm::cl::opt<bool> smtlib_compliant_output(
     "smtlib-output", llvm::cl::cat(SolverCategory),
@@ -110,13 +280,6 @@ void versionPrinter()
               << "Copyright (c) 2017 University of Kaiserslautern\n";
 }
 
-inline float elapsedTimeFrom(std::chrono::steady_clock::time_point& st_time)
-{
-    const auto res = std::chrono::duration_cast<std::chrono::milliseconds>
-            (std::chrono::steady_clock::now() - st_time).count();
-    return static_cast<float>(res) / 1000;
-}
-
 bool isFileExist(const char *fileName)
 {
     std::ifstream infile(fileName);
@@ -125,20 +288,89 @@ bool isFileExist(const char *fileName)
 
 int main(int argc, const char** argv)
 {
+    // handlers run in reverse order, i.e., after those registered by the
+    // solver which wait for background compilations
+    atexit(llvm::llvm_shutdown);
+    atexit(Z3_finalize_memory);
     llvm::cl::SetVersionPrinter(versionPrinter);
     llvm::cl::HideUnrelatedOptions(SolverCategory);
     llvm::cl::ParseCommandLineOptions
             (argc, argv,
              "goSAT v0.1 Copyright (c) 2017 University of Kaiserslautern\n");
 
+    gosat::SolverOptions options;
+    options.Algorithm = opt_go_algorithm;
+    options.PartitionAlgorithm = opt_partition_algorithm;
+    options.ThreadCount = opt_thread_count;
+    options.OptLevel = opt_level;
+    options.ValidateModel = validate_model;
+    options.UseObjectCache = opt_use_cache;
+    options.CacheDir = opt_cache_dir;
+    options.UseResultCache = opt_result_cache;
+    options.PrintJITReport = opt_jit_report;
+    options.Timeout = opt_timeout;
+    options.CollectStatistics = opt_stats;
+    options.UseTieredExecution = opt_tiered;
+    options.SplitComponents = opt_split;
+    options.InferBounds = opt_infer_bounds;
+    options.EliminateVars = opt_elim_vars;
+    if (!opt_presolve.empty() &&
+        !gosat::FPExprPresolver::parseStages(opt_presolve,
+                                             &options.PresolveStages)) {
+        std::cerr << "Invalid presolve stages!" << std::endl;
+        std::exit(1);
+    }
+    if (opt_tool_mode == kServer || opt_tool_mode == kForkServer ||
+        !opt_batch_path.empty()) {
+        unsigned worker_count = (opt_thread_count == 0) ?
+                                std::thread::hardware_concurrency() :
+                                opt_thread_count;
+        worker_count = std::max(worker_count, 1u);
+        // cores are shared among concurrently solved formulas
+        options.ThreadCount = std::max(
+                std::thread::hardware_concurrency() / worker_count, 1u);
+        if (!opt_batch_path.empty()) {
+            std::vector<std::string> files;
+            if (!gosat::FPBatchSolver::collectFiles(opt_batch_path, &files)) {
+                std::cerr << "Batch input does not exists!" << std::endl;
+                std::exit(1);
+            }
+            gosat::FPBatchSolver batch_solver(options, worker_count,
+                                              smtlib_compliant_output);
+            auto summary = batch_solver.solve(files, std::cout);
+            gosat::FPBatchSolver::printSummary(std::cerr, summary);
+            return (summary.ErrorCount == 0) ? 0 : 2;
+        }
+        if (opt_tool_mode == kForkServer) {
+            gosat::FPForkServer fork_server(options, worker_count,
+                                            smtlib_compliant_output);
+            return fork_server.serve(STDIN_FILENO, STDOUT_FILENO);
+        }
+        gosat::FPSolverServer server(options, worker_count,
+                                     smtlib_compliant_output);
+        if (opt_socket_path.empty()) {
+            return server.serveStream(std::cin, std::cout);
+        }
+        return server.serveUnixSocket(opt_socket_path);
+    }
+    if (opt_input_file.empty()) {
+        std::cerr << "No input file given!" << std::endl;
+        std::exit(1);
+    }
     if (!isFileExist(opt_input_file.c_str())) {
         std::cerr << "Input file does not exists!" << std::endl;
         std::exit(1);
     }
     try {
         z3::context smt_ctx;
-        z3::expr smt_expr = smt_ctx.parse_file(opt_input_file.c_str());
         if (opt_tool_mode == kFormulaAnalysis) {
+            z3::expr smt_expr = smt_ctx.parse_file(opt_input_file.c_str());
+            if (!options.PresolveStages.empty()) {
+                gosat::FPExprPresolver presolver(options.PresolveStages);
+                smt_expr = presolver.presolve(smt_expr);
+                gosat::FPExprAnalyzer::prettyPrintPresolveSummary(
+                        presolver.getStageResults());
+            }
             gosat::FPExprAnalyzer analyzer;
             analyzer.analyze(smt_expr);
             analyzer.prettyPrintSummary(
@@ -148,6 +380,7 @@ int main(int argc, const char** argv)
         }
         if (opt_tool_mode == kCCodeGeneration) {
             using namespace gosat;
+            z3::expr smt_expr = smt_ctx.parse_file(opt_input_file.c_str());
             FPExprCodeGenerator code_generator;
             std::string func_name =
                     FPExprCodeGenerator::getFuncNameFrom(opt_input_file);
@@ -170,89 +403,22 @@ int main(int argc, const char** argv)
             }
             return 0;
         }
-        std::chrono::steady_clock::time_point
-                time_start = std::chrono::steady_clock::now();
-        using namespace llvm;
-        std::string func_name = gosat::FPExprCodeGenerator::getFuncNameFrom(
-                opt_input_file);
-
-        // JIT formula to an objective function
-        InitializeNativeTarget();
-        InitializeNativeTargetAsmPrinter();
-        atexit(llvm_shutdown);
-        atexit(Z3_finalize_memory);
-
-        LLVMContext context;
-        std::unique_ptr<Module> module = std::make_unique<Module>(
-                StringRef(func_name), context);
-        gosat::FPIRGenerator ir_gen(&context, module.get());
-        auto ll_func_ptr = ir_gen.genFunction(smt_expr);
-        std::string err_str;
-        std::unique_ptr<ExecutionEngine> exec_engine(
-                EngineBuilder(std::move(module))
-                        .setEngineKind(EngineKind::JIT)
-                        .setOptLevel(CodeGenOpt::Less)
-                        .setErrorStr(&err_str)
-                        .create());
-        if (exec_engine == nullptr) {
-            std::cerr << func_name << ": Failed to construct ExecutionEngine: "
-                      << err_str
-                      << "\n";
-            return 1;
-        }
-        ir_gen.addGlobalFunctionMappings(exec_engine.get());
-        exec_engine->finalizeObject();
-        auto func_ptr = reinterpret_cast<nlopt_func>(exec_engine->
-                getPointerToFunction(ll_func_ptr));
-
-        // Now working with optimization backend
-        goSATAlgorithm current_alg =
-                (opt_go_algorithm == kUndefinedAlg) ? kCRS2 : opt_go_algorithm;
-
-        gosat::NLoptOptimizer nl_opt(static_cast<nlopt_algorithm>(current_alg));
-        int status = 0;
-        double minima = 1.0; /* minimum getValue */
-        std::vector<double> model_vec(ir_gen.getVarCount(), 0.0);
-        if (ir_gen.getVarCount() == 0) {
-            // const function
-            minima = (func_ptr)(0, nullptr, nullptr, nullptr);
-        } else {
-            status = nl_opt.optimize(func_ptr,
-                                     static_cast<unsigned>(model_vec.size()),
-                                     model_vec.data(),
-                                     &minima);
-        }
-        if (ir_gen.isFoundUnsupportedSMTExpr()) {
-            std::cout<< "unsupported\n";
-
-        }
-        std::string result = (minima == 0 && !ir_gen.isFoundUnsupportedSMTExpr())
-                             ? "sat" : "unknown";
-        if (smtlib_compliant_output) {
-            std::cout << result << std::endl;
-        } else {
-            if (status < 0) {
-                std::cout << std::setprecision(4);
-                std::cout << func_name << "," << result << ","
-                          << elapsedTimeFrom(time_start)
-                          << ",INF," << status;
-            } else {
-                std::cout << std::setprecision(4);
-                std::cout << func_name << "," << result << ",";
-                std::cout << elapsedTimeFrom(time_start) << ",";
-                std::cout << std::setprecision(dbl::digits10) << minima << ","
-                          << status;
-            }
-            if (minima == 0 && validate_model) {
-                gosat::ModelValidator validator(&ir_gen);
-                if (validator.isValid(smt_expr, model_vec)) {
-                    std::cout << ",valid";
-                } else {
-                    std::cout << ",invalid";
-                }
-            }
+        gosat::FPSolver solver(options);
+        // parsing is timed by the solver
+        gosat::SolverResult result = solver.solveFile(smt_ctx, opt_input_file);
+        // one status line per worker, stdout is kept for the result
+        gosat::FPSolver::printWorkerResults(std::cerr, result);
+        gosat::FPSolver::printResult(std::cout, result,
+                                     smtlib_compliant_output);
+        std::cout << std::endl;
+        if (result.IsTimedOut && !smtlib_compliant_output) {
+            gosat::FPSolver::printModel(std::cout, result);
             std::cout << std::endl;
         }
+        if (opt_stats) {
+            gosat::FPSolver::printStatistics(std::cerr, result);
+            std::cerr << std::endl;
+        }
     } catch (const z3::exception &exp) {
         std::cerr << "Error occurred while processing your input: "
                   << exp.msg() << std::endl;
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Compares global optimization algorithms of goSAT on a fixed corpus.
+#
+# Every SMT file of the corpus is solved once per algorithm using the same
+# timeout and thread count. Formulas are solved one after another, hence,
+# times are not skewed by concurrently running formulas.
+#
+# Usage: alg_bench.sh <gosat> <corpus-dir> [timeout] [threads] [algorithm]...
+# Algorithms default to crs2, isres, and cmaes.
+# Output is csv: algorithm,formulas,sat,sat rate,total time (sec),
+# mean time of sat formulas (sec)
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <gosat> <corpus-dir> [timeout] [threads] [algorithm]..." >&2
+    exit 1
+fi
+gosat=$1
+corpus=$2
+timeout=${3:-60}
+threads=${4:-0}
+shift $(( $# < 4 ? $# : 4 ))
+algorithms=${*:-"crs2 isres cmaes"}
+
+echo "algorithm,formulas,sat,sat rate,total time,mean sat time"
+for alg in $algorithms; do
+    find "$corpus" -name '*.smt2' | sort | while read -r file; do
+        "$gosat" -alg="$alg" -timeout="$timeout" -j "$threads" -f "$file" \
+            2>/dev/null
+    done | awk -F, -v alg="$alg" '
+        $2 == "sat" || $2 == "unknown" {
+            ++count; total += $3
+            if ($2 == "sat") { ++sat; sat_time += $3 }
+        }
+        END {
+            printf "%s,%d,%d,%.3f,%.3f,%.3f\n", alg, count, sat,
+                   (count > 0) ? sat / count : 0, total,
+                   (sat > 0) ? sat_time / sat : 0
+        }'
+done
@@ -0,0 +1,173 @@
+//===------------------------------------------------------------*- C++ -*-===//
+//
+// This file is distributed under MIT License. See LICENSE.txt for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Copyright (c) 2017 University of Kaiserslautern.
+//
+
+#include "IRGen/FPIRGenerator.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+/*
+ * Measures IR generation time and memory on synthetic deep formulas.
+ *
+ * - and-chain: a left-deep conjunction of depth n over fp.lt constraints
+ *   sharing two variables.
+ * - add-chain: fp.lt(x + c_1 + ... + c_n, y), i.e., an arithmetic term
+ *   of depth n.
+ * - shared-chain: a conjunction of fp.lt(t_i, y) where t_i = t_(i-1) + c_i,
+ *   i.e., every constraint shares the term of its preceding sibling.
+ *
+ * IR of every shape is checked against IR of the recursive traversal,
+ * see FPIRGenerator::genFunctionRecursive, at a depth of at most
+ * kMaxCheckDepth since recursion overflows the stack beyond.
+ *
+ * Usage: irgen_bench [depth]...
+ * Output is csv: shape,depth,irgen time (sec),peak rss (KB),
+ * rss growth during IR generation (KB),IR equal to recursive (yes/no).
+ * Exits with 1 if IR of any shape differs.
+ */
+
+static const unsigned kMaxCheckDepth = 2000;
+
+static long getPeakRSS()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static z3::expr genAndChain(z3::context& ctx, unsigned depth)
+{
+    Z3_sort fp64 = Z3_mk_fpa_sort_double(ctx);
+    z3::expr x = ctx.constant("x", z3::sort(ctx, fp64));
+    z3::expr y = ctx.constant("y", z3::sort(ctx, fp64));
+    z3::expr rm = z3::expr(ctx, Z3_mk_fpa_rne(ctx));
+    z3::expr result = ctx.bool_val(true);
+    for (unsigned i = 0; i < depth; ++i) {
+        z3::expr c(ctx, Z3_mk_fpa_numeral_double(ctx, i, fp64));
+        z3::expr sum(ctx, Z3_mk_fpa_add(ctx, rm, x, c));
+        z3::expr lt(ctx, Z3_mk_fpa_lt(ctx, sum, y));
+        result = result && lt;
+    }
+    return result;
+}
+
+static z3::expr genAddChain(z3::context& ctx, unsigned depth)
+{
+    Z3_sort fp64 = Z3_mk_fpa_sort_double(ctx);
+    z3::expr x = ctx.constant("x", z3::sort(ctx, fp64));
+    z3::expr y = ctx.constant("y", z3::sort(ctx, fp64));
+    z3::expr rm = z3::expr(ctx, Z3_mk_fpa_rne(ctx));
+    z3::expr term = x;
+    for (unsigned i = 0; i < depth; ++i) {
+        z3::expr c(ctx, Z3_mk_fpa_numeral_double(ctx, i + 1, fp64));
+        term = z3::expr(ctx, Z3_mk_fpa_add(ctx, rm, term, c));
+    }
+    return z3::expr(ctx, Z3_mk_fpa_lt(ctx, term, y));
+}
+
+static z3::expr genSharedChain(z3::context& ctx, unsigned depth)
+{
+    Z3_sort fp64 = Z3_mk_fpa_sort_double(ctx);
+    z3::expr x = ctx.constant("x", z3::sort(ctx, fp64));
+    z3::expr y = ctx.constant("y", z3::sort(ctx, fp64));
+    z3::expr rm = z3::expr(ctx, Z3_mk_fpa_rne(ctx));
+    z3::expr term = x;
+    z3::expr_vector constraints(ctx);
+    for (unsigned i = 0; i < depth; ++i) {
+        z3::expr c(ctx, Z3_mk_fpa_numeral_double(ctx, i + 1, fp64));
+        term = z3::expr(ctx, Z3_mk_fpa_add(ctx, rm, term, c));
+        constraints.push_back(z3::expr(ctx, Z3_mk_fpa_lt(ctx, term, y)));
+    }
+    return z3::mk_and(constraints);
+}
+
+static z3::expr
+genShape(z3::context& ctx, const std::string& shape, unsigned depth)
+{
+    if (shape == "and-chain") {
+        return genAndChain(ctx, depth);
+    }
+    if (shape == "add-chain") {
+        return genAddChain(ctx, depth);
+    }
+    return genSharedChain(ctx, depth);
+}
+
+static std::string genIR(const z3::expr& smt_expr, bool is_recursive)
+{
+    llvm::LLVMContext context;
+    llvm::Module module("irgen_bench", context);
+    gosat::FPIRGenerator ir_gen(&context, &module);
+    if (is_recursive) {
+        ir_gen.genFunctionRecursive(smt_expr);
+    } else {
+        ir_gen.genFunction(smt_expr);
+    }
+    std::string ir_str;
+    llvm::raw_string_ostream ir_stream(ir_str);
+    module.print(ir_stream, nullptr);
+    return ir_stream.str();
+}
+
+/// compares IR of both traversals on shape of at most kMaxCheckDepth
+static bool isEqualToRecursive(const std::string& shape, unsigned depth)
+{
+    z3::context smt_ctx;
+    const z3::expr smt_expr = genShape(smt_ctx, shape,
+                                       std::min(depth, kMaxCheckDepth));
+    return genIR(smt_expr, false) == genIR(smt_expr, true);
+}
+
+static bool runBenchmark(const std::string& shape, unsigned depth)
+{
+    z3::context smt_ctx;
+    z3::expr smt_expr = genShape(smt_ctx, shape, depth);
+    llvm::LLVMContext context;
+    auto module = std::make_unique<llvm::Module>(shape, context);
+    const long rss_before = getPeakRSS();
+    auto time_start = std::chrono::steady_clock::now();
+    {
+        gosat::FPIRGenerator ir_gen(&context, module.get());
+        ir_gen.genFunction(smt_expr);
+    }
+    const double irgen_time = std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - time_start).count();
+    const long rss_after = getPeakRSS();
+    const bool is_equal = isEqualToRecursive(shape, depth);
+    std::cout << std::setprecision(4);
+    std::cout << shape << "," << depth << "," << irgen_time << ","
+              << rss_after << "," << rss_after - rss_before << ","
+              << (is_equal ? "yes" : "no") << std::endl;
+    return is_equal;
+}
+
+int main(int argc, const char** argv)
+{
+    std::vector<unsigned> depths;
+    for (int i = 1; i < argc; ++i) {
+        depths.push_back(static_cast<unsigned>(std::strtoul(argv[i], nullptr,
+                                                            10)));
+    }
+    if (depths.empty()) {
+        depths = {10000, 100000, 500000};
+    }
+    bool is_equal = true;
+    for (const auto depth : depths) {
+        for (const auto shape : {"and-chain", "add-chain", "shared-chain"}) {
+            is_equal = runBenchmark(shape, depth) && is_equal;
+        }
+    }
+    return (is_equal) ? 0 : 1;
+}
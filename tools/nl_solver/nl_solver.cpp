@@ -8,11 +8,15 @@
 //
 
 #include "GOFuncsMap.h"
+#include "Optimizer/BasinHoppingOptimizer.h"
 #include "Optimizer/NLoptOptimizer.h"
 #include <iostream>
 #include <iomanip>
 #include <limits>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
 
 typedef std::numeric_limits<double> dbl;
 
@@ -23,7 +27,7 @@ inline float elapsedTimeFrom(std::chrono::steady_clock::time_point& st_time)
     return static_cast<float>(res) / 1000;
 }
 
-int main()
+int main(int argc, const char** argv)
 {
     /*
      * The following global optimization algorithms seem to give the best
@@ -36,6 +40,13 @@ int main()
      *
      */
     gosat::NLoptOptimizer opt(NLOPT_GN_CRS2_LM);
+    // "nl_solver bh [seconds]" solves using basin hopping with a chain per
+    // core, each formula is limited to 600 seconds by default like the
+    // former bh_solver
+    const bool is_basin_hopping = (argc > 1 && std::strcmp(argv[1], "bh") == 0);
+    gosat::BasinHoppingOptimizer bh_opt(std::thread::hardware_concurrency());
+    bh_opt.Config.MaxTime = (is_basin_hopping && argc > 2) ?
+                            std::strtod(argv[2], nullptr) : 600;
     gosat::GOFuncsMap func_map;
     int status = 0;
     for (const auto& entry: func_map.getFuncMap()) {
@@ -45,7 +56,9 @@ int main()
         const auto dim = entry.second.second;
         std::vector<double> x(dim, 0.0);
         double minima = 1.0; /* minimum getValue */
-        status = opt.optimize(func, dim, x.data(), &minima);
+        status = (is_basin_hopping) ?
+                 bh_opt.optimize(func, dim, x.data(), &minima) :
+                 opt.optimize(func, dim, x.data(), &minima);
         if (status < 0) {
             std::cout << std::setprecision(4);
             std::cout << entry.first << ",error,"